@@ -0,0 +1,488 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../include/lexer.hpp"
+#include "../include/parser.hpp"
+#include "../include/semantic.hpp"
+#include "../include/compiler.hpp"
+#include "../include/assembler.hpp"
+
+/*
+============================================================
+  muyagabj_bench
+  --------------------------------
+  Compiles generated MuyagaLang programs in process and
+  reports lines per second for each pass and overall.
+  Programs come from a fixed-seed Mersenne Twister and follow
+  grammer.md (locals of every type, while, if/else, print,
+  alloc/free, calls with matching arguments), so every run
+  compiles exactly the same source.
+
+  The link is left out: the image must end below HEAP_START,
+  which a program of the sizes measured here never does.
+
+  Usage: muyagabj_bench [--lines N] [--repeat N] [-j threads] [-O0]
+============================================================
+*/
+
+using Clock = std::chrono::steady_clock;
+
+enum class Kind
+{
+    Int,
+    Char,
+    String,
+    Void
+};
+
+struct Signature
+{
+    std::string name;
+    Kind result;
+    std::vector<Kind> params;
+};
+
+/*------------------------------------------------------------
+  Program generator. Only rng() itself is used (no
+  std::*_distribution), since the distributions are
+  implementation-defined while mt19937's output is not.
+------------------------------------------------------------*/
+class ProgramGenerator
+{
+public:
+    explicit ProgramGenerator(std::mt19937 &rng) : rng(rng) {}
+
+    std::string generate(size_t targetLines)
+    {
+        text.clear();
+        lines = 0;
+        functions.clear();
+        while (lines < targetLines)
+        {
+            function();
+        }
+        locals.clear();
+        text += "func main() {\n";
+        for (size_t i = 0; i < functions.size(); i += 1 + functions.size() / 8)
+        {
+            text += "    " + call(functions[i]) + ";\n";
+        }
+        text += "}\n";
+        return text;
+    }
+
+private:
+    struct Local
+    {
+        std::string name;
+        Kind kind;
+    };
+
+    std::mt19937 &rng;
+    std::string text;
+    size_t lines = 0;
+    std::vector<Signature> functions;
+    std::vector<Local> locals;
+    uint32_t nextLocal = 0;
+    uint32_t nextString = 0;
+
+    uint32_t pick(uint32_t n) { return static_cast<uint32_t>(rng() % n); }
+
+    void line(int indent, const std::string &code)
+    {
+        text.append(static_cast<size_t>(indent) * 4, ' ');
+        text += code;
+        text += '\n';
+        ++lines;
+    }
+
+    static const char *typeName(Kind kind)
+    {
+        switch (kind)
+        {
+        case Kind::Int:
+            return "int";
+        case Kind::Char:
+            return "char";
+        case Kind::String:
+            return "string";
+        default:
+            return "void";
+        }
+    }
+
+    const Local *randomLocal(bool string)
+    {
+        size_t count = 0;
+        for (const Local &local : locals)
+        {
+            count += (local.kind == Kind::String) == string;
+        }
+        if (count == 0)
+            return nullptr;
+        size_t index = pick(static_cast<uint32_t>(count));
+        for (const Local &local : locals)
+        {
+            if ((local.kind == Kind::String) == string && index-- == 0)
+                return &local;
+        }
+        return nullptr;
+    }
+
+    const Signature *randomFunction(bool string)
+    {
+        if (functions.empty())
+            return nullptr;
+        const Signature &callee = functions[pick(static_cast<uint32_t>(functions.size()))];
+        if (callee.result == Kind::Void || (callee.result == Kind::String) != string)
+            return nullptr;
+        return &callee;
+    }
+
+    std::string call(const Signature &callee)
+    {
+        std::string code = callee.name + "(";
+        for (size_t i = 0; i < callee.params.size(); ++i)
+        {
+            code += (i ? ", " : "") + (callee.params[i] == Kind::String ? stringExpression(1) : numberExpression(1));
+        }
+        return code + ")";
+    }
+
+    std::string numberExpression(int depth)
+    {
+        static const char *const operators[] = {"+", "-", "*", "/", "<", ">", "<=", ">=", "==", "!="};
+        uint32_t choice = depth >= 3 ? pick(3) : pick(8);
+        switch (choice)
+        {
+        case 0:
+            return std::to_string(pick(100));
+        case 1:
+        {
+            const Local *local = randomLocal(false);
+            return local ? local->name : std::to_string(pick(10));
+        }
+        case 2:
+            return std::string("'") + static_cast<char>('a' + pick(26)) + "'";
+        case 3:
+            return "-" + numberExpression(3); // unary minus takes a primary
+        case 4:
+            return "(" + numberExpression(depth + 1) + ")";
+        case 5:
+        {
+            const Signature *callee = randomFunction(false);
+            if (callee)
+                return call(*callee);
+            [[fallthrough]];
+        }
+        default:
+            return numberExpression(depth + 1) + " " + operators[pick(10)] + " " + numberExpression(depth + 1);
+        }
+    }
+
+    std::string stringExpression(int depth)
+    {
+        switch (pick(5))
+        {
+        case 0:
+        {
+            const Local *local = randomLocal(true);
+            if (local)
+                return local->name;
+            [[fallthrough]];
+        }
+        case 1:
+            return "\"s" + std::to_string(nextString++ % 64) + "\"";
+        case 2:
+            return "alloc(" + numberExpression(depth + 1) + ")";
+        case 3:
+        {
+            const Signature *callee = depth < 2 ? randomFunction(true) : nullptr;
+            if (callee)
+                return call(*callee);
+            [[fallthrough]];
+        }
+        default:
+        {
+            const Local *local = randomLocal(false);
+            return local ? "&" + local->name : "\"t\"";
+        }
+        }
+    }
+
+    std::string expression(Kind kind)
+    {
+        return kind == Kind::String ? stringExpression(0) : numberExpression(0);
+    }
+
+    std::string declare(Kind kind)
+    {
+        std::string name = "v" + std::to_string(nextLocal++);
+        std::string code = (pick(4) == 0 ? std::string("let") : typeName(kind)) + " " + name + " = " + expression(kind) + ";";
+        locals.push_back({name, kind});
+        return code;
+    }
+
+    void block(int indent, int depth)
+    {
+        size_t scope = locals.size();
+        uint32_t count = 2 + pick(depth == 1 ? 8 : 4);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            statement(indent, depth);
+        }
+        locals.resize(scope);
+    }
+
+    void statement(int indent, int depth)
+    {
+        uint32_t choice = pick(depth < 3 ? 10 : 7);
+        switch (choice)
+        {
+        case 0:
+        case 1:
+            line(indent, declare(static_cast<Kind>(pick(3))));
+            break;
+        case 2:
+        {
+            const Local *local = randomLocal(pick(3) == 0);
+            if (local)
+                line(indent, local->name + " = " + expression(local->kind) + ";");
+            else
+                line(indent, declare(Kind::Int));
+            break;
+        }
+        case 3:
+            line(indent, "print(" + expression(static_cast<Kind>(pick(3))) + ");");
+            break;
+        case 4:
+        {
+            const Local *local = randomLocal(true);
+            if (local)
+                line(indent, "free(" + local->name + ");");
+            else
+                line(indent, "print(" + stringExpression(0) + ");");
+            break;
+        }
+        case 5:
+        case 6:
+        {
+            if (!functions.empty())
+                line(indent, call(functions[pick(static_cast<uint32_t>(functions.size()))]) + ";");
+            else
+                line(indent, declare(Kind::Char));
+            break;
+        }
+        case 7:
+        case 8:
+        {
+            line(indent, "if (" + numberExpression(1) + ") {");
+            block(indent + 1, depth + 1);
+            if (pick(2))
+            {
+                line(indent, "} else {");
+                block(indent + 1, depth + 1);
+            }
+            line(indent, "}");
+            break;
+        }
+        default:
+        {
+            // A counted loop, so the program would also terminate if run
+            std::string counter = "k" + std::to_string(nextLocal++);
+            line(indent, "int " + counter + " = 0;");
+            line(indent, "while (" + counter + " < " + std::to_string(2 + pick(6)) + ") {");
+            locals.push_back({counter, Kind::Int});
+            block(indent + 1, depth + 1);
+            line(indent + 1, counter + " = " + counter + " + 1;");
+            line(indent, "}");
+            break;
+        }
+        }
+    }
+
+    void function()
+    {
+        Signature signature;
+        signature.name = "f" + std::to_string(functions.size());
+        signature.result = static_cast<Kind>(pick(4));
+        locals.clear();
+        nextLocal = 0;
+        std::string header = "func " + std::string(typeName(signature.result)) + " " + signature.name + "(";
+        uint32_t paramCount = pick(5);
+        for (uint32_t i = 0; i < paramCount; ++i)
+        {
+            Kind kind = static_cast<Kind>(pick(3));
+            std::string name = "p" + std::to_string(i);
+            header += (i ? ", " : "") + std::string(typeName(kind)) + " " + name;
+            signature.params.push_back(kind);
+            locals.push_back({name, kind});
+        }
+        line(0, header + ") {");
+        block(1, 1);
+        if (signature.result != Kind::Void)
+            line(1, "return " + expression(signature.result) + ";");
+        line(0, "}");
+        functions.push_back(signature); // only later functions call it
+    }
+};
+
+/*----- Helper: bestSeconds() -----*/
+static double bestSeconds(size_t repeat, const std::function<void()> &run)
+{
+    double best = 1e300;
+    for (size_t i = 0; i < repeat; ++i)
+    {
+        auto start = Clock::now();
+        run();
+        best = std::min(best, std::chrono::duration<double>(Clock::now() - start).count());
+    }
+    return best;
+}
+
+struct PassTimes
+{
+    double lex = 1e300;
+    double parse = 1e300; // includes lexing: the parser pulls tokens
+    double declare = 1e300;
+    double compile = 1e300; // resolve, fold, generate, allocate and assemble every function
+    size_t functions = 0;
+    uint64_t bytes = 0;
+};
+
+/*----- Helper: compileOnce() -----*/
+// The whole front end and per-function compile, each pass timed on its own
+static void compileOnce(const std::string &source, const CompileOptions &options, PassTimes &times)
+{
+    times.lex = std::min(times.lex, bestSeconds(1, [&]
+    {
+        Lexer sweep(source);
+        while (sweep.nextToken().type != TokenType::EndOfFile)
+        {
+        }
+    }));
+
+    Lexer lexer(source);
+    AstArena ast;
+    NodeIndex program = NO_NODE;
+    times.parse = std::min(times.parse, bestSeconds(1, [&]
+    {
+        Parser parser(lexer, ast);
+        program = parser.parseProgram();
+    }));
+
+    StringInterner names;
+    SymbolTable symbols;
+    Resolver resolver(ast, source, names, symbols);
+    std::vector<FunctionInfo> functions;
+    times.declare = std::min(times.declare, bestSeconds(1, [&] { functions = resolver.declareFunctions(program); }));
+
+    std::vector<MachineFunction> machineCode;
+    times.compile = std::min(times.compile, bestSeconds(1, [&]
+    {
+        machineCode = compileFunctions(ast, source, names, symbols, functions, options);
+    }));
+
+    times.functions = functions.size();
+    times.bytes = 0;
+    for (const MachineFunction &function : machineCode)
+    {
+        times.bytes += function.bytes.size();
+    }
+}
+
+static double linesPerSecond(size_t lines, double seconds)
+{
+    return seconds > 0 ? lines / seconds : 0;
+}
+
+// A decimal number of up to nine digits; false for anything else
+static bool parseNumber(const std::string &text, size_t &value)
+{
+    if (text.empty() || text.size() > 9 || text.find_first_not_of("0123456789") != std::string::npos)
+        return false;
+    value = std::stoul(text);
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t maxLines = 100000;
+    size_t repeat = 3;
+    CompileOptions options;
+    options.threads = 1;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string flag = argv[i];
+        size_t value = 0;
+        bool numbered = (flag == "--lines" || flag == "--repeat" || flag == "-j") && i + 1 < argc &&
+                        parseNumber(argv[++i], value);
+        if (flag == "--lines" && numbered)
+            maxLines = std::max<size_t>(100, value);
+        else if (flag == "--repeat" && numbered)
+            repeat = std::max<size_t>(1, value);
+        else if (flag == "-j" && numbered && value <= 9999)
+            options.threads = value ? static_cast<unsigned>(value) : std::max(1u, std::thread::hardware_concurrency());
+        else if (flag == "-O0")
+            options.codegen.optimize = false;
+        else
+        {
+            std::cerr << "Usage: muyagabj_bench [--lines N] [--repeat N] [-j threads] [-O0]\n";
+            return 2;
+        }
+    }
+
+    // Sizes grow tenfold up to --lines, so the per-line cost can be seen to stay flat
+    std::vector<size_t> sizes;
+    for (size_t size = maxLines; size >= 100 && sizes.size() < 3; size /= 10)
+    {
+        sizes.insert(sizes.begin(), size);
+    }
+
+    std::cout << "threads " << options.threads << (options.codegen.optimize ? ", optimizing" : ", -O0")
+              << ", best of " << repeat << "\n";
+    std::cout << std::right << std::setw(10) << "lines" << std::setw(11) << "functions" << std::setw(11) << "bytes"
+              << std::setw(12) << "lex" << std::setw(12) << "parse" << std::setw(12) << "declare" << std::setw(12)
+              << "compile" << std::setw(12) << "overall" << "   (klines/s)\n";
+
+    for (size_t size : sizes)
+    {
+        std::mt19937 rng(20261017);
+        ProgramGenerator generator(rng);
+        std::string source = generator.generate(size);
+        size_t lines = static_cast<size_t>(std::count(source.begin(), source.end(), '\n'));
+
+        PassTimes times;
+        try
+        {
+            for (size_t i = 0; i < repeat; ++i)
+            {
+                compileOnce(source, options, times);
+            }
+        }
+        catch (const std::runtime_error &e)
+        {
+            std::cerr << "generated program of " << lines << " lines does not compile:" << e.what() << "\n";
+            return 1;
+        }
+
+        // The parse includes its own lexing, so the lex sweep is not added again
+        double overall = times.parse + times.declare + times.compile;
+        std::cout << std::setw(10) << lines << std::setw(11) << times.functions << std::setw(11) << times.bytes
+                  << std::fixed << std::setprecision(1)
+                  << std::setw(12) << linesPerSecond(lines, times.lex) / 1e3
+                  << std::setw(12) << linesPerSecond(lines, times.parse) / 1e3
+                  << std::setw(12) << linesPerSecond(lines, times.declare) / 1e3
+                  << std::setw(12) << linesPerSecond(lines, times.compile) / 1e3
+                  << std::setw(12) << linesPerSecond(lines, overall) / 1e3 << "\n";
+    }
+}
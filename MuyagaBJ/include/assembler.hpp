@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "codegen.hpp"
+
+// -----------------------------
+// Relocatable machine code
+// -----------------------------
+
+// Operand bytes the linker fills in once addresses are known
+enum class RelocKind : uint8_t
+{
+    Code,     // 2 bytes: address of byte value of this function (jumps)
+    Function, // 2 bytes: address of function value
+    Runtime,  // 2 bytes: address of RuntimeRoutine value
+    Frame,    // 2 bytes: address of byte value of this function's frame
+    FrameLo,  // 1 byte each: low / high byte of that address
+    FrameHi,
+    StringLo, // 1 byte each: low / high byte of the address of string value
+    StringHi,
+    StackCheck, // 1 byte: this function's stack need less one (linker.hpp)
+};
+
+struct Relocation
+{
+    uint32_t offset; // of the operand in MachineFunction::bytes
+    RelocKind kind;
+    uint32_t value;
+};
+
+// One function encoded as position-independent bytes plus fix-ups
+struct MachineFunction
+{
+    std::vector<uint8_t> bytes;
+    std::vector<Relocation> relocations;
+    std::vector<std::string> strings; // literals referenced by StringLo / StringHi
+    uint32_t frameSize = 0;
+    uint32_t savedBytes = 0; // pushed by the prologue
+    bool recursive = false;  // its calls are cut from the link's stack check (linker.hpp)
+};
+
+/**
+ * Encode an instruction list. Branches whose target is out of the signed
+ * 8-bit range become the opposite branch over a JMP.
+ */
+MachineFunction assembleFunction(const FunctionCode &function);
+
+/**
+ * Number of instructions in a function's code, found by decoding it.
+ */
+uint32_t instructionCount(const MachineFunction &function);
@@ -0,0 +1,143 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// -----------------------------
+// Arena AST
+// -----------------------------
+
+/*
+  Every node of a compilation lives in one AstArena and refers to its
+  children by 32-bit index, so the tree is a dense array of fixed-size
+  records: no per-node allocation, children close to their parents, and
+  the whole tree released at once with the arena. Index 0 is a sentinel
+  (NO_NODE), as is list 0 (the empty list).
+
+  Variable-length children (functions, parameters, statements, arguments)
+  are stored in a side array as [count, item, item, ...]; a node holds the
+  index of the count.
+*/
+
+using NodeIndex = uint32_t;
+using ListIndex = uint32_t;
+
+constexpr NodeIndex NO_NODE = 0;
+constexpr ListIndex EMPTY_LIST = 0;
+
+enum class NodeKind : uint8_t
+{
+    None,
+
+    // Declarations
+    Program,  // a: functions
+    Function, // type: return type; a: name (Identifier); b: parameters; c: body (Block)
+    Param,    // type; a: name (Identifier)
+
+    // Statements
+    Block,    // a: statements
+    VarDecl,  // type (Inferred for let); a: name (Identifier); b: initializer
+    Assign,   // a: target (Identifier); b: value
+    Return,   // a: value or NO_NODE
+    While,    // a: condition; b: body (Block)
+    If,       // a: condition; b: then (Block); c: else (Block) or NO_NODE
+    Print,    // a: value
+    Free,     // a: pointer (Identifier)
+    ExprStmt, // a: expression
+
+    // Expressions
+    Number,     // a: value
+    CharLit,    // a: character code
+    StringLit,  // a, b: offset and length of the contents in the source
+    Identifier, // a, b: offset and length of the name in the source
+    Call,       // a: callee (Identifier); b: arguments
+    Alloc,      // a: size
+    Unary,      // op; a: operand
+    Binary,     // op; a: left; b: right
+};
+
+enum class ValueType : uint8_t
+{
+    None,
+    Void,
+    Int,
+    Char,
+    String,
+    Inferred, // declared with let; resolved by the semantic pass
+};
+
+enum class Operator : uint8_t
+{
+    None,
+    Add,
+    Sub,
+    Mul,
+    Div,
+    Equal,
+    NotEqual,
+    Less,
+    LessEqual,
+    Greater,
+    GreaterEqual,
+    Negate,
+    AddressOf,
+};
+
+// 20 bytes; the meaning of a, b and c depends on kind (see NodeKind)
+struct AstNode
+{
+    NodeKind kind = NodeKind::None;
+    Operator op = Operator::None;
+    ValueType type = ValueType::None;
+    uint8_t flags = 0;
+    uint32_t a = 0;
+    uint32_t b = 0;
+    uint32_t c = 0;
+    uint32_t offset = 0; // source offset of the node's first token, for diagnostics
+};
+static_assert(sizeof(AstNode) == 20, "AstNode should stay compact");
+
+// A view of one list in the arena
+struct NodeList
+{
+    const NodeIndex *items;
+    uint32_t count;
+
+    const NodeIndex *begin() const { return items; }
+    const NodeIndex *end() const { return items + count; }
+    NodeIndex operator[](uint32_t i) const { return items[i]; }
+};
+
+class AstArena
+{
+public:
+    AstArena();
+
+    NodeIndex addNode(const AstNode &node);
+    ListIndex addList(const NodeIndex *items, size_t count);
+
+    AstNode &node(NodeIndex index) { return nodes[index]; }
+    const AstNode &node(NodeIndex index) const { return nodes[index]; }
+    NodeList list(ListIndex index) const
+    {
+        return {lists.data() + index + 1, lists[index]};
+    }
+
+    size_t nodeCount() const { return nodes.size() - 1; }
+    void reserve(size_t nodeCount);
+
+private:
+    std::vector<AstNode> nodes;
+    std::vector<NodeIndex> lists;
+};
+
+const char *nodeKindName(NodeKind kind);
+const char *valueTypeName(ValueType type);
+const char *operatorName(Operator op);
+
+/**
+ * Print the tree below root, one node per line, indented by depth. Source
+ * text (names, strings) is read from source.
+ */
+std::string dumpAst(const AstArena &ast, NodeIndex root, std::string_view source);
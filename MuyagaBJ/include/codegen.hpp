@@ -0,0 +1,113 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "ast.hpp"
+#include "isa.hpp"
+#include "semantic.hpp"
+#include "symbol_table.hpp"
+
+// -----------------------------
+// Instruction list
+// -----------------------------
+
+// What an instruction's operand refers to; everything but Immediate and
+// Fixed is only known once the program is linked
+enum class OperandKind : uint8_t
+{
+    None,
+    Immediate, // value
+    Fixed,     // absolute address value (the runtime locations in isa.hpp)
+    Frame,     // byte value of this function's frame
+    FrameLo,   // immediate: low / high byte of the address of frame byte value (&x)
+    FrameHi,
+    StringLo, // immediate: low / high byte of the address of string literal value
+    StringHi,
+    StackCheck, // immediate: stack this function needs below its return address, less one
+    Label,    // branch or jump target inside this function
+    Function, // JSR target: function index
+    Runtime,  // JSR target: RuntimeRoutine
+};
+
+struct Operand
+{
+    OperandKind kind = OperandKind::None;
+    uint32_t value = 0;
+
+    bool operator==(const Operand &other) const { return kind == other.kind && value == other.value; }
+    bool operator!=(const Operand &other) const { return !(*this == other); }
+};
+
+struct Instr
+{
+    Op op;
+    Operand operand;
+};
+
+// Helpers linked in when a function uses them
+enum class RuntimeRoutine : uint32_t
+{
+    Multiply, // A = MUL_LEFT * MUL_RIGHT
+    Divide,   // A = MUL_LEFT / MUL_RIGHT (0 when dividing by zero)
+    StackOverflow, // prints "stack overflow" and stops; never returns
+    Count,
+};
+
+/**
+ * Name of a runtime routine in listings: __mul, __div, __stack_overflow.
+ */
+const char *runtimeName(RuntimeRoutine routine);
+
+// One function after code generation, before assembly
+struct FunctionCode
+{
+    std::vector<Instr> code;
+    std::vector<std::string_view> strings; // literals, indexed by StringLo/StringHi operands
+    uint32_t frameSize = 0;
+    uint32_t savedBytes = 0; // pushed by the prologue
+    bool recursive = false;
+};
+
+struct CodegenOptions
+{
+    bool optimize = true; // constant folding and the peephole pass
+};
+
+/**
+ * Fold constant subexpressions of one function in place: arithmetic on
+ * literals (modulo 256, like the machine), comparisons of literals, and the
+ * identities x+0, x-0, x*1, x/1 and x*0 (when x has no calls).
+ */
+void foldConstants(AstArena &ast, NodeIndex function);
+
+/**
+ * Lower one resolved function to an instruction list.
+ */
+FunctionCode generateFunction(const AstArena &ast, const SymbolTable &symbols, std::string_view source,
+                              const FunctionInfo &function, const CodegenOptions &options);
+
+/**
+ * Instruction list of a runtime routine.
+ */
+FunctionCode generateRuntime(RuntimeRoutine routine);
+
+/**
+ * Rewrite an instruction list in place until no rule applies:
+ *   - a load of what A already holds (after STA m or LDA m), and STA m
+ *     right after LDA m
+ *   - a store to a location that is written again before it is read
+ *   - JMP or a branch to the instruction right after it, and code after an
+ *     unconditional JMP or RTS up to the next label
+ *   - CLC; ADC #0 / SEC; SBC #0 / ORA #0 / EOR #0 / AND #$FF when the flags
+ *     they set are not read, and CMP #0 after an instruction that already
+ *     set N and Z from A
+ *   - LDA m; CLC; ADC #1; STA m (and SBC #1) to INC m (DEC m)
+ * Returns the number of instructions removed.
+ */
+size_t peephole(std::vector<Instr> &code);
+
+/**
+ * Text form of an instruction list, one instruction per line.
+ */
+std::string formatCode(const FunctionCode &function);
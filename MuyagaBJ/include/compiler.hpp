@@ -0,0 +1,57 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include "assembler.hpp"
+#include "ast.hpp"
+#include "codegen.hpp"
+#include "pass_stats.hpp"
+#include "semantic.hpp"
+#include "symbol_table.hpp"
+
+struct CompileOptions
+{
+    CodegenOptions codegen;
+    unsigned threads = 1;
+    std::string cacheDir; // reuse machine code of unchanged functions from here; empty for none
+};
+
+/*
+  Per-function compilation. Functions share nothing but the signatures
+  declared by Resolver::declareFunctions, so once those are known every
+  body can be resolved, folded, generated and assembled on its own.
+
+  Each worker thread takes a private copy of the interner and symbol table
+  as they stand after declareFunctions; every function leaves the table
+  the way it found it, so one copy serves all the functions a worker
+  takes. The AST is shared: a function only writes its own nodes, and
+  only reads the parameter lists of the functions it calls.
+
+  First, a scan of each function's text for the names of the functions it
+  calls finds the recursive ones (FunctionInfo::recursive), before any is
+  generated.
+
+  With a cache directory, a function whose key (object_cache.hpp) matches
+  a cached one skips all of that and is only relinked.
+*/
+
+// Time and allocations summed over the worker threads; peakBytes is left
+// to the caller, who sees the whole parallel phase
+struct CompileStats
+{
+    PassStats resolve;
+    PassStats codegen; // folding, generation, peephole and assembly
+    PassStats cache;   // keys, loads and stores
+    uint32_t cacheHits = 0;
+};
+
+/**
+ * Compile every declared function, on up to options.threads threads.
+ * Results are in declaration order whatever the scheduling, so the link
+ * is deterministic. If any function has an error, the error of the first
+ * one in the file is thrown.
+ * @param stats - if not null, filled in.
+ */
+std::vector<MachineFunction> compileFunctions(AstArena &ast, std::string_view source, const StringInterner &names,
+                                              const SymbolTable &symbols, std::vector<FunctionInfo> &functions,
+                                              const CompileOptions &options, CompileStats *stats = nullptr);
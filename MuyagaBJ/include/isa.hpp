@@ -0,0 +1,215 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+// -----------------------------
+// MuyagaBJ instruction set
+// -----------------------------
+
+/*
+  The subset of the 6502 described in MuyagaOS/instruction_set.md, plus
+  the SYS (FF) extension. Op doubles as the opcode of the code generator's
+  instruction list, where Label is a pseudo-instruction that encodes to
+  nothing.
+*/
+
+enum class Op : uint8_t
+{
+    LDA,
+    LDX,
+    LDY,
+    STA,
+    STX,
+    STY,
+    ADC,
+    SBC,
+    INC,
+    DEC,
+    CMP,
+    CPX,
+    CPY,
+    AND,
+    ORA,
+    EOR,
+    BNE,
+    BEQ,
+    BCC,
+    BCS,
+    BMI,
+    BPL,
+    JMP,
+    JSR,
+    RTS,
+    PHA,
+    PLA,
+    PHP,
+    PLP,
+    TXS,
+    TSX,
+    CLC,
+    SEC,
+    CLI,
+    SEI,
+    CLV,
+    CLD,
+    SED,
+    NOP,
+    BRK,
+    SYS,
+    Label,
+};
+
+enum class AddressMode : uint8_t
+{
+    Implied,
+    Immediate, // #$07
+    ZeroPage,  // $10: an address below $0100, one byte shorter and a cycle faster
+    Absolute,  // $0010
+    Relative,  // branches: signed 8-bit offset from the next instruction
+};
+
+struct Encoding
+{
+    Op op;
+    AddressMode mode;
+    uint8_t opcode;
+};
+
+constexpr Encoding ENCODINGS[] = {
+    {Op::LDA, AddressMode::Immediate, 0xA9},
+    {Op::LDA, AddressMode::ZeroPage, 0xA5},
+    {Op::LDA, AddressMode::Absolute, 0xAD},
+    {Op::LDX, AddressMode::Immediate, 0xA2},
+    {Op::LDX, AddressMode::ZeroPage, 0xA6},
+    {Op::LDX, AddressMode::Absolute, 0xAE},
+    {Op::LDY, AddressMode::Immediate, 0xA0},
+    {Op::LDY, AddressMode::ZeroPage, 0xA4},
+    {Op::LDY, AddressMode::Absolute, 0xAC},
+    {Op::STA, AddressMode::ZeroPage, 0x85},
+    {Op::STA, AddressMode::Absolute, 0x8D},
+    {Op::STX, AddressMode::ZeroPage, 0x86},
+    {Op::STX, AddressMode::Absolute, 0x8E},
+    {Op::STY, AddressMode::ZeroPage, 0x84},
+    {Op::STY, AddressMode::Absolute, 0x8C},
+
+    {Op::ADC, AddressMode::Immediate, 0x69},
+    {Op::ADC, AddressMode::ZeroPage, 0x65},
+    {Op::ADC, AddressMode::Absolute, 0x6D},
+    {Op::SBC, AddressMode::Immediate, 0xE9},
+    {Op::SBC, AddressMode::ZeroPage, 0xE5},
+    {Op::SBC, AddressMode::Absolute, 0xED},
+    {Op::INC, AddressMode::ZeroPage, 0xE6},
+    {Op::INC, AddressMode::Absolute, 0xEE},
+    {Op::DEC, AddressMode::ZeroPage, 0xC6},
+    {Op::DEC, AddressMode::Absolute, 0xCE},
+    {Op::CMP, AddressMode::Immediate, 0xC9},
+    {Op::CMP, AddressMode::ZeroPage, 0xC5},
+    {Op::CMP, AddressMode::Absolute, 0xCD},
+    {Op::CPX, AddressMode::Immediate, 0xE0},
+    {Op::CPX, AddressMode::ZeroPage, 0xE4},
+    {Op::CPX, AddressMode::Absolute, 0xEC},
+    {Op::CPY, AddressMode::Immediate, 0xC0},
+    {Op::CPY, AddressMode::ZeroPage, 0xC4},
+    {Op::CPY, AddressMode::Absolute, 0xCC},
+    {Op::AND, AddressMode::Immediate, 0x29},
+    {Op::AND, AddressMode::ZeroPage, 0x25},
+    {Op::AND, AddressMode::Absolute, 0x2D},
+    {Op::ORA, AddressMode::Immediate, 0x09},
+    {Op::ORA, AddressMode::ZeroPage, 0x05},
+    {Op::ORA, AddressMode::Absolute, 0x0D},
+    {Op::EOR, AddressMode::Immediate, 0x49},
+    {Op::EOR, AddressMode::ZeroPage, 0x45},
+    {Op::EOR, AddressMode::Absolute, 0x4D},
+
+    {Op::BNE, AddressMode::Relative, 0xD0},
+    {Op::BEQ, AddressMode::Relative, 0xF0},
+    {Op::BCC, AddressMode::Relative, 0x90},
+    {Op::BCS, AddressMode::Relative, 0xB0},
+    {Op::BMI, AddressMode::Relative, 0x30},
+    {Op::BPL, AddressMode::Relative, 0x10},
+    {Op::JMP, AddressMode::Absolute, 0x4C},
+    {Op::JSR, AddressMode::Absolute, 0x20},
+    {Op::RTS, AddressMode::Implied, 0x60},
+
+    {Op::PHA, AddressMode::Implied, 0x48},
+    {Op::PLA, AddressMode::Implied, 0x68},
+    {Op::PHP, AddressMode::Implied, 0x08},
+    {Op::PLP, AddressMode::Implied, 0x28},
+    {Op::TXS, AddressMode::Implied, 0x9A},
+    {Op::TSX, AddressMode::Implied, 0xBA},
+
+    {Op::CLC, AddressMode::Implied, 0x18},
+    {Op::SEC, AddressMode::Implied, 0x38},
+    {Op::CLI, AddressMode::Implied, 0x58},
+    {Op::SEI, AddressMode::Implied, 0x78},
+    {Op::CLV, AddressMode::Implied, 0xB8},
+    {Op::CLD, AddressMode::Implied, 0xD8},
+    {Op::SED, AddressMode::Implied, 0xF8},
+    {Op::NOP, AddressMode::Implied, 0xEA},
+    {Op::BRK, AddressMode::Implied, 0x00},
+    {Op::SYS, AddressMode::Implied, 0xFF},
+};
+
+/**
+ * Opcode byte of op in mode; returns false if the ISA has no such form.
+ */
+bool encodeOpcode(Op op, AddressMode mode, uint8_t &opcode);
+
+/**
+ * Bytes taken by an instruction in mode, opcode included.
+ */
+constexpr uint32_t instructionSize(AddressMode mode)
+{
+    return mode == AddressMode::Implied ? 1 : mode == AddressMode::Absolute ? 3 : 2;
+}
+
+struct Decoded
+{
+    bool valid = false;
+    Op op = Op::NOP;
+    AddressMode mode = AddressMode::Implied;
+};
+
+/**
+ * Reverse of ENCODINGS, for listings.
+ */
+const std::array<Decoded, 256> &decodeTable();
+
+const char *opName(Op op);
+
+// -----------------------------
+// Runtime conventions
+// -----------------------------
+
+/*
+  Values: int and char are one unsigned byte; string (and &x) is a 16-bit
+  address, stored low byte first. The fixed locations below live in the
+  zero page and are shared by every function.
+
+  The frame allocator moves hot locals and temporaries into two more
+  zero-page pools: ZP_SCRATCH for values that are never live across a call
+  (so nobody saves them), and ZP_SAVED for values that are, which a
+  function that makes calls saves on entry and restores on return. Frames
+  are static, so only a recursive function saves its frame as well. $C0-$FF
+  is left to the OS.
+*/
+constexpr uint16_t LOAD_ADDRESS = 0x0200; // image base; execution starts here
+constexpr uint16_t HEAP_START = 0x6000;   // code, data and frames must end below; alloc uses the rest
+constexpr uint16_t RET_ADDRESS = 0x00;    // 2 bytes: string results; int results come back in A
+constexpr uint16_t MUL_LEFT = 0x02;       // operands of the multiply/divide routines
+constexpr uint16_t MUL_RIGHT = 0x03;
+constexpr uint16_t DIV_QUOTIENT = 0x04;
+constexpr uint16_t ARG_ADDRESS = 0x08; // arguments, laid out like the callee's parameters
+constexpr uint16_t ARG_BYTES = 0x38;
+constexpr uint16_t ZP_SCRATCH = 0x40;
+constexpr uint16_t ZP_SCRATCH_BYTES = 0x40;
+constexpr uint16_t ZP_SAVED = 0x80;
+constexpr uint16_t ZP_SAVED_BYTES = 0x40;
+constexpr uint16_t STACK_BYTES = 0x100; // page 1: return addresses and saved values
+
+// SYS services, selected by X
+constexpr uint8_t SYS_PRINT_INT = 0x01;  // Y
+constexpr uint8_t SYS_PRINT_STR = 0x02;  // address in A (high) : Y (low)
+constexpr uint8_t SYS_ALLOC = 0x03;      // size in Y; address returned in A : Y
+constexpr uint8_t SYS_FREE = 0x04;       // address in A : Y
+constexpr uint8_t SYS_PRINT_CHAR = 0x05; // Y
@@ -1,23 +1,51 @@
 #pragma once
-#include <fstream>
-#include <string>
-#include <vector>
-#include <unordered_map>
+#include <array>
+#include <cstdint>
+#include <string_view>
 #include "token.hpp"
 
+// Tokens the parser may look ahead; a power of two so the ring index is a mask
+constexpr size_t LEXER_LOOKAHEAD = 4;
+static_assert((LEXER_LOOKAHEAD & (LEXER_LOOKAHEAD - 1)) == 0, "LEXER_LOOKAHEAD must be a power of two");
+
+// Scans a source buffer in place; tokens are views into it, so lexing does
+// no per-token allocation. Tokens are produced on demand: the parser pulls
+// them one at a time and only the lookahead window is ever held, so memory
+// stays constant whatever the size of the source.
 class Lexer
 {
 public:
-    explicit Lexer(std::ifstream &sourceCode);
-    std::vector<Token> tokenize();
+    explicit Lexer(std::string_view source);
+
+    /**
+     * Consume and return the next token. After the end of the source every
+     * call returns an EndOfFile token.
+     */
+    Token nextToken();
+
+    /**
+     * The token k positions ahead without consuming it (peek(0) is what
+     * nextToken() returns next); k must be below LEXER_LOOKAHEAD.
+     */
+    const Token &peek(size_t k = 0);
+
+    /**
+     * Offset of a token in the source buffer.
+     */
+    uint32_t offsetOf(const Token &token) const { return static_cast<uint32_t>(token.lexeme.data() - source.data()); }
 
 private:
-    std::ifstream &sourceCode;
-    std::vector<Token> tokens;
+    std::string_view source;
+    size_t pos = 0;
+    size_t lineStart = 0;
     int line = 1;
-    int column = 0;
 
-    void tokenizeLine(const std::string &lineText);
-    void scanToken(const std::string &lineText, size_t &pos);
-    void addToken(TokenType type, const std::string &lexeme);
+    std::array<Token, LEXER_LOOKAHEAD> ring{};
+    size_t head = 0;  // ring slot of peek(0)
+    size_t count = 0; // tokens scanned but not yet consumed
+
+    void skipWhitespaceAndComments();
+    Token scan();
+    Token scanToken();
+    Token makeToken(TokenType type, size_t start) const;
 };
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "assembler.hpp"
+
+// A program ready to load at LOAD_ADDRESS
+struct LinkedProgram
+{
+    std::vector<uint8_t> image;            // entry stub, functions, runtime routines, strings
+    std::vector<uint16_t> functionAddress; // per function, in source order
+    std::vector<uint16_t> runtimeAddress;  // per RuntimeRoutine; 0 if not linked in
+    uint16_t stringsAddress = 0;
+    uint16_t framesAddress = 0; // frames follow the image and are not part of it
+    uint16_t end = 0;
+};
+
+/**
+ * Lay out the program and patch every relocation. The image starts with
+ * JSR main; BRK, then the functions in source order, the runtime routines
+ * they use, and the string literals (identical ones shared); frames are
+ * placed after the image. Throws if the program does not fit below
+ * HEAP_START, or if the deepest chain of calls from some function can
+ * push more than STACK_BYTES. That chain stops at a recursive function:
+ * the depth of the recursion is only known at run time, so each recursive
+ * function compares the stack pointer with its own need on entry and
+ * calls __stack_overflow when there is not enough room.
+ */
+LinkedProgram link(const std::vector<MachineFunction> &functions, uint32_t mainIndex,
+                   const std::vector<std::string> &functionNames);
+
+/**
+ * Disassembly of a linked program, one instruction per line with its
+ * address and bytes, under the name of each function.
+ */
+std::string listProgram(const LinkedProgram &program, const std::vector<std::string> &functionNames);
@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "assembler.hpp"
+#include "ast.hpp"
+#include "codegen.hpp"
+#include "symbol_table.hpp"
+
+// -----------------------------
+// On-disk function cache
+// -----------------------------
+
+/*
+  A function's relocatable machine code depends only on its own tokens,
+  the signatures of the functions it names and the codegen options; not on
+  where it sits in the file or what the other bodies say. That text is the
+  cache key: one file per function, named after a hash of the key and
+  holding the key itself, so a collision is caught instead of misused.
+
+    [ObjectHeader][key][bytes][relocations][strings][callees]
+
+  Function relocations are stored against the file's own callee list, by
+  name, and mapped back to function indices on load, so a cached function
+  still links after functions are added, removed or reordered.
+*/
+
+// Bump whenever the layout or the meaning of any field changes, including
+// any change to code generation
+constexpr uint32_t OBJECT_CACHE_VERSION = 3;
+
+/**
+ * Key text of the function spanning text (from its func keyword to the
+ * next function): every token, then the signature of each declared
+ * function it names, then the options and whether it is recursive.
+ */
+std::string functionCacheKey(std::string_view text, bool recursive, const AstArena &ast, const StringInterner &names,
+                             const SymbolTable &symbols, const CodegenOptions &options);
+
+/**
+ * Cache file name for a key: its 64-bit FNV-1a hash in hex, with a .mbo
+ * extension.
+ */
+std::string objectCacheName(const std::string &key);
+
+/**
+ * Write a function to path, atomically (temporary file + rename).
+ * functionNames gives the callee of each Function relocation.
+ * @return false if the file cannot be written.
+ */
+bool saveCachedFunction(const std::string &path, const std::string &key, const MachineFunction &function,
+                        const std::vector<std::string_view> &functionNames);
+
+/**
+ * Read a cached function whose key matches exactly, with its callees
+ * looked up among the declared functions.
+ * @return false (leaving function untouched) if the file is missing,
+ * malformed, for another key, or calls a function that no longer exists.
+ */
+bool loadCachedFunction(const std::string &path, const std::string &key, const StringInterner &names,
+                        const SymbolTable &symbols, MachineFunction &function);
@@ -0,0 +1,44 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "ast.hpp"
+#include "lexer.hpp"
+
+// Recursive-descent parser for the grammar in grammer.md. It pulls tokens
+// from the lexer as it goes and appends nodes to the arena; a syntax error
+// throws std::runtime_error with its line and column.
+class Parser
+{
+public:
+    Parser(Lexer &lexer, AstArena &ast);
+
+    /**
+     * Parse the whole source and return the Program node.
+     */
+    NodeIndex parseProgram();
+
+private:
+    Lexer &lexer;
+    AstArena &ast;
+    std::vector<NodeIndex> scratch; // children of the lists still being parsed
+
+    NodeIndex parseFunction();
+    NodeIndex parseParam();
+    NodeIndex parseBlock();
+    NodeIndex parseStatement();
+    NodeIndex parseVarDecl();
+    NodeIndex parseExpression();
+    NodeIndex parseBinary(int level);
+    NodeIndex parseUnary();
+    NodeIndex parsePrimary();
+    NodeIndex parseCall(const Token &name);
+
+    ValueType parseType();
+    NodeIndex makeIdentifier(const Token &token);
+    NodeIndex makeNode(NodeKind kind, const Token &at, uint32_t a = 0, uint32_t b = 0, uint32_t c = 0);
+    ListIndex closeList(size_t mark);
+
+    bool match(TokenType type);
+    Token expect(TokenType type, const char *what);
+    [[noreturn]] void error(const Token &token, const std::string &message) const;
+};
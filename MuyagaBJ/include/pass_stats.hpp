@@ -0,0 +1,55 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// -----------------------------
+// Pass timing and heap counters
+// -----------------------------
+
+/*
+  The global operator new and delete, aligned forms included, are replaced
+  (pass_stats.cpp) to count allocations and the bytes requested, once
+  tracking is enabled. Each block carries a small header with its size, so
+  this needs nothing beyond malloc and free; until tracking starts, the
+  cost is that header and one relaxed load.
+*/
+
+/**
+ * Start counting. Bytes in use and the peak cover the blocks allocated
+ * from here on.
+ */
+void enableAllocationTracking();
+
+uint64_t allocationCount();       // every thread
+uint64_t threadAllocationCount(); // the calling thread only
+int64_t heapInUse();
+int64_t heapPeak();
+void resetHeapPeak(); // peak := bytes in use now
+
+struct PassStats
+{
+    std::string name;
+    double milliseconds = 0;
+    uint64_t allocations = 0;
+    int64_t peakBytes = 0; // most heap in use at any point during the pass
+};
+
+// Measures from construction to finish()
+class PassTimer
+{
+public:
+    explicit PassTimer(std::string name);
+    PassStats finish() const;
+
+private:
+    std::string name;
+    std::chrono::steady_clock::time_point start;
+    uint64_t allocationsAtStart;
+};
+
+/**
+ * One "[Stats]" line per pass plus a total, for --time-passes.
+ */
+std::string formatPassTable(const std::vector<PassStats> &passes);
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "codegen.hpp"
+
+// -----------------------------
+// Frame allocation
+// -----------------------------
+
+// Most of ZP_SAVED a function that is not recursive uses. Its frame needs
+// no saving, so a value it keeps across calls can stay there instead;
+// what it keeps in the pool costs stack in every chain of calls through it.
+constexpr uint32_t NONRECURSIVE_SAVED_BYTES = 16;
+
+// Where each byte of a function's frame ended up
+struct FrameLayout
+{
+    std::vector<Operand> location; // per frame byte: Fixed (zero page) or Frame; None if never used
+    std::vector<Operand> saved;    // locations a call can clobber: the Fixed ones, and Frame ones if recursive
+    uint32_t frameSize = 0;        // bytes left in the frame in main memory
+};
+
+/**
+ * Give every frame byte of a function a home. Each byte's live range is
+ * the span from its first to its last use, widened over any loop it is
+ * live around; bytes whose ranges do not overlap share a location.
+ * Ranges are placed hottest first, where a use counts 8 times more per
+ * loop it sits in: into ZP_SCRATCH when no call falls inside the range,
+ * the first savedBytes of ZP_SAVED when one does, and the frame once the
+ * pool is full. Bytes in pinned (variables whose address is taken) stay
+ * in the frame, in order.
+ */
+FrameLayout allocateFrame(const std::vector<Instr> &code, uint32_t frameSize, const std::vector<uint32_t> &pinned,
+                          uint32_t savedBytes);
+
+/**
+ * Layout that leaves every byte where it is and saves all of them.
+ */
+FrameLayout identityLayout(uint32_t frameSize);
+
+/**
+ * Rewrite the Frame, FrameLo and FrameHi operands of code to layout.
+ */
+void applyLayout(std::vector<Instr> &code, const FrameLayout &layout);
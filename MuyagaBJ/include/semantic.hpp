@@ -0,0 +1,74 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include "ast.hpp"
+#include "symbol_table.hpp"
+
+// What later passes need to know about one function
+struct FunctionInfo
+{
+    NodeIndex node = NO_NODE;
+    uint32_t symbol = NO_SYMBOL;
+    uint32_t paramCount = 0;
+    uint32_t paramBytes = 0;
+    uint32_t frameSize = 0; // bytes of parameters + locals; parameters come first
+    bool recursive = false; // on a cycle of calls, so its frame can be live in two activations
+};
+
+/**
+ * Bytes a value of type takes: strings are 16-bit addresses, int and char
+ * one byte.
+ */
+inline uint32_t valueWidth(ValueType type)
+{
+    return type == ValueType::String ? 2 : 1;
+}
+
+/*
+  Name resolution and type checking. Every Identifier node gets the index of
+  its symbol in c, every expression node its type, and let declarations the
+  type of their initializer; each parameter and local gets a frame offset
+  (Symbol::slot). Strings only mix with strings, and int and char only with
+  each other. The first error throws std::runtime_error with its line and
+  column.
+
+  Functions are declared first (declareFunctions), so a function may call
+  one defined later in the file; after that each body resolves on its own.
+*/
+class Resolver
+{
+public:
+    Resolver(AstArena &ast, std::string_view source, StringInterner &names, SymbolTable &symbols);
+
+    /**
+     * Declare every function of the program at the outermost scope and check
+     * that main exists.
+     */
+    std::vector<FunctionInfo> declareFunctions(NodeIndex program);
+
+    /**
+     * Resolve the parameters and body of one declared function.
+     */
+    void resolveFunction(FunctionInfo &function);
+
+private:
+    AstArena &ast;
+    std::string_view source;
+    StringInterner &names;
+    SymbolTable &symbols;
+
+    FunctionInfo *current = nullptr;
+
+    NameId nameOf(NodeIndex identifier);
+    uint32_t declareLocal(NodeIndex identifier, SymbolKind kind, ValueType type);
+    uint32_t resolveName(NodeIndex identifier);
+
+    void resolveBlock(NodeIndex block);
+    void resolveStatement(NodeIndex statement);
+    ValueType resolveExpression(NodeIndex expression);
+    ValueType resolveValue(NodeIndex expression, const char *context);
+    void checkAssignable(ValueType target, ValueType value, uint32_t offset, const char *context);
+
+    [[noreturn]] void error(uint32_t offset, const std::string &message) const;
+};
@@ -0,0 +1,24 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Read-only, memory-mapped view of a source file. Tokens and the AST refer
+// to the text by offset or string_view, so it is never copied.
+class SourceFile
+{
+public:
+    explicit SourceFile(const std::string &path);
+    ~SourceFile();
+
+    SourceFile(const SourceFile &) = delete;
+    SourceFile &operator=(const SourceFile &) = delete;
+
+    std::string_view text() const { return {data, size}; }
+    const std::string &path() const { return filePath; }
+
+private:
+    std::string filePath;
+    const char *data = nullptr;
+    size_t size = 0;
+};
@@ -0,0 +1,123 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "ast.hpp"
+
+// -----------------------------
+// String interner
+// -----------------------------
+
+// Identifiers are interned once and compared as integers afterwards
+using NameId = uint32_t;
+constexpr NameId NO_NAME = UINT32_MAX;
+
+class StringInterner
+{
+public:
+    StringInterner();
+
+    /**
+     * Id of text, adding it if new. The interner keeps a view, so text must
+     * outlive it (names come straight from the mapped source).
+     */
+    NameId intern(std::string_view text);
+
+    /**
+     * Id of text, or NO_NAME if it was never interned.
+     */
+    NameId find(std::string_view text) const;
+
+    std::string_view text(NameId id) const { return names[id]; }
+    size_t size() const { return names.size(); }
+
+private:
+    std::vector<std::string_view> names;
+    std::vector<uint32_t> hashes; // per name, so growing never rehashes text
+    std::vector<NameId> table;    // open addressing, power-of-two size; NO_NAME is empty
+
+    size_t probe(std::string_view text, uint32_t hash) const;
+    void grow();
+};
+
+// -----------------------------
+// Symbol table
+// -----------------------------
+
+constexpr uint32_t NO_SYMBOL = UINT32_MAX;
+
+enum class SymbolKind : uint8_t
+{
+    Function,
+    Parameter,
+    Variable,
+};
+
+struct Symbol
+{
+    NameId name = NO_NAME;
+    SymbolKind kind = SymbolKind::Variable;
+    ValueType type = ValueType::None;
+    uint16_t depth = 0;    // scope nesting; functions are at 0
+    uint32_t slot = 0;     // function index, or frame slot of a parameter/local
+    NodeIndex decl = NO_NODE;
+};
+
+/*
+  All scopes share one flat open-addressing table from name to the innermost
+  visible symbol. Declaring a name overwrites its entry and pushes the old
+  binding on an undo log; leaving a scope pops the log back to where the
+  scope began. Entering and leaving a block therefore cost O(names declared
+  in it), with no per-scope map, and a lookup is a single probe sequence
+  whatever the nesting depth.
+
+  Symbols are never removed: the index returned by declare() stays valid for
+  the whole compilation, so the AST can refer to it.
+*/
+class SymbolTable
+{
+public:
+    SymbolTable();
+
+    void enterScope();
+    void leaveScope();
+    uint16_t depth() const { return static_cast<uint16_t>(scopeMarks.size()); }
+
+    /**
+     * Bind symbol.name in the current scope and return the symbol's index,
+     * or NO_SYMBOL if the name is already declared in this same scope.
+     * Shadowing a name from an outer scope is allowed.
+     */
+    uint32_t declare(Symbol symbol);
+
+    /**
+     * Innermost visible symbol for name, or NO_SYMBOL.
+     */
+    uint32_t lookup(NameId name) const;
+
+    const Symbol &symbol(uint32_t index) const { return symbols[index]; }
+    Symbol &symbol(uint32_t index) { return symbols[index]; }
+    size_t symbolCount() const { return symbols.size(); }
+
+private:
+    struct Entry
+    {
+        NameId name = NO_NAME;
+        uint32_t symbol = NO_SYMBOL; // NO_SYMBOL once every binding went out of scope
+    };
+
+    struct Undo
+    {
+        NameId name;
+        uint32_t previous;
+    };
+
+    std::vector<Entry> table;
+    size_t used = 0;
+    std::vector<Symbol> symbols;
+    std::vector<Undo> undoLog;
+    std::vector<size_t> scopeMarks; // undo log size at each enterScope()
+
+    size_t probe(NameId name) const;
+    void grow();
+};
@@ -1,6 +1,9 @@
 #pragma once
+#include <array>
+#include <cstdint>
+#include <iterator>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 
 enum class TokenType
 {
@@ -26,6 +29,7 @@ enum class TokenType
     String,
     Alloc,
     Free,
+    Void,
 
     // Symbols
     Plus,
@@ -51,42 +55,120 @@ enum class TokenType
     Unknown
 };
 
+// Tokens point into the source buffer, which must outlive them
 struct Token
 {
-    std::string lexeme;
+    std::string_view lexeme;
     TokenType type;
     int line;
     int column;
 
-    Token(std::string lex, TokenType t, int l, int c)
-        : lexeme(std::move(lex)), type(t), line(l), column(c) {}
-
     std::string toString() const
     {
-        return "Token(" + lexeme + ", " + std::to_string(line) + ":" + std::to_string(column) + ")";
+        return "Token(" + std::string(lexeme) + ", " + std::to_string(line) + ":" + std::to_string(column) + ")";
     }
 };
 
-inline TokenType getKeywordType(const std::string &word)
+// -----------------------------
+// Keyword lookup
+// -----------------------------
+
+struct Keyword
 {
-    static const std::unordered_map<std::string, TokenType> keywords = {
-        {"let", TokenType::Let},
-        {"func", TokenType::Func},
-        {"return", TokenType::Return},
-        {"while", TokenType::While},
-        {"if", TokenType::If},
-        {"else", TokenType::Else},
-        {"print", TokenType::Print},
-        {"int", TokenType::Int},
-        {"char", TokenType::Char},
-        {"string", TokenType::String},
-        {"alloc", TokenType::Alloc},
-        {"free", TokenType::Free}};
-
-    auto it = keywords.find(word);
-    if (it != keywords.end())
+    std::string_view text;
+    TokenType type;
+};
+
+constexpr Keyword KEYWORDS[] = {
+    {"let", TokenType::Let},
+    {"func", TokenType::Func},
+    {"return", TokenType::Return},
+    {"while", TokenType::While},
+    {"if", TokenType::If},
+    {"else", TokenType::Else},
+    {"print", TokenType::Print},
+    {"int", TokenType::Int},
+    {"char", TokenType::Char},
+    {"string", TokenType::String},
+    {"alloc", TokenType::Alloc},
+    {"free", TokenType::Free},
+    {"void", TokenType::Void}};
+
+constexpr uint32_t KEYWORD_SLOTS = 32;
+
+/*
+  Perfect hash over the keyword list: a word hashes from its length and its
+  first and last characters, and the two multipliers are searched at compile
+  time until no two keywords share a slot. An identifier then costs one hash,
+  one length check and at most one compare, with no allocation.
+*/
+struct KeywordHash
+{
+    bool found = false;
+    uint32_t first = 0;
+    uint32_t last = 0;
+    std::array<int8_t, KEYWORD_SLOTS> slots{}; // index into KEYWORDS, -1 if empty
+
+    constexpr uint32_t slot(std::string_view word) const
     {
-        return it->second;
+        return (static_cast<uint32_t>(word.size()) + static_cast<unsigned char>(word.front()) * first +
+                static_cast<unsigned char>(word.back()) * last) %
+               KEYWORD_SLOTS;
     }
+};
+
+constexpr KeywordHash findKeywordHash()
+{
+    for (uint32_t first = 0; first < KEYWORD_SLOTS; ++first)
+    {
+        for (uint32_t last = 0; last < KEYWORD_SLOTS; ++last)
+        {
+            KeywordHash hash;
+            hash.first = first;
+            hash.last = last;
+            for (int8_t &entry : hash.slots)
+            {
+                entry = -1;
+            }
+
+            bool collision = false;
+            for (size_t i = 0; i < std::size(KEYWORDS) && !collision; ++i)
+            {
+                int8_t &entry = hash.slots[hash.slot(KEYWORDS[i].text)];
+                collision = entry != -1;
+                entry = static_cast<int8_t>(i);
+            }
+            if (!collision)
+            {
+                hash.found = true;
+                return hash;
+            }
+        }
+    }
+    return KeywordHash{};
+}
+
+constexpr KeywordHash KEYWORD_HASH = findKeywordHash();
+static_assert(KEYWORD_HASH.found, "no perfect hash for the keyword list");
+
+constexpr TokenType getKeywordType(std::string_view word)
+{
+    if (word.empty())
+        return TokenType::Identifier;
+
+    int8_t entry = KEYWORD_HASH.slots[KEYWORD_HASH.slot(word)];
+    if (entry >= 0 && KEYWORDS[entry].text == word)
+        return KEYWORDS[entry].type;
     return TokenType::Identifier;
 }
+
+constexpr bool keywordsResolve()
+{
+    for (const Keyword &keyword : KEYWORDS)
+    {
+        if (getKeywordType(keyword.text) != keyword.type)
+            return false;
+    }
+    return true;
+}
+static_assert(keywordsResolve(), "keyword hash lost a keyword");
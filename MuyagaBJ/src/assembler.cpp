@@ -0,0 +1,192 @@
+#include <stdexcept>
+#include <unordered_map>
+#include "../include/assembler.hpp"
+
+/*----- Helper: modeOf() -----*/
+static AddressMode modeOf(const Instr &instr)
+{
+    switch (instr.operand.kind)
+    {
+    case OperandKind::None:
+        return AddressMode::Implied;
+    case OperandKind::Immediate:
+    case OperandKind::FrameLo:
+    case OperandKind::FrameHi:
+    case OperandKind::StringLo:
+    case OperandKind::StringHi:
+    case OperandKind::StackCheck:
+        return AddressMode::Immediate;
+    case OperandKind::Label:
+        return instr.op == Op::JMP ? AddressMode::Absolute : AddressMode::Relative;
+    case OperandKind::Fixed:
+        return instr.operand.value < 0x100 ? AddressMode::ZeroPage : AddressMode::Absolute;
+    default:
+        return AddressMode::Absolute;
+    }
+}
+
+static Op oppositeBranch(Op op)
+{
+    switch (op)
+    {
+    case Op::BNE:
+        return Op::BEQ;
+    case Op::BEQ:
+        return Op::BNE;
+    case Op::BCC:
+        return Op::BCS;
+    case Op::BCS:
+        return Op::BCC;
+    case Op::BMI:
+        return Op::BPL;
+    default:
+        return Op::BMI;
+    }
+}
+
+static uint8_t opcodeOf(Op op, AddressMode mode)
+{
+    uint8_t opcode;
+    if (!encodeOpcode(op, mode, opcode))
+        throw std::logic_error(std::string("no encoding for ") + opName(op));
+    return opcode;
+}
+
+MachineFunction assembleFunction(const FunctionCode &function)
+{
+    const std::vector<Instr> &code = function.code;
+
+    // Lay out with short branches, widening the ones that do not reach until
+    // nothing changes; widening only ever moves code further apart
+    std::vector<bool> longBranch(code.size(), false);
+    std::vector<uint32_t> offsets(code.size() + 1);
+    std::unordered_map<uint32_t, uint32_t> labelOffset;
+
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        labelOffset.clear();
+        uint32_t offset = 0;
+        for (size_t i = 0; i < code.size(); ++i)
+        {
+            offsets[i] = offset;
+            if (code[i].op == Op::Label)
+                labelOffset[code[i].operand.value] = offset;
+            else if (modeOf(code[i]) == AddressMode::Relative)
+                offset += longBranch[i] ? 5 : 2;
+            else
+                offset += instructionSize(modeOf(code[i]));
+        }
+        offsets[code.size()] = offset;
+
+        for (size_t i = 0; i < code.size(); ++i)
+        {
+            if (code[i].op == Op::Label || modeOf(code[i]) != AddressMode::Relative || longBranch[i])
+                continue;
+            int32_t displacement = static_cast<int32_t>(labelOffset.at(code[i].operand.value)) -
+                                   static_cast<int32_t>(offsets[i] + 2);
+            if (displacement < -128 || displacement > 127)
+            {
+                longBranch[i] = true;
+                changed = true;
+            }
+        }
+    }
+
+    MachineFunction machine;
+    machine.bytes.reserve(offsets[code.size()]);
+    machine.frameSize = function.frameSize;
+    machine.savedBytes = function.savedBytes;
+    machine.recursive = function.recursive;
+    machine.strings.assign(function.strings.begin(), function.strings.end());
+
+    auto relocate = [&](RelocKind kind, uint32_t value, uint32_t width)
+    {
+        machine.relocations.push_back({static_cast<uint32_t>(machine.bytes.size()), kind, value});
+        machine.bytes.insert(machine.bytes.end(), width, 0);
+    };
+
+    for (size_t i = 0; i < code.size(); ++i)
+    {
+        const Instr &instr = code[i];
+        if (instr.op == Op::Label)
+            continue;
+
+        AddressMode mode = modeOf(instr);
+        const Operand &operand = instr.operand;
+
+        if (mode == AddressMode::Relative)
+        {
+            uint32_t target = labelOffset.at(operand.value);
+            if (longBranch[i])
+            {
+                machine.bytes.push_back(opcodeOf(oppositeBranch(instr.op), AddressMode::Relative));
+                machine.bytes.push_back(3);
+                machine.bytes.push_back(opcodeOf(Op::JMP, AddressMode::Absolute));
+                relocate(RelocKind::Code, target, 2);
+            }
+            else
+            {
+                machine.bytes.push_back(opcodeOf(instr.op, mode));
+                machine.bytes.push_back(static_cast<uint8_t>(static_cast<int32_t>(target) - static_cast<int32_t>(offsets[i] + 2)));
+            }
+            continue;
+        }
+
+        machine.bytes.push_back(opcodeOf(instr.op, mode));
+        switch (operand.kind)
+        {
+        case OperandKind::Immediate:
+            machine.bytes.push_back(static_cast<uint8_t>(operand.value));
+            break;
+        case OperandKind::Fixed:
+            machine.bytes.push_back(static_cast<uint8_t>(operand.value));
+            if (mode == AddressMode::Absolute)
+                machine.bytes.push_back(static_cast<uint8_t>(operand.value >> 8));
+            break;
+        case OperandKind::Frame:
+            relocate(RelocKind::Frame, operand.value, 2);
+            break;
+        case OperandKind::FrameLo:
+            relocate(RelocKind::FrameLo, operand.value, 1);
+            break;
+        case OperandKind::FrameHi:
+            relocate(RelocKind::FrameHi, operand.value, 1);
+            break;
+        case OperandKind::StringLo:
+            relocate(RelocKind::StringLo, operand.value, 1);
+            break;
+        case OperandKind::StringHi:
+            relocate(RelocKind::StringHi, operand.value, 1);
+            break;
+        case OperandKind::StackCheck:
+            relocate(RelocKind::StackCheck, 0, 1);
+            break;
+        case OperandKind::Label:
+            relocate(RelocKind::Code, labelOffset.at(operand.value), 2);
+            break;
+        case OperandKind::Function:
+            relocate(RelocKind::Function, operand.value, 2);
+            break;
+        case OperandKind::Runtime:
+            relocate(RelocKind::Runtime, operand.value, 2);
+            break;
+        default:
+            break;
+        }
+    }
+    return machine;
+}
+
+uint32_t instructionCount(const MachineFunction &function)
+{
+    const std::array<Decoded, 256> &decode = decodeTable();
+    uint32_t count = 0;
+    for (size_t at = 0; at < function.bytes.size(); ++count)
+    {
+        const Decoded &instr = decode[function.bytes[at]];
+        at += instr.valid ? instructionSize(instr.mode) : 1;
+    }
+    return count;
+}
@@ -0,0 +1,224 @@
+#include <string>
+#include "../include/ast.hpp"
+
+AstArena::AstArena()
+{
+    // Sentinels: NO_NODE and EMPTY_LIST
+    nodes.emplace_back();
+    lists.push_back(0);
+}
+
+NodeIndex AstArena::addNode(const AstNode &node)
+{
+    nodes.push_back(node);
+    return static_cast<NodeIndex>(nodes.size() - 1);
+}
+
+ListIndex AstArena::addList(const NodeIndex *items, size_t count)
+{
+    if (count == 0)
+        return EMPTY_LIST;
+
+    ListIndex index = static_cast<ListIndex>(lists.size());
+    lists.push_back(static_cast<NodeIndex>(count));
+    lists.insert(lists.end(), items, items + count);
+    return index;
+}
+
+void AstArena::reserve(size_t nodeCount)
+{
+    nodes.reserve(nodeCount + 1);
+    lists.reserve(nodeCount + 1);
+}
+
+const char *nodeKindName(NodeKind kind)
+{
+    switch (kind)
+    {
+    case NodeKind::Program:
+        return "Program";
+    case NodeKind::Function:
+        return "Function";
+    case NodeKind::Param:
+        return "Param";
+    case NodeKind::Block:
+        return "Block";
+    case NodeKind::VarDecl:
+        return "VarDecl";
+    case NodeKind::Assign:
+        return "Assign";
+    case NodeKind::Return:
+        return "Return";
+    case NodeKind::While:
+        return "While";
+    case NodeKind::If:
+        return "If";
+    case NodeKind::Print:
+        return "Print";
+    case NodeKind::Free:
+        return "Free";
+    case NodeKind::ExprStmt:
+        return "ExprStmt";
+    case NodeKind::Number:
+        return "Number";
+    case NodeKind::CharLit:
+        return "Char";
+    case NodeKind::StringLit:
+        return "String";
+    case NodeKind::Identifier:
+        return "Identifier";
+    case NodeKind::Call:
+        return "Call";
+    case NodeKind::Alloc:
+        return "Alloc";
+    case NodeKind::Unary:
+        return "Unary";
+    case NodeKind::Binary:
+        return "Binary";
+    default:
+        return "None";
+    }
+}
+
+const char *valueTypeName(ValueType type)
+{
+    switch (type)
+    {
+    case ValueType::Void:
+        return "void";
+    case ValueType::Int:
+        return "int";
+    case ValueType::Char:
+        return "char";
+    case ValueType::String:
+        return "string";
+    case ValueType::Inferred:
+        return "let";
+    default:
+        return "";
+    }
+}
+
+const char *operatorName(Operator op)
+{
+    switch (op)
+    {
+    case Operator::Add:
+        return "+";
+    case Operator::Sub:
+    case Operator::Negate:
+        return "-";
+    case Operator::Mul:
+        return "*";
+    case Operator::Div:
+        return "/";
+    case Operator::Equal:
+        return "==";
+    case Operator::NotEqual:
+        return "!=";
+    case Operator::Less:
+        return "<";
+    case Operator::LessEqual:
+        return "<=";
+    case Operator::Greater:
+        return ">";
+    case Operator::GreaterEqual:
+        return ">=";
+    case Operator::AddressOf:
+        return "&";
+    default:
+        return "";
+    }
+}
+
+/*----- Helper: dumpNode() -----*/
+static void dumpNode(const AstArena &ast, NodeIndex index, std::string_view source, int depth, std::string &out)
+{
+    if (index == NO_NODE)
+        return;
+
+    const AstNode &node = ast.node(index);
+    out.append(depth * 2, ' ');
+    out += nodeKindName(node.kind);
+
+    switch (node.kind)
+    {
+    case NodeKind::Number:
+        out += " " + std::to_string(static_cast<int32_t>(node.a));
+        break;
+    case NodeKind::CharLit:
+        out += " '" + std::string(1, static_cast<char>(node.a)) + "'";
+        break;
+    case NodeKind::StringLit:
+        out += " \"" + std::string(source.substr(node.a, node.b)) + "\"";
+        break;
+    case NodeKind::Identifier:
+        out += " " + std::string(source.substr(node.a, node.b));
+        break;
+    case NodeKind::Unary:
+    case NodeKind::Binary:
+        out += std::string(" ") + operatorName(node.op);
+        break;
+    default:
+        break;
+    }
+    if (node.type != ValueType::None)
+        out += std::string(" : ") + valueTypeName(node.type);
+    out += "\n";
+
+    switch (node.kind)
+    {
+    case NodeKind::Program:
+    case NodeKind::Block:
+        for (NodeIndex child : ast.list(node.a))
+        {
+            dumpNode(ast, child, source, depth + 1, out);
+        }
+        break;
+    case NodeKind::Function:
+        dumpNode(ast, node.a, source, depth + 1, out);
+        for (NodeIndex param : ast.list(node.b))
+        {
+            dumpNode(ast, param, source, depth + 1, out);
+        }
+        dumpNode(ast, node.c, source, depth + 1, out);
+        break;
+    case NodeKind::Call:
+        dumpNode(ast, node.a, source, depth + 1, out);
+        for (NodeIndex arg : ast.list(node.b))
+        {
+            dumpNode(ast, arg, source, depth + 1, out);
+        }
+        break;
+    case NodeKind::Param:
+    case NodeKind::Return:
+    case NodeKind::Print:
+    case NodeKind::Free:
+    case NodeKind::ExprStmt:
+    case NodeKind::Alloc:
+    case NodeKind::Unary:
+        dumpNode(ast, node.a, source, depth + 1, out);
+        break;
+    case NodeKind::VarDecl:
+    case NodeKind::Assign:
+    case NodeKind::While:
+    case NodeKind::Binary:
+        dumpNode(ast, node.a, source, depth + 1, out);
+        dumpNode(ast, node.b, source, depth + 1, out);
+        break;
+    case NodeKind::If:
+        dumpNode(ast, node.a, source, depth + 1, out);
+        dumpNode(ast, node.b, source, depth + 1, out);
+        dumpNode(ast, node.c, source, depth + 1, out);
+        break;
+    default:
+        break;
+    }
+}
+
+std::string dumpAst(const AstArena &ast, NodeIndex root, std::string_view source)
+{
+    std::string out;
+    dumpNode(ast, root, source, 0, out);
+    return out;
+}
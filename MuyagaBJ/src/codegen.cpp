@@ -0,0 +1,1362 @@
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+#include "../include/codegen.hpp"
+#include "../include/register_alloc.hpp"
+
+// -----------------------------
+// Constant folding
+// -----------------------------
+
+static bool isConstant(const AstNode &node)
+{
+    return node.kind == NodeKind::Number || node.kind == NodeKind::CharLit;
+}
+
+static bool isConstantValue(const AstNode &node, uint32_t value)
+{
+    return isConstant(node) && (node.a & 0xff) == value;
+}
+
+/*----- Helper: hasSideEffects() -----*/
+// Calls and alloc must run even when their value is not needed
+static bool hasSideEffects(const AstArena &ast, NodeIndex expression)
+{
+    const AstNode &node = ast.node(expression);
+    switch (node.kind)
+    {
+    case NodeKind::Call:
+    case NodeKind::Alloc:
+        return true;
+    case NodeKind::Unary:
+        return hasSideEffects(ast, node.a);
+    case NodeKind::Binary:
+        return hasSideEffects(ast, node.a) || hasSideEffects(ast, node.b);
+    default:
+        return false;
+    }
+}
+
+/*----- Helper: evaluate() -----*/
+// Same results as the machine: unsigned bytes, x / 0 == 0
+static uint32_t evaluate(Operator op, uint32_t left, uint32_t right)
+{
+    left &= 0xff;
+    right &= 0xff;
+    switch (op)
+    {
+    case Operator::Add:
+        return (left + right) & 0xff;
+    case Operator::Sub:
+        return (left - right) & 0xff;
+    case Operator::Mul:
+        return (left * right) & 0xff;
+    case Operator::Div:
+        return right == 0 ? 0 : left / right;
+    case Operator::Equal:
+        return left == right;
+    case Operator::NotEqual:
+        return left != right;
+    case Operator::Less:
+        return left < right;
+    case Operator::LessEqual:
+        return left <= right;
+    case Operator::Greater:
+        return left > right;
+    case Operator::GreaterEqual:
+        return left >= right;
+    default:
+        return 0;
+    }
+}
+
+static void makeConstant(AstArena &ast, NodeIndex index, uint32_t value)
+{
+    AstNode &node = ast.node(index);
+    node.kind = NodeKind::Number;
+    node.op = Operator::None;
+    node.a = value & 0xff;
+    node.b = node.c = 0;
+}
+
+// Replace a node by one of its operands, keeping the parent's type
+static void replaceWith(AstArena &ast, NodeIndex index, NodeIndex operand)
+{
+    ValueType type = ast.node(index).type;
+    ast.node(index) = ast.node(operand);
+    ast.node(index).type = type;
+}
+
+static void foldExpression(AstArena &ast, NodeIndex index)
+{
+    const AstNode node = ast.node(index);
+    switch (node.kind)
+    {
+    case NodeKind::Call:
+        for (NodeIndex arg : ast.list(node.b))
+        {
+            foldExpression(ast, arg);
+        }
+        break;
+
+    case NodeKind::Alloc:
+        foldExpression(ast, node.a);
+        break;
+
+    case NodeKind::Unary:
+        foldExpression(ast, node.a);
+        if (node.op == Operator::Negate && isConstant(ast.node(node.a)))
+            makeConstant(ast, index, 0u - ast.node(node.a).a);
+        break;
+
+    case NodeKind::Binary:
+    {
+        foldExpression(ast, node.a);
+        foldExpression(ast, node.b);
+        const AstNode &left = ast.node(node.a);
+        const AstNode &right = ast.node(node.b);
+
+        if (isConstant(left) && isConstant(right))
+            makeConstant(ast, index, evaluate(node.op, left.a, right.a));
+        else if ((node.op == Operator::Add || node.op == Operator::Sub) && isConstantValue(right, 0))
+            replaceWith(ast, index, node.a);
+        else if ((node.op == Operator::Mul || node.op == Operator::Div) && isConstantValue(right, 1))
+            replaceWith(ast, index, node.a);
+        else if ((node.op == Operator::Add && isConstantValue(left, 0)) || (node.op == Operator::Mul && isConstantValue(left, 1)))
+            replaceWith(ast, index, node.b);
+        else if (node.op == Operator::Mul && ((isConstantValue(right, 0) && !hasSideEffects(ast, node.a)) ||
+                                              (isConstantValue(left, 0) && !hasSideEffects(ast, node.b))))
+            makeConstant(ast, index, 0);
+        break;
+    }
+
+    default:
+        break;
+    }
+}
+
+static void foldStatement(AstArena &ast, NodeIndex index)
+{
+    const AstNode node = ast.node(index);
+    switch (node.kind)
+    {
+    case NodeKind::Block:
+        for (NodeIndex statement : ast.list(node.a))
+        {
+            foldStatement(ast, statement);
+        }
+        break;
+    case NodeKind::VarDecl:
+    case NodeKind::Assign:
+        foldExpression(ast, node.b);
+        break;
+    case NodeKind::Return:
+        if (node.a != NO_NODE)
+            foldExpression(ast, node.a);
+        break;
+    case NodeKind::While:
+        foldExpression(ast, node.a);
+        foldStatement(ast, node.b);
+        break;
+    case NodeKind::If:
+        foldExpression(ast, node.a);
+        foldStatement(ast, node.b);
+        if (node.c != NO_NODE)
+            foldStatement(ast, node.c);
+        break;
+    case NodeKind::Print:
+    case NodeKind::ExprStmt:
+        foldExpression(ast, node.a);
+        break;
+    default:
+        break;
+    }
+}
+
+void foldConstants(AstArena &ast, NodeIndex function)
+{
+    foldStatement(ast, ast.node(function).c);
+}
+
+// -----------------------------
+// Code generation
+// -----------------------------
+
+static Operand immediate(uint32_t value)
+{
+    return {OperandKind::Immediate, value & 0xff};
+}
+
+static Operand fixedAddress(uint32_t address)
+{
+    return {OperandKind::Fixed, address};
+}
+
+static Operand frameByte(uint32_t offset)
+{
+    return {OperandKind::Frame, offset};
+}
+
+// The next byte of a two-byte location
+static Operand highByte(Operand low)
+{
+    return {low.kind, low.value + 1};
+}
+
+/*
+  An accumulator machine with no indexed modes: every local and temporary
+  gets a byte of its function's frame, and expressions are evaluated into
+  A, with right operands that are not a literal or a variable first
+  spilled to a temporary. Once the body is generated, allocateFrame gives
+  each frame byte its final fixed address, in the zero page when hot.
+
+  Calls pass arguments through the ARG area and return ints in A and
+  strings in RET. A function that calls others may be re-entered through
+  recursion, so it pushes the locations holding values live across its
+  calls on entry and pulls them back on return; leaf functions save
+  nothing.
+*/
+class FunctionGenerator
+{
+public:
+    FunctionGenerator(const AstArena &ast, const SymbolTable &symbols, std::string_view source, const FunctionInfo &function,
+                      const CodegenOptions &options)
+        : ast(ast), symbols(symbols), source(source), function(function), options(options)
+    {
+    }
+
+    FunctionCode generate();
+
+private:
+    const AstArena &ast;
+    const SymbolTable &symbols;
+    std::string_view source;
+    const FunctionInfo &function;
+    const CodegenOptions &options;
+
+    FunctionCode result;
+    std::vector<Instr> body;
+    std::vector<uint32_t> pinned; // frame bytes whose address is taken
+    uint32_t labels = 0;
+    uint32_t returnLabel = 0;
+    uint32_t tempTop = 0;
+    uint32_t tempMax = 0;
+    bool callsFunctions = false;
+
+    void emit(Op op, Operand operand = {}) { body.push_back({op, operand}); }
+    uint32_t newLabel() { return labels++; }
+    void placeLabel(uint32_t label) { emit(Op::Label, {OperandKind::Label, label}); }
+    void jump(Op op, uint32_t label) { emit(op, {OperandKind::Label, label}); }
+
+    uint32_t allocTemp(uint32_t width);
+    void freeTemp(uint32_t width) { tempTop -= width; }
+
+    const Symbol &symbolOf(NodeIndex identifier) const { return symbols.symbol(ast.node(identifier).c); }
+    bool simpleOperand(NodeIndex expression, Operand &operand) const;
+    Operand rightOperand(NodeIndex expression, uint32_t &tempWidth);
+
+    void genStatement(NodeIndex statement);
+    void genValue(NodeIndex expression);
+    void genString(NodeIndex expression, Operand destination);
+    void genCondition(NodeIndex expression, uint32_t falseLabel);
+    void genCall(NodeIndex call);
+    void loadY(NodeIndex expression);
+};
+
+uint32_t FunctionGenerator::allocTemp(uint32_t width)
+{
+    uint32_t offset = function.frameSize + tempTop;
+    tempTop += width;
+    tempMax = std::max(tempMax, tempTop);
+    return offset;
+}
+
+// A literal or a one-byte variable can be used in place
+bool FunctionGenerator::simpleOperand(NodeIndex expression, Operand &operand) const
+{
+    const AstNode &node = ast.node(expression);
+    if (isConstant(node))
+    {
+        operand = immediate(node.a);
+        return true;
+    }
+    if (node.kind == NodeKind::Identifier && valueWidth(symbolOf(expression).type) == 1)
+    {
+        operand = frameByte(symbolOf(expression).slot);
+        return true;
+    }
+    return false;
+}
+
+// The right operand of a binary operator, spilled to a temporary unless simple;
+// evaluated first so the left one can end in A
+Operand FunctionGenerator::rightOperand(NodeIndex expression, uint32_t &tempWidth)
+{
+    Operand operand;
+    tempWidth = 0;
+    if (simpleOperand(expression, operand))
+        return operand;
+
+    genValue(expression);
+    tempWidth = 1;
+    operand = frameByte(allocTemp(1));
+    emit(Op::STA, operand);
+    return operand;
+}
+
+void FunctionGenerator::loadY(NodeIndex expression)
+{
+    Operand operand;
+    if (simpleOperand(expression, operand))
+    {
+        emit(Op::LDY, operand);
+        return;
+    }
+    genValue(expression);
+    Operand temp = frameByte(allocTemp(1));
+    emit(Op::STA, temp);
+    emit(Op::LDY, temp);
+    freeTemp(1);
+}
+
+void FunctionGenerator::genValue(NodeIndex expression)
+{
+    const AstNode &node = ast.node(expression);
+    switch (node.kind)
+    {
+    case NodeKind::Number:
+    case NodeKind::CharLit:
+        emit(Op::LDA, immediate(node.a));
+        break;
+
+    case NodeKind::Identifier:
+        emit(Op::LDA, frameByte(symbolOf(expression).slot));
+        break;
+
+    case NodeKind::Call:
+        genCall(expression);
+        break;
+
+    case NodeKind::Unary:
+        // -x == (x ^ 0xff) + 1
+        genValue(node.a);
+        emit(Op::EOR, immediate(0xff));
+        emit(Op::CLC);
+        emit(Op::ADC, immediate(1));
+        break;
+
+    case NodeKind::Binary:
+        switch (node.op)
+        {
+        case Operator::Add:
+        case Operator::Sub:
+        {
+            uint32_t tempWidth;
+            Operand right = rightOperand(node.b, tempWidth);
+            genValue(node.a);
+            emit(node.op == Operator::Add ? Op::CLC : Op::SEC);
+            emit(node.op == Operator::Add ? Op::ADC : Op::SBC, right);
+            freeTemp(tempWidth);
+            break;
+        }
+
+        case Operator::Mul:
+        case Operator::Div:
+        {
+            uint32_t tempWidth;
+            Operand right = rightOperand(node.b, tempWidth);
+            genValue(node.a);
+            emit(Op::STA, fixedAddress(MUL_LEFT));
+            emit(Op::LDA, right);
+            emit(Op::STA, fixedAddress(MUL_RIGHT));
+            RuntimeRoutine routine = node.op == Operator::Mul ? RuntimeRoutine::Multiply : RuntimeRoutine::Divide;
+            emit(Op::JSR, {OperandKind::Runtime, static_cast<uint32_t>(routine)});
+            freeTemp(tempWidth);
+            break;
+        }
+
+        default:
+        {
+            // A comparison used as a value: 1 or 0
+            uint32_t falseLabel = newLabel();
+            uint32_t endLabel = newLabel();
+            genCondition(expression, falseLabel);
+            emit(Op::LDA, immediate(1));
+            jump(Op::JMP, endLabel);
+            placeLabel(falseLabel);
+            emit(Op::LDA, immediate(0));
+            placeLabel(endLabel);
+            break;
+        }
+        }
+        break;
+
+    default:
+        throw std::logic_error("genValue: not a one-byte expression");
+    }
+}
+
+// Store a string (or &x) into the two bytes at destination
+void FunctionGenerator::genString(NodeIndex expression, Operand destination)
+{
+    const AstNode &node = ast.node(expression);
+    switch (node.kind)
+    {
+    case NodeKind::StringLit:
+    {
+        uint32_t id = static_cast<uint32_t>(result.strings.size());
+        result.strings.push_back(source.substr(node.a, node.b));
+        emit(Op::LDA, {OperandKind::StringLo, id});
+        emit(Op::STA, destination);
+        emit(Op::LDA, {OperandKind::StringHi, id});
+        emit(Op::STA, highByte(destination));
+        break;
+    }
+
+    case NodeKind::Identifier:
+    {
+        Operand source = frameByte(symbolOf(expression).slot);
+        emit(Op::LDA, source);
+        emit(Op::STA, destination);
+        emit(Op::LDA, highByte(source));
+        emit(Op::STA, highByte(destination));
+        break;
+    }
+
+    case NodeKind::Unary:
+    {
+        const Symbol &variable = symbolOf(node.a);
+        uint32_t slot = variable.slot;
+        for (uint32_t byte = 0; byte < valueWidth(variable.type); ++byte)
+        {
+            pinned.push_back(slot + byte);
+        }
+        emit(Op::LDA, {OperandKind::FrameLo, slot});
+        emit(Op::STA, destination);
+        emit(Op::LDA, {OperandKind::FrameHi, slot});
+        emit(Op::STA, highByte(destination));
+        break;
+    }
+
+    case NodeKind::Alloc:
+        loadY(node.a);
+        emit(Op::LDX, immediate(SYS_ALLOC));
+        emit(Op::SYS);
+        emit(Op::STY, destination);
+        emit(Op::STA, highByte(destination));
+        break;
+
+    case NodeKind::Call:
+        genCall(expression);
+        emit(Op::LDA, fixedAddress(RET_ADDRESS));
+        emit(Op::STA, destination);
+        emit(Op::LDA, fixedAddress(RET_ADDRESS + 1));
+        emit(Op::STA, highByte(destination));
+        break;
+
+    default:
+        throw std::logic_error("genString: not a string expression");
+    }
+}
+
+// Branch to falseLabel when the expression is 0; fall through otherwise
+void FunctionGenerator::genCondition(NodeIndex expression, uint32_t falseLabel)
+{
+    const AstNode &node = ast.node(expression);
+    if (isConstant(node))
+    {
+        if ((node.a & 0xff) == 0)
+            jump(Op::JMP, falseLabel);
+        return;
+    }
+
+    if (node.kind == NodeKind::Binary)
+    {
+        // CMP sets C when A >= operand (unsigned) and Z when they are equal;
+        // > and <= swap the operands to become < and >=
+        NodeIndex left = node.a;
+        NodeIndex right = node.b;
+        Op branch = Op::NOP;
+        switch (node.op)
+        {
+        case Operator::Equal:
+            branch = Op::BNE;
+            break;
+        case Operator::NotEqual:
+            branch = Op::BEQ;
+            break;
+        case Operator::Less:
+            branch = Op::BCS;
+            break;
+        case Operator::GreaterEqual:
+            branch = Op::BCC;
+            break;
+        case Operator::Greater:
+            std::swap(left, right);
+            branch = Op::BCS;
+            break;
+        case Operator::LessEqual:
+            std::swap(left, right);
+            branch = Op::BCC;
+            break;
+        default:
+            break;
+        }
+
+        if (branch != Op::NOP)
+        {
+            uint32_t tempWidth;
+            Operand operand = rightOperand(right, tempWidth);
+            genValue(left);
+            emit(Op::CMP, operand);
+            jump(branch, falseLabel);
+            freeTemp(tempWidth);
+            return;
+        }
+    }
+
+    genValue(expression);
+    emit(Op::CMP, immediate(0));
+    jump(Op::BEQ, falseLabel);
+}
+
+void FunctionGenerator::genCall(NodeIndex call)
+{
+    const AstNode &node = ast.node(call);
+    const Symbol &callee = symbolOf(node.a);
+    NodeList args = ast.list(node.b);
+    NodeList params = ast.list(ast.node(callee.decl).b);
+
+    // A call among the arguments would overwrite the ARG area, so then every
+    // argument is evaluated into temporaries first
+    bool nestedCall = false;
+    uint32_t argBytes = 0;
+    for (uint32_t i = 0; i < args.count; ++i)
+    {
+        nestedCall = nestedCall || hasSideEffects(ast, args[i]);
+        argBytes += valueWidth(ast.node(params[i]).type);
+    }
+
+    uint32_t base = nestedCall ? allocTemp(argBytes) : 0;
+    uint32_t offset = 0;
+    for (uint32_t i = 0; i < args.count; ++i)
+    {
+        Operand destination = nestedCall ? frameByte(base + offset) : fixedAddress(ARG_ADDRESS + offset);
+        if (ast.node(params[i]).type == ValueType::String)
+        {
+            genString(args[i], destination);
+            offset += 2;
+        }
+        else
+        {
+            genValue(args[i]);
+            emit(Op::STA, destination);
+            offset += 1;
+        }
+    }
+
+    if (nestedCall)
+    {
+        for (uint32_t byte = 0; byte < argBytes; ++byte)
+        {
+            emit(Op::LDA, frameByte(base + byte));
+            emit(Op::STA, fixedAddress(ARG_ADDRESS + byte));
+        }
+        freeTemp(argBytes);
+    }
+
+    emit(Op::JSR, {OperandKind::Function, callee.slot});
+    callsFunctions = true;
+}
+
+void FunctionGenerator::genStatement(NodeIndex statement)
+{
+    const AstNode &node = ast.node(statement);
+    switch (node.kind)
+    {
+    case NodeKind::Block:
+        for (NodeIndex child : ast.list(node.a))
+        {
+            genStatement(child);
+        }
+        break;
+
+    case NodeKind::VarDecl:
+    case NodeKind::Assign:
+    {
+        const Symbol &target = symbolOf(node.a);
+        if (target.type == ValueType::String)
+            genString(node.b, frameByte(target.slot));
+        else
+        {
+            genValue(node.b);
+            emit(Op::STA, frameByte(target.slot));
+        }
+        break;
+    }
+
+    case NodeKind::Return:
+        if (node.a != NO_NODE)
+        {
+            if (ast.node(node.a).type == ValueType::String)
+                genString(node.a, fixedAddress(RET_ADDRESS));
+            else
+                genValue(node.a);
+        }
+        jump(Op::JMP, returnLabel);
+        break;
+
+    case NodeKind::While:
+    {
+        uint32_t top = newLabel();
+        uint32_t end = newLabel();
+        placeLabel(top);
+        genCondition(node.a, end);
+        genStatement(node.b);
+        jump(Op::JMP, top);
+        placeLabel(end);
+        break;
+    }
+
+    case NodeKind::If:
+    {
+        uint32_t elseLabel = newLabel();
+        genCondition(node.a, elseLabel);
+        genStatement(node.b);
+        if (node.c != NO_NODE)
+        {
+            uint32_t end = newLabel();
+            jump(Op::JMP, end);
+            placeLabel(elseLabel);
+            genStatement(node.c);
+            placeLabel(end);
+        }
+        else
+            placeLabel(elseLabel);
+        break;
+    }
+
+    case NodeKind::Print:
+    {
+        const AstNode &value = ast.node(node.a);
+        if (value.type == ValueType::String)
+        {
+            if (value.kind == NodeKind::StringLit)
+            {
+                // The address is a link-time constant: no need for a temp
+                uint32_t id = static_cast<uint32_t>(result.strings.size());
+                result.strings.push_back(source.substr(value.a, value.b));
+                emit(Op::LDY, {OperandKind::StringLo, id});
+                emit(Op::LDA, {OperandKind::StringHi, id});
+            }
+            else if (value.kind == NodeKind::Identifier)
+            {
+                Operand address = frameByte(symbolOf(node.a).slot);
+                emit(Op::LDY, address);
+                emit(Op::LDA, highByte(address));
+            }
+            else
+            {
+                Operand address = frameByte(allocTemp(2));
+                genString(node.a, address);
+                emit(Op::LDY, address);
+                emit(Op::LDA, highByte(address));
+                freeTemp(2);
+            }
+            emit(Op::LDX, immediate(SYS_PRINT_STR));
+        }
+        else
+        {
+            loadY(node.a);
+            emit(Op::LDX, immediate(value.type == ValueType::Char ? SYS_PRINT_CHAR : SYS_PRINT_INT));
+        }
+        emit(Op::SYS);
+        break;
+    }
+
+    case NodeKind::Free:
+    {
+        Operand address = frameByte(symbolOf(node.a).slot);
+        emit(Op::LDY, address);
+        emit(Op::LDA, highByte(address));
+        emit(Op::LDX, immediate(SYS_FREE));
+        emit(Op::SYS);
+        break;
+    }
+
+    case NodeKind::ExprStmt:
+    {
+        const AstNode &value = ast.node(node.a);
+        if (value.kind == NodeKind::Call)
+            genCall(node.a);
+        else if (!hasSideEffects(ast, node.a))
+            break;
+        else if (value.type == ValueType::String)
+        {
+            genString(node.a, frameByte(allocTemp(2)));
+            freeTemp(2);
+        }
+        else
+            genValue(node.a);
+        break;
+    }
+
+    default:
+        throw std::logic_error("genStatement: unexpected node");
+    }
+}
+
+FunctionCode FunctionGenerator::generate()
+{
+    const AstNode &node = ast.node(function.node);
+    ValueType returnType = node.type;
+    returnLabel = newLabel();
+    genStatement(node.c);
+
+    // Take the arguments, then the body; the frame is laid out over both
+    uint32_t frameSize = function.frameSize + tempMax;
+    std::vector<Instr> inner;
+    inner.reserve(2 * function.paramBytes + body.size() + 1);
+    for (uint32_t byte = 0; byte < function.paramBytes; ++byte)
+    {
+        inner.push_back({Op::LDA, fixedAddress(ARG_ADDRESS + byte)});
+        inner.push_back({Op::STA, frameByte(byte)});
+    }
+    inner.insert(inner.end(), body.begin(), body.end());
+    inner.push_back({Op::Label, {OperandKind::Label, returnLabel}});
+
+    FrameLayout layout =
+        options.optimize
+            ? allocateFrame(inner, frameSize, pinned, function.recursive ? ZP_SAVED_BYTES : NONRECURSIVE_SAVED_BYTES)
+            : identityLayout(frameSize);
+    applyLayout(inner, layout);
+
+    // The zero-page pool is shared by every function, the frame only by
+    // the activations of this one
+    std::vector<Operand> saved;
+    if (callsFunctions)
+    {
+        for (const Operand &location : layout.saved)
+        {
+            if (location.kind == OperandKind::Fixed || function.recursive)
+                saved.push_back(location);
+        }
+    }
+
+    std::vector<Instr> &code = result.code;
+    code.reserve(inner.size() + 4 * saved.size() + 4);
+
+    // A recursive function first checks that the stack has room for what
+    // it and its calls push until the next check (linker.hpp)
+    uint32_t overflowLabel = newLabel();
+    if (function.recursive)
+    {
+        code.push_back({Op::TSX, {}});
+        code.push_back({Op::CPX, {OperandKind::StackCheck, 0}});
+        code.push_back({Op::BCC, {OperandKind::Label, overflowLabel}});
+    }
+
+    // Prologue: save what an active call of this function still needs
+    for (const Operand &location : saved)
+    {
+        code.push_back({Op::LDA, location});
+        code.push_back({Op::PHA, {}});
+    }
+    code.insert(code.end(), inner.begin(), inner.end());
+
+    // Epilogue: restore it without losing an int result in A
+    if (!saved.empty())
+    {
+        bool keepA = returnType != ValueType::Void && returnType != ValueType::String;
+        if (keepA)
+            code.push_back({Op::STA, fixedAddress(RET_ADDRESS)});
+        for (size_t i = saved.size(); i-- > 0;)
+        {
+            code.push_back({Op::PLA, {}});
+            code.push_back({Op::STA, saved[i]});
+        }
+        if (keepA)
+            code.push_back({Op::LDA, fixedAddress(RET_ADDRESS)});
+    }
+    code.push_back({Op::RTS, {}});
+
+    // The routine never returns, so its return address is never needed
+    if (function.recursive)
+    {
+        code.push_back({Op::Label, {OperandKind::Label, overflowLabel}});
+        code.push_back({Op::JSR, {OperandKind::Runtime, static_cast<uint32_t>(RuntimeRoutine::StackOverflow)}});
+    }
+
+    result.frameSize = layout.frameSize;
+    result.savedBytes = static_cast<uint32_t>(saved.size());
+    result.recursive = function.recursive;
+    return std::move(result);
+}
+
+FunctionCode generateFunction(const AstArena &ast, const SymbolTable &symbols, std::string_view source,
+                              const FunctionInfo &function, const CodegenOptions &options)
+{
+    FunctionGenerator generator(ast, symbols, source, function, options);
+    FunctionCode code = generator.generate();
+    if (options.optimize)
+        peephole(code.code);
+    return code;
+}
+
+// -----------------------------
+// Runtime routines
+// -----------------------------
+
+FunctionCode generateRuntime(RuntimeRoutine routine)
+{
+    FunctionCode function;
+    std::vector<Instr> &code = function.code;
+    Operand left = fixedAddress(MUL_LEFT);
+    Operand right = fixedAddress(MUL_RIGHT);
+    Operand quotient = fixedAddress(DIV_QUOTIENT);
+    Operand loop{OperandKind::Label, 0};
+    Operand done{OperandKind::Label, 1};
+
+    if (routine == RuntimeRoutine::Multiply)
+    {
+        // Repeated addition: at most 255 rounds on an 8-bit machine
+        code = {
+            {Op::LDA, immediate(0)},
+            {Op::Label, loop},
+            {Op::LDX, right},
+            {Op::BEQ, done},
+            {Op::CLC, {}},
+            {Op::ADC, left},
+            {Op::DEC, right},
+            {Op::JMP, loop},
+            {Op::Label, done},
+            {Op::RTS, {}},
+        };
+    }
+    else if (routine == RuntimeRoutine::Divide)
+    {
+        // Repeated subtraction; dividing by zero gives 0
+        code = {
+            {Op::LDA, immediate(0)},
+            {Op::STA, quotient},
+            {Op::LDA, right},
+            {Op::BEQ, done},
+            {Op::LDA, left},
+            {Op::Label, loop},
+            {Op::CMP, right},
+            {Op::BCC, done},
+            {Op::SEC, {}},
+            {Op::SBC, right},
+            {Op::INC, quotient},
+            {Op::JMP, loop},
+            {Op::Label, done},
+            {Op::LDA, quotient},
+            {Op::RTS, {}},
+        };
+    }
+    else
+    {
+        function.strings.push_back("stack overflow");
+        code = {
+            {Op::LDY, {OperandKind::StringLo, 0}},
+            {Op::LDA, {OperandKind::StringHi, 0}},
+            {Op::LDX, immediate(SYS_PRINT_STR)},
+            {Op::SYS, {}},
+            {Op::BRK, {}},
+        };
+    }
+    return function;
+}
+
+const char *runtimeName(RuntimeRoutine routine)
+{
+    static const char *const NAMES[] = {"__mul", "__div", "__stack_overflow"};
+    return NAMES[static_cast<uint32_t>(routine)];
+}
+
+// -----------------------------
+// Peephole optimizer
+// -----------------------------
+
+// Registers and flags an instruction reads or writes
+enum : uint8_t
+{
+    REG_A = 1,
+    REG_X = 2,
+    REG_Y = 4,
+    FLAG_C = 8,
+    FLAG_NZ = 16,
+    ALL_REGS = 31,
+};
+
+struct Effect
+{
+    uint8_t reads;
+    uint8_t writes;
+};
+
+static Effect effectOf(Op op)
+{
+    switch (op)
+    {
+    case Op::LDA:
+    case Op::PLA:
+        return {0, REG_A | FLAG_NZ};
+    case Op::LDX:
+        return {0, REG_X | FLAG_NZ};
+    case Op::LDY:
+        return {0, REG_Y | FLAG_NZ};
+    case Op::STA:
+    case Op::PHA:
+        return {REG_A, 0};
+    case Op::STX:
+    case Op::TXS:
+        return {REG_X, 0};
+    case Op::STY:
+        return {REG_Y, 0};
+    case Op::ADC:
+    case Op::SBC:
+        return {REG_A | FLAG_C, REG_A | FLAG_C | FLAG_NZ};
+    case Op::INC:
+    case Op::DEC:
+        return {0, FLAG_NZ};
+    case Op::CMP:
+        return {REG_A, FLAG_C | FLAG_NZ};
+    case Op::CPX:
+        return {REG_X, FLAG_C | FLAG_NZ};
+    case Op::CPY:
+        return {REG_Y, FLAG_C | FLAG_NZ};
+    case Op::AND:
+    case Op::ORA:
+    case Op::EOR:
+        return {REG_A, REG_A | FLAG_NZ};
+    case Op::BNE:
+    case Op::BEQ:
+    case Op::BMI:
+    case Op::BPL:
+        return {FLAG_NZ, 0};
+    case Op::BCC:
+    case Op::BCS:
+        return {FLAG_C, 0};
+    case Op::PHP:
+        return {FLAG_C | FLAG_NZ, 0};
+    case Op::PLP:
+        return {0, FLAG_C | FLAG_NZ};
+    case Op::TSX:
+        return {0, REG_X | FLAG_NZ};
+    case Op::CLC:
+    case Op::SEC:
+        return {0, FLAG_C};
+    case Op::JSR:
+        return {0, ALL_REGS};
+    case Op::RTS:
+        return {REG_A, 0};
+    case Op::SYS:
+        return {REG_A | REG_X | REG_Y, ALL_REGS};
+    default:
+        return {0, 0};
+    }
+}
+
+static bool isBranch(Op op)
+{
+    switch (op)
+    {
+    case Op::BNE:
+    case Op::BEQ:
+    case Op::BCC:
+    case Op::BCS:
+    case Op::BMI:
+    case Op::BPL:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static bool isStore(Op op)
+{
+    return op == Op::STA || op == Op::STX || op == Op::STY;
+}
+
+static bool isMemory(const Operand &operand)
+{
+    return operand.kind == OperandKind::Frame || operand.kind == OperandKind::Fixed;
+}
+
+// How far the liveness scans look before giving up (and keeping the code)
+static constexpr size_t SCAN_LIMIT = 64;
+
+class Peephole
+{
+public:
+    explicit Peephole(std::vector<Instr> &code) : code(code) {}
+    size_t run();
+
+private:
+    std::vector<Instr> &code;
+    std::vector<bool> removed;
+    std::unordered_map<uint32_t, size_t> labelAt;
+
+    void indexLabels();
+    bool regsDead(size_t from, uint8_t regs, int hops = 4) const;
+    bool memoryDead(size_t from, const Operand &location) const;
+    size_t compact();
+
+    void redundantLoads();
+    void deadStores();
+    void controlFlow();
+    void noOps();
+};
+
+void Peephole::indexLabels()
+{
+    labelAt.clear();
+    for (size_t i = 0; i < code.size(); ++i)
+    {
+        if (code[i].op == Op::Label)
+            labelAt[code[i].operand.value] = i;
+    }
+}
+
+// True if none of regs is read after instruction from before being written,
+// following jumps and both sides of branches for a few hops
+bool Peephole::regsDead(size_t from, uint8_t regs, int hops) const
+{
+    size_t limit = std::min(code.size(), from + 1 + SCAN_LIMIT);
+    for (size_t i = from + 1; i < limit; ++i)
+    {
+        Op op = code[i].op;
+        if (op == Op::Label)
+            continue;
+
+        Effect effect = effectOf(op);
+        if (effect.reads & regs)
+            return false;
+        if (op == Op::JSR || op == Op::BRK)
+            return true; // callees read arguments from memory only
+        if (op == Op::RTS)
+            return true;
+        if (op == Op::JMP || isBranch(op))
+        {
+            if (hops == 0)
+                return false;
+            auto target = labelAt.find(code[i].operand.value);
+            if (target == labelAt.end() || !regsDead(target->second, regs, hops - 1))
+                return false;
+            if (op == Op::JMP)
+                return true;
+            continue;
+        }
+
+        regs &= static_cast<uint8_t>(~effect.writes);
+        if (regs == 0)
+            return true;
+    }
+    return limit == code.size();
+}
+
+// True if location is written before it is read on the straight-line path
+// after instruction from
+bool Peephole::memoryDead(size_t from, const Operand &location) const
+{
+    size_t limit = std::min(code.size(), from + 1 + SCAN_LIMIT);
+    for (size_t i = from + 1; i < limit; ++i)
+    {
+        const Instr &instr = code[i];
+        if (instr.op == Op::Label)
+            continue;
+        if (instr.operand == location)
+            return isStore(instr.op);
+        if (instr.op == Op::JMP || instr.op == Op::JSR || instr.op == Op::RTS || instr.op == Op::SYS ||
+            instr.op == Op::BRK || isBranch(instr.op))
+            return false;
+    }
+    return false;
+}
+
+size_t Peephole::compact()
+{
+    size_t kept = 0;
+    for (size_t i = 0; i < code.size(); ++i)
+    {
+        if (!removed[i])
+            code[kept++] = code[i];
+    }
+    size_t count = code.size() - kept;
+    code.resize(kept);
+    removed.assign(code.size(), false);
+    return count;
+}
+
+// Track what A holds and whether N/Z reflect it; drop loads of the same value
+void Peephole::redundantLoads()
+{
+    Operand holds;
+    bool flagsFromA = false;
+
+    for (size_t i = 0; i < code.size(); ++i)
+    {
+        const Instr &instr = code[i];
+        switch (instr.op)
+        {
+        case Op::LDA:
+            if (holds.kind != OperandKind::None && holds == instr.operand && (flagsFromA || regsDead(i, FLAG_NZ)))
+            {
+                removed[i] = true;
+                break;
+            }
+            holds = instr.operand;
+            flagsFromA = true;
+            break;
+
+        case Op::STA:
+            // A was loaded from here or just stored here
+            if (holds == instr.operand && isMemory(instr.operand))
+            {
+                removed[i] = true;
+                break;
+            }
+            holds = instr.operand;
+            break;
+
+        case Op::CMP:
+            // After an instruction that set N and Z from A, CMP #0 only sets C
+            if (instr.operand == immediate(0) && flagsFromA && regsDead(i, FLAG_C))
+            {
+                removed[i] = true;
+                break;
+            }
+            flagsFromA = false;
+            break;
+
+        case Op::STX:
+        case Op::STY:
+        case Op::INC:
+        case Op::DEC:
+            if (holds == instr.operand)
+                holds = {};
+            if (instr.op == Op::INC || instr.op == Op::DEC)
+                flagsFromA = false;
+            break;
+
+        case Op::ADC:
+        case Op::SBC:
+        case Op::AND:
+        case Op::ORA:
+        case Op::EOR:
+        case Op::PLA:
+            holds = {};
+            flagsFromA = true;
+            break;
+
+        case Op::LDX:
+        case Op::LDY:
+        case Op::CPX:
+        case Op::CPY:
+        case Op::TSX:
+        case Op::PLP:
+            flagsFromA = false;
+            break;
+
+        case Op::Label:
+        case Op::JSR:
+        case Op::SYS:
+        case Op::JMP:
+        case Op::RTS:
+            holds = {};
+            flagsFromA = false;
+            break;
+
+        default:
+            break;
+        }
+    }
+}
+
+void Peephole::deadStores()
+{
+    for (size_t i = 0; i < code.size(); ++i)
+    {
+        if (isStore(code[i].op) && isMemory(code[i].operand) && memoryDead(i, code[i].operand))
+            removed[i] = true;
+    }
+}
+
+void Peephole::controlFlow()
+{
+    for (size_t i = 0; i < code.size(); ++i)
+    {
+        Op op = code[i].op;
+
+        // Jumps and branches to the next instruction
+        if (op == Op::JMP || isBranch(op))
+        {
+            for (size_t j = i + 1; j < code.size() && code[j].op == Op::Label; ++j)
+            {
+                if (code[j].operand.value == code[i].operand.value)
+                {
+                    removed[i] = true;
+                    break;
+                }
+            }
+        }
+
+        // Nothing after an unconditional transfer runs until the next label
+        if (op == Op::JMP || op == Op::RTS)
+        {
+            for (size_t j = i + 1; j < code.size() && code[j].op != Op::Label; ++j)
+            {
+                removed[j] = true;
+            }
+        }
+    }
+}
+
+void Peephole::noOps()
+{
+    for (size_t i = 0; i < code.size(); ++i)
+    {
+        if (removed[i])
+            continue;
+        const Instr &instr = code[i];
+
+        // CLC; ADC #0 and SEC; SBC #0 leave A alone
+        if ((instr.op == Op::CLC || instr.op == Op::SEC) && i + 1 < code.size())
+        {
+            Op arithmetic = instr.op == Op::CLC ? Op::ADC : Op::SBC;
+            if (code[i + 1].op == arithmetic && code[i + 1].operand == immediate(0) && regsDead(i + 1, FLAG_C | FLAG_NZ))
+            {
+                removed[i] = removed[i + 1] = true;
+                continue;
+            }
+        }
+
+        // ORA #0, EOR #0, AND #$FF only set N and Z
+        if ((instr.op == Op::ORA && instr.operand == immediate(0)) || (instr.op == Op::EOR && instr.operand == immediate(0)) ||
+            (instr.op == Op::AND && instr.operand == immediate(0xff)))
+        {
+            if (regsDead(i, FLAG_NZ))
+                removed[i] = true;
+            continue;
+        }
+
+        // LDA m; CLC; ADC #1; STA m  ->  INC m  (and SEC; SBC #1 -> DEC m)
+        if (instr.op == Op::LDA && isMemory(instr.operand) && i + 3 < code.size())
+        {
+            const Instr &carry = code[i + 1];
+            const Instr &arithmetic = code[i + 2];
+            const Instr &store = code[i + 3];
+            bool increment = carry.op == Op::CLC && arithmetic.op == Op::ADC;
+            bool decrement = carry.op == Op::SEC && arithmetic.op == Op::SBC;
+            if ((increment || decrement) && arithmetic.operand == immediate(1) && store.op == Op::STA &&
+                store.operand == instr.operand && !removed[i + 1] && !removed[i + 2] && !removed[i + 3] &&
+                regsDead(i + 3, REG_A | FLAG_C))
+            {
+                code[i] = {increment ? Op::INC : Op::DEC, instr.operand};
+                removed[i + 1] = removed[i + 2] = removed[i + 3] = true;
+            }
+        }
+    }
+}
+
+size_t Peephole::run()
+{
+    size_t total = 0;
+    removed.assign(code.size(), false);
+    while (true)
+    {
+        size_t before = total;
+
+        indexLabels();
+        redundantLoads();
+        total += compact();
+
+        indexLabels();
+        deadStores();
+        total += compact();
+
+        controlFlow();
+        total += compact();
+
+        indexLabels();
+        noOps();
+        total += compact();
+
+        if (total == before)
+            return total;
+    }
+}
+
+size_t peephole(std::vector<Instr> &code)
+{
+    return Peephole(code).run();
+}
+
+// -----------------------------
+// Listing
+// -----------------------------
+
+static std::string hex(uint32_t value, int digits)
+{
+    static const char digitsHex[] = "0123456789ABCDEF";
+    std::string text(digits, '0');
+    for (int i = digits - 1; i >= 0; --i, value >>= 4)
+    {
+        text[i] = digitsHex[value & 0xf];
+    }
+    return text;
+}
+
+std::string formatCode(const FunctionCode &function)
+{
+    std::string out;
+    for (const Instr &instr : function.code)
+    {
+        if (instr.op == Op::Label)
+        {
+            out += "L" + std::to_string(instr.operand.value) + ":\n";
+            continue;
+        }
+
+        out += "    ";
+        out += opName(instr.op);
+        const Operand &operand = instr.operand;
+        switch (operand.kind)
+        {
+        case OperandKind::Immediate:
+            out += " #$" + hex(operand.value, 2);
+            break;
+        case OperandKind::Fixed:
+            out += " $" + hex(operand.value, operand.value < 0x100 ? 2 : 4);
+            break;
+        case OperandKind::Frame:
+            out += " frame+" + std::to_string(operand.value);
+            break;
+        case OperandKind::FrameLo:
+        case OperandKind::FrameHi:
+            out += std::string(operand.kind == OperandKind::FrameLo ? " #<" : " #>") + "frame+" + std::to_string(operand.value);
+            break;
+        case OperandKind::StringLo:
+        case OperandKind::StringHi:
+            out += std::string(operand.kind == OperandKind::StringLo ? " #<" : " #>") + "str" + std::to_string(operand.value);
+            break;
+        case OperandKind::StackCheck:
+            out += " #stack";
+            break;
+        case OperandKind::Label:
+            out += " L" + std::to_string(operand.value);
+            break;
+        case OperandKind::Function:
+            out += " func" + std::to_string(operand.value);
+            break;
+        case OperandKind::Runtime:
+            out += std::string(" ") + runtimeName(static_cast<RuntimeRoutine>(operand.value));
+            break;
+        default:
+            break;
+        }
+        out += "\n";
+    }
+    return out;
+}
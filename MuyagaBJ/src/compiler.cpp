@@ -0,0 +1,267 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include "../include/compiler.hpp"
+#include "../include/lexer.hpp"
+#include "../include/object_cache.hpp"
+
+namespace fs = std::filesystem;
+
+/*----- Helper: namedFunctions() -----*/
+// Indices of the declared functions whose names appear in the body of the
+// function spanning text: every function it calls, and perhaps a few it
+// only shadows
+static std::vector<uint32_t> namedFunctions(std::string_view text, const StringInterner &names,
+                                            const SymbolTable &symbols)
+{
+    std::vector<uint32_t> named;
+    Lexer lexer(text);
+    bool seenOwnName = false;
+    for (Token token = lexer.nextToken(); token.type != TokenType::EndOfFile; token = lexer.nextToken())
+    {
+        if (token.type != TokenType::Identifier)
+            continue;
+        // The first name is the function's own, in its declaration
+        if (!seenOwnName)
+        {
+            seenOwnName = true;
+            continue;
+        }
+        NameId name = names.find(token.lexeme);
+        uint32_t symbol = name == NO_NAME ? NO_SYMBOL : symbols.lookup(name);
+        if (symbol == NO_SYMBOL || symbols.symbol(symbol).kind != SymbolKind::Function)
+            continue;
+        uint32_t index = symbols.symbol(symbol).slot;
+        if (std::find(named.begin(), named.end(), index) == named.end())
+            named.push_back(index);
+    }
+    return named;
+}
+
+/*----- Helper: markRecursive() -----*/
+// Flag the functions on a cycle of calls: a self-call, or a strongly
+// connected component of more than one function (Tarjan's algorithm, with
+// an explicit stack so a long chain of calls cannot exhaust the native one)
+static void markRecursive(std::vector<FunctionInfo> &functions, const std::vector<std::vector<uint32_t>> &calls)
+{
+    const uint32_t count = static_cast<uint32_t>(functions.size());
+    constexpr uint32_t UNVISITED = UINT32_MAX;
+    std::vector<uint32_t> order(count, UNVISITED); // visit number
+    std::vector<uint32_t> low(count);              // least visit number reachable
+    std::vector<bool> onStack(count, false);
+    std::vector<uint32_t> component;
+    std::vector<std::pair<uint32_t, uint32_t>> path; // function, next call to follow
+    uint32_t visited = 0;
+
+    auto visit = [&](uint32_t function)
+    {
+        order[function] = low[function] = visited++;
+        component.push_back(function);
+        onStack[function] = true;
+        path.push_back({function, 0});
+    };
+
+    for (uint32_t root = 0; root < count; ++root)
+    {
+        if (order[root] != UNVISITED)
+            continue;
+        visit(root);
+        while (!path.empty())
+        {
+            uint32_t function = path.back().first;
+            if (path.back().second < calls[function].size())
+            {
+                uint32_t callee = calls[function][path.back().second++];
+                if (callee == function)
+                    functions[function].recursive = true;
+                if (order[callee] == UNVISITED)
+                    visit(callee);
+                else if (onStack[callee])
+                    low[function] = std::min(low[function], order[callee]);
+                continue;
+            }
+
+            path.pop_back();
+            if (!path.empty())
+                low[path.back().first] = std::min(low[path.back().first], low[function]);
+            if (low[function] != order[function])
+                continue;
+
+            // function roots a component: everything above it on the stack
+            size_t first = component.size();
+            do
+            {
+                onStack[component[--first]] = false;
+            } while (component[first] != function);
+            if (component.size() - first > 1)
+            {
+                for (size_t i = first; i < component.size(); ++i)
+                {
+                    functions[component[i]].recursive = true;
+                }
+            }
+            component.resize(first);
+        }
+    }
+}
+
+std::vector<MachineFunction> compileFunctions(AstArena &ast, std::string_view source, const StringInterner &names,
+                                              const SymbolTable &symbols, std::vector<FunctionInfo> &functions,
+                                              const CompileOptions &options, CompileStats *stats)
+{
+    const uint32_t count = static_cast<uint32_t>(functions.size());
+    std::vector<MachineFunction> machineCode(count);
+    std::vector<std::string> errors(count);
+
+    // A function's text runs from its func keyword to the next function
+    std::vector<uint32_t> starts;
+    starts.reserve(count + 1);
+    for (const FunctionInfo &function : functions)
+    {
+        starts.push_back(ast.node(function.node).offset);
+    }
+    starts.push_back(static_cast<uint32_t>(source.size()));
+    auto textOf = [&](uint32_t i)
+    { return source.substr(starts[i], starts[i + 1] - starts[i]); };
+
+    // Only a recursive function has to save its frame across its calls
+    std::vector<std::vector<uint32_t>> calls(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        calls[i] = namedFunctions(textOf(i), names, symbols);
+    }
+    markRecursive(functions, calls);
+
+    std::vector<std::string_view> functionNames;
+    bool cached = !options.cacheDir.empty();
+    if (cached)
+    {
+        std::error_code error;
+        fs::create_directories(options.cacheDir, error);
+        for (const FunctionInfo &function : functions)
+        {
+            functionNames.push_back(names.text(symbols.symbol(function.symbol).name));
+        }
+    }
+
+    std::atomic<uint32_t> next{0};
+    std::atomic<uint32_t> firstError{count};
+    std::mutex statsLock;
+
+    auto worker = [&]()
+    {
+        StringInterner localNames = names;
+        SymbolTable localSymbols = symbols;
+        Resolver resolver(ast, source, localNames, localSymbols);
+
+        CompileStats local;
+        // Run one step of one function, adding its time and allocations to into
+        auto measure = [&](PassStats &into, auto &&step)
+        {
+            auto start = std::chrono::steady_clock::now();
+            uint64_t allocationsAtStart = threadAllocationCount();
+            auto result = step();
+            into.milliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            into.allocations += threadAllocationCount() - allocationsAtStart;
+            return result;
+        };
+
+        for (uint32_t i = next.fetch_add(1); i < count; i = next.fetch_add(1))
+        {
+            // Past an error, only an earlier function can change the report
+            if (i > firstError.load(std::memory_order_relaxed))
+                continue;
+
+            std::string key;
+            std::string path;
+            if (cached && measure(local.cache, [&]
+                                  {
+                                      key = functionCacheKey(textOf(i), functions[i].recursive, ast, names,
+                                                             symbols, options.codegen);
+                                      path = (fs::path(options.cacheDir) / objectCacheName(key)).string();
+                                      return loadCachedFunction(path, key, names, symbols, machineCode[i]);
+                                  }))
+            {
+                ++local.cacheHits;
+                continue;
+            }
+
+            FunctionInfo &function = functions[i];
+            try
+            {
+                measure(local.resolve, [&]
+                        {
+                            resolver.resolveFunction(function);
+                            return true;
+                        });
+                measure(local.codegen, [&]
+                        {
+                            if (options.codegen.optimize)
+                                foldConstants(ast, function.node);
+                            machineCode[i] = assembleFunction(generateFunction(ast, localSymbols, source, function, options.codegen));
+                            return true;
+                        });
+                // A failed write only costs a recompile next time
+                if (cached)
+                    measure(local.cache, [&]
+                            { return saveCachedFunction(path, key, machineCode[i], functionNames); });
+            }
+            catch (const std::runtime_error &e)
+            {
+                errors[i] = e.what();
+                // The failed function may have left scopes open
+                localNames = names;
+                localSymbols = symbols;
+                uint32_t seen = firstError.load();
+                while (i < seen && !firstError.compare_exchange_weak(seen, i))
+                {
+                }
+            }
+        }
+
+        if (stats)
+        {
+            std::lock_guard<std::mutex> guard(statsLock);
+            for (auto [into, from] : {std::pair{&stats->resolve, &local.resolve}, std::pair{&stats->codegen, &local.codegen},
+                                      std::pair{&stats->cache, &local.cache}})
+            {
+                into->milliseconds += from->milliseconds;
+                into->allocations += from->allocations;
+            }
+            stats->cacheHits += local.cacheHits;
+        }
+    };
+
+    if (stats)
+    {
+        *stats = CompileStats{};
+        stats->resolve.name = "resolve";
+        stats->codegen.name = "codegen";
+        stats->cache.name = "cache";
+    }
+
+    unsigned workers = static_cast<unsigned>(std::min<size_t>(std::max(1u, options.threads), count));
+    if (workers <= 1)
+        worker();
+    else
+    {
+        std::vector<std::thread> pool;
+        for (unsigned t = 0; t < workers; ++t)
+        {
+            pool.emplace_back(worker);
+        }
+        for (std::thread &t : pool)
+        {
+            t.join();
+        }
+    }
+
+    if (firstError.load() < count)
+        throw std::runtime_error(errors[firstError.load()]);
+    return machineCode;
+}
@@ -0,0 +1,38 @@
+#include <cstddef>
+#include "../include/isa.hpp"
+
+bool encodeOpcode(Op op, AddressMode mode, uint8_t &opcode)
+{
+    for (const Encoding &encoding : ENCODINGS)
+    {
+        if (encoding.op == op && encoding.mode == mode)
+        {
+            opcode = encoding.opcode;
+            return true;
+        }
+    }
+    return false;
+}
+
+const std::array<Decoded, 256> &decodeTable()
+{
+    static const std::array<Decoded, 256> table = []
+    {
+        std::array<Decoded, 256> decoded{};
+        for (const Encoding &encoding : ENCODINGS)
+        {
+            decoded[encoding.opcode] = {true, encoding.op, encoding.mode};
+        }
+        return decoded;
+    }();
+    return table;
+}
+
+const char *opName(Op op)
+{
+    static const char *const names[] = {
+        "LDA", "LDX", "LDY", "STA", "STX", "STY", "ADC", "SBC", "INC", "DEC", "CMP", "CPX", "CPY", "AND",
+        "ORA", "EOR", "BNE", "BEQ", "BCC", "BCS", "BMI", "BPL", "JMP", "JSR", "RTS", "PHA", "PLA", "PHP",
+        "PLP", "TXS", "TSX", "CLC", "SEC", "CLI", "SEI", "CLV", "CLD", "SED", "NOP", "BRK", "SYS", "label"};
+    return names[static_cast<size_t>(op)];
+}
@@ -1,21 +1,232 @@
-#include <vector>
-#include <unordered_map>
+#include <array>
+#include <cassert>
+#include <cstdint>
 #include "../include/token.hpp"
 #include "../include/lexer.hpp"
 
-Lexer::Lexer(std::ifstream &source_file) : sourceCode(source_file) {}
+// -----------------------------
+// Character classes
+// -----------------------------
 
-void Lexer::tokenizeLine(const std::string &lineText)
+// What a byte can start; built at compile time, one load per character
+enum class CharClass : uint8_t
 {
+    Other,
+    Space,
+    Newline,
+    IdentStart,
+    Digit,
+    Quote,
+    DoubleQuote,
+    Slash,
+    Operator, // may be followed by '=': = ! < >
+    Symbol,   // always a single-character token
+};
+
+struct CharTables
+{
+    std::array<CharClass, 256> cls{};
+    std::array<bool, 256> identPart{};
+    std::array<TokenType, 256> symbol{};
+};
+
+constexpr CharTables buildCharTables()
+{
+    CharTables tables;
+    for (int c = 0; c < 256; ++c)
+    {
+        tables.cls[c] = CharClass::Other;
+        tables.symbol[c] = TokenType::Unknown;
+    }
+
+    for (int c = 'a'; c <= 'z'; ++c)
+    {
+        tables.cls[c] = CharClass::IdentStart;
+        tables.cls[c - 'a' + 'A'] = CharClass::IdentStart;
+        tables.identPart[c] = true;
+        tables.identPart[c - 'a' + 'A'] = true;
+    }
+    for (int c = '0'; c <= '9'; ++c)
+    {
+        tables.cls[c] = CharClass::Digit;
+        tables.identPart[c] = true;
+    }
+    tables.cls['_'] = CharClass::IdentStart;
+    tables.identPart['_'] = true;
+
+    tables.cls[' '] = tables.cls['\t'] = tables.cls['\r'] = tables.cls['\v'] = tables.cls['\f'] = CharClass::Space;
+    tables.cls['\n'] = CharClass::Newline;
+    tables.cls['\''] = CharClass::Quote;
+    tables.cls['"'] = CharClass::DoubleQuote;
+    tables.cls['/'] = CharClass::Slash;
+    tables.symbol['/'] = TokenType::Slash;
+
+    tables.cls['='] = tables.cls['!'] = tables.cls['<'] = tables.cls['>'] = CharClass::Operator;
+    tables.symbol['='] = TokenType::Equal;
+    tables.symbol['<'] = TokenType::Less;
+    tables.symbol['>'] = TokenType::Greater;
+
+    const std::pair<char, TokenType> symbols[] = {
+        {'+', TokenType::Plus}, {'-', TokenType::Minus}, {'*', TokenType::Star}, {'&', TokenType::Ampersand}, {'(', TokenType::LParen}, {')', TokenType::RParen}, {'{', TokenType::LBrace}, {'}', TokenType::RBrace}, {',', TokenType::Comma}, {';', TokenType::Semicolon}};
+    for (const auto &[c, type] : symbols)
+    {
+        tables.cls[static_cast<unsigned char>(c)] = CharClass::Symbol;
+        tables.symbol[static_cast<unsigned char>(c)] = type;
+    }
+    return tables;
+}
+
+static constexpr CharTables CHAR_TABLES = buildCharTables();
+
+static inline CharClass classOf(char c)
+{
+    return CHAR_TABLES.cls[static_cast<unsigned char>(c)];
+}
+
+// -----------------------------
+// Lexer
+// -----------------------------
+
+Lexer::Lexer(std::string_view source) : source(source) {}
+
+Token Lexer::makeToken(TokenType type, size_t start) const
+{
+    return Token{source.substr(start, pos - start), type, line, static_cast<int>(start - lineStart) + 1};
+}
+
+/*----- Helper: skipWhitespaceAndComments() -----*/
+void Lexer::skipWhitespaceAndComments()
+{
+    while (pos < source.size())
+    {
+        switch (classOf(source[pos]))
+        {
+        case CharClass::Space:
+            ++pos;
+            break;
+        case CharClass::Newline:
+            ++pos;
+            ++line;
+            lineStart = pos;
+            break;
+        case CharClass::Slash:
+            if (pos + 1 < source.size() && source[pos + 1] == '/')
+            {
+                size_t end = source.find('\n', pos);
+                pos = end == std::string_view::npos ? source.size() : end;
+                break;
+            }
+            return;
+        default:
+            return;
+        }
+    }
+}
+
+/*----- Helper: scanToken() -----*/
+Token Lexer::scanToken()
+{
+    size_t start = pos;
+    char c = source[pos++];
+
+    switch (classOf(c))
+    {
+    case CharClass::IdentStart:
+    {
+        while (pos < source.size() && CHAR_TABLES.identPart[static_cast<unsigned char>(source[pos])])
+        {
+            ++pos;
+        }
+        return makeToken(getKeywordType(source.substr(start, pos - start)), start);
+    }
+
+    case CharClass::Digit:
+        while (pos < source.size() && classOf(source[pos]) == CharClass::Digit)
+        {
+            ++pos;
+        }
+        return makeToken(TokenType::Number, start);
+
+    case CharClass::Quote:
+    {
+        // A single printable character: 'A'
+        if (pos + 1 < source.size() && source[pos] != '\n' && source[pos + 1] == '\'')
+        {
+            pos += 2;
+            return makeToken(TokenType::CharLiteral, start);
+        }
+        return makeToken(TokenType::Unknown, start);
+    }
+
+    case CharClass::DoubleQuote:
+    {
+        // Strings do not span lines; an unterminated one is a single Unknown token
+        while (pos < source.size() && source[pos] != '"' && source[pos] != '\n')
+        {
+            ++pos;
+        }
+        if (pos < source.size() && source[pos] == '"')
+        {
+            ++pos;
+            return makeToken(TokenType::StringLiteral, start);
+        }
+        return makeToken(TokenType::Unknown, start);
+    }
+
+    case CharClass::Operator:
+    {
+        bool followedByEqual = pos < source.size() && source[pos] == '=';
+        if (followedByEqual)
+            ++pos;
+        switch (c)
+        {
+        case '=':
+            return makeToken(followedByEqual ? TokenType::EqualEqual : TokenType::Equal, start);
+        case '!':
+            return makeToken(followedByEqual ? TokenType::NotEqual : TokenType::Unknown, start);
+        case '<':
+            return makeToken(followedByEqual ? TokenType::LessEqual : TokenType::Less, start);
+        default:
+            return makeToken(followedByEqual ? TokenType::GreaterEqual : TokenType::Greater, start);
+        }
+    }
+
+    case CharClass::Slash:
+    case CharClass::Symbol:
+        return makeToken(CHAR_TABLES.symbol[static_cast<unsigned char>(c)], start);
+
+    default:
+        return makeToken(TokenType::Unknown, start);
+    }
 }
 
-void Lexer::scanToken(const std::string &lineText, size_t &pos)
+/*----- Helper: scan() -----*/
+Token Lexer::scan()
 {
+    skipWhitespaceAndComments();
+    if (pos >= source.size())
+        return makeToken(TokenType::EndOfFile, pos);
+    return scanToken();
 }
 
-std::vector<Token> Lexer::tokenize()
+Token Lexer::nextToken()
 {
+    if (count == 0)
+        return scan();
+
+    Token token = ring[head];
+    head = (head + 1) & (LEXER_LOOKAHEAD - 1);
+    --count;
+    return token;
 }
-void Lexer::addToken(TokenType type, const std::string &lexeme)
+
+const Token &Lexer::peek(size_t k)
 {
+    assert(k < LEXER_LOOKAHEAD);
+    while (count <= k)
+    {
+        ring[(head + count) & (LEXER_LOOKAHEAD - 1)] = scan();
+        ++count;
+    }
+    return ring[(head + k) & (LEXER_LOOKAHEAD - 1)];
 }
@@ -0,0 +1,311 @@
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+#include "../include/linker.hpp"
+
+/*----- Helper: hex() -----*/
+// At least digits digits, more if value needs them
+static std::string hex(uint32_t value, int digits)
+{
+    static const char digitsHex[] = "0123456789ABCDEF";
+    while (digits < 8 && (value >> (4 * digits)) != 0)
+    {
+        ++digits;
+    }
+    std::string text(digits, '0');
+    for (int i = digits - 1; i >= 0; --i, value >>= 4)
+    {
+        text[i] = digitsHex[value & 0xf];
+    }
+    return text;
+}
+
+static uint8_t opcodeOf(Op op)
+{
+    uint8_t opcode = 0;
+    encodeOpcode(op, op == Op::JSR ? AddressMode::Absolute : AddressMode::Implied, opcode);
+    return opcode;
+}
+
+/*----- Helper: stackNeeds() -----*/
+// Per function, the most stack it and the calls it makes can use: its
+// saved bytes, plus the deepest call's return address and need. A call to
+// a recursive function counts only its return address, as that function
+// checks its own need on entry; this leaves the calls between the others
+// acyclic.
+static std::vector<uint32_t> stackNeeds(const std::vector<MachineFunction> &functions)
+{
+    constexpr uint32_t PENDING = UINT32_MAX;
+    std::vector<uint32_t> need(functions.size(), PENDING);
+    std::vector<uint32_t> pending;
+    for (uint32_t root = 0; root < functions.size(); ++root)
+    {
+        pending.push_back(root);
+        while (!pending.empty())
+        {
+            uint32_t function = pending.back();
+            if (need[function] != PENDING)
+            {
+                pending.pop_back();
+                continue;
+            }
+
+            bool ready = true;
+            uint32_t deepest = 0;
+            for (const Relocation &relocation : functions[function].relocations)
+            {
+                if (relocation.kind == RelocKind::Runtime)
+                    deepest = std::max(deepest, 2u);
+                else if (relocation.kind == RelocKind::Function)
+                {
+                    uint32_t callee = relocation.value;
+                    if (functions[callee].recursive)
+                        deepest = std::max(deepest, 2u);
+                    else if (need[callee] == PENDING)
+                    {
+                        pending.push_back(callee);
+                        ready = false;
+                    }
+                    else
+                        deepest = std::max(deepest, 2 + need[callee]);
+                }
+            }
+            if (ready)
+            {
+                need[function] = functions[function].savedBytes + deepest;
+                pending.pop_back();
+            }
+        }
+    }
+    return need;
+}
+
+LinkedProgram link(const std::vector<MachineFunction> &functions, uint32_t mainIndex,
+                   const std::vector<std::string> &functionNames)
+{
+    // Every function is entered with at least a return address on the
+    // stack, main's from the entry stub
+    std::vector<uint32_t> need = stackNeeds(functions);
+    for (uint32_t i = 0; i < functions.size(); ++i)
+    {
+        if (2 + need[i] > STACK_BYTES)
+            throw std::runtime_error(" error: function '" + functionNames[i] + "' and the functions it calls need " +
+                                     std::to_string(2 + need[i]) + " bytes of stack, more than the " +
+                                     std::to_string(STACK_BYTES) + " there are");
+    }
+
+    LinkedProgram program;
+    constexpr uint32_t STUB_SIZE = 4;
+    uint32_t address = LOAD_ADDRESS + STUB_SIZE;
+
+    // Code: functions in source order, then the runtime routines they call
+    std::vector<bool> runtimeUsed(static_cast<size_t>(RuntimeRoutine::Count), false);
+    program.functionAddress.reserve(functions.size());
+    for (const MachineFunction &function : functions)
+    {
+        program.functionAddress.push_back(static_cast<uint16_t>(address));
+        address += static_cast<uint32_t>(function.bytes.size());
+        for (const Relocation &relocation : function.relocations)
+        {
+            if (relocation.kind == RelocKind::Runtime)
+                runtimeUsed[relocation.value] = true;
+        }
+    }
+
+    std::vector<MachineFunction> runtime(runtimeUsed.size());
+    program.runtimeAddress.assign(runtimeUsed.size(), 0);
+    for (size_t routine = 0; routine < runtimeUsed.size(); ++routine)
+    {
+        if (!runtimeUsed[routine])
+            continue;
+        runtime[routine] = assembleFunction(generateRuntime(static_cast<RuntimeRoutine>(routine)));
+        program.runtimeAddress[routine] = static_cast<uint16_t>(address);
+        address += static_cast<uint32_t>(runtime[routine].bytes.size());
+    }
+
+    // Strings, each stored once and NUL-terminated
+    program.stringsAddress = static_cast<uint16_t>(address);
+    std::unordered_map<std::string, uint32_t> stringAddress;
+    std::vector<const std::string *> stringOrder;
+    auto addStrings = [&](const MachineFunction &function)
+    {
+        for (const std::string &text : function.strings)
+        {
+            if (stringAddress.emplace(text, address).second)
+            {
+                stringOrder.push_back(&text);
+                address += static_cast<uint32_t>(text.size()) + 1;
+            }
+        }
+    };
+    for (const MachineFunction &function : functions)
+    {
+        addStrings(function);
+    }
+    for (const MachineFunction &function : runtime)
+    {
+        addStrings(function);
+    }
+
+    // Frames
+    program.framesAddress = static_cast<uint16_t>(address);
+    std::vector<uint32_t> frameAddress;
+    frameAddress.reserve(functions.size());
+    for (const MachineFunction &function : functions)
+    {
+        frameAddress.push_back(address);
+        address += function.frameSize;
+    }
+
+    if (address > HEAP_START)
+        throw std::runtime_error("program too large: it ends at $" + hex(address, 4) + ", the heap starts at $" + hex(HEAP_START, 4));
+    program.end = static_cast<uint16_t>(address);
+
+    // Emit and patch
+    std::vector<uint8_t> &image = program.image;
+    image.reserve(program.framesAddress - LOAD_ADDRESS);
+    uint16_t mainAddress = program.functionAddress[mainIndex];
+    image = {opcodeOf(Op::JSR), static_cast<uint8_t>(mainAddress), static_cast<uint8_t>(mainAddress >> 8), opcodeOf(Op::BRK)};
+
+    auto place = [&](const MachineFunction &function, uint32_t base, uint32_t frame, uint32_t stack)
+    {
+        size_t start = image.size();
+        image.insert(image.end(), function.bytes.begin(), function.bytes.end());
+        for (const Relocation &relocation : function.relocations)
+        {
+            uint32_t value = 0;
+            switch (relocation.kind)
+            {
+            case RelocKind::Code:
+                value = base + relocation.value;
+                break;
+            case RelocKind::Function:
+                value = program.functionAddress[relocation.value];
+                break;
+            case RelocKind::Runtime:
+                value = program.runtimeAddress[relocation.value];
+                break;
+            case RelocKind::Frame:
+            case RelocKind::FrameLo:
+            case RelocKind::FrameHi:
+                value = frame + relocation.value;
+                break;
+            case RelocKind::StringLo:
+            case RelocKind::StringHi:
+                value = stringAddress.at(function.strings[relocation.value]);
+                break;
+            case RelocKind::StackCheck:
+                value = stack - 1;
+                break;
+            }
+
+            uint8_t *operand = image.data() + start + relocation.offset;
+            switch (relocation.kind)
+            {
+            case RelocKind::FrameLo:
+            case RelocKind::StringLo:
+            case RelocKind::StackCheck:
+                operand[0] = static_cast<uint8_t>(value);
+                break;
+            case RelocKind::FrameHi:
+            case RelocKind::StringHi:
+                operand[0] = static_cast<uint8_t>(value >> 8);
+                break;
+            default:
+                operand[0] = static_cast<uint8_t>(value);
+                operand[1] = static_cast<uint8_t>(value >> 8);
+                break;
+            }
+        }
+    };
+
+    for (size_t i = 0; i < functions.size(); ++i)
+    {
+        place(functions[i], program.functionAddress[i], frameAddress[i], need[i]);
+    }
+    for (size_t routine = 0; routine < runtime.size(); ++routine)
+    {
+        if (runtimeUsed[routine])
+            place(runtime[routine], program.runtimeAddress[routine], 0, 0);
+    }
+    for (const std::string *text : stringOrder)
+    {
+        image.insert(image.end(), text->begin(), text->end());
+        image.push_back(0);
+    }
+    return program;
+}
+
+std::string listProgram(const LinkedProgram &program, const std::vector<std::string> &functionNames)
+{
+    // Code entry points by address, for labels and JSR targets
+    std::unordered_map<uint32_t, std::string> names;
+    for (size_t i = 0; i < program.functionAddress.size(); ++i)
+    {
+        names[program.functionAddress[i]] = functionNames[i];
+    }
+    for (size_t routine = 0; routine < program.runtimeAddress.size(); ++routine)
+    {
+        if (program.runtimeAddress[routine])
+            names[program.runtimeAddress[routine]] = runtimeName(static_cast<RuntimeRoutine>(routine));
+    }
+
+    const std::array<Decoded, 256> &decode = decodeTable();
+    std::string out;
+    uint32_t address = LOAD_ADDRESS;
+    uint32_t codeEnd = program.stringsAddress;
+
+    while (address < codeEnd)
+    {
+        auto name = names.find(address);
+        if (name != names.end())
+            out += name->second + ":\n";
+
+        const uint8_t *bytes = program.image.data() + (address - LOAD_ADDRESS);
+        const Decoded &instr = decode[bytes[0]];
+        uint32_t size = instr.valid ? instructionSize(instr.mode) : 1;
+
+        std::string encoded;
+        for (uint32_t i = 0; i < size; ++i)
+        {
+            encoded += hex(bytes[i], 2) + " ";
+        }
+        encoded.resize(11, ' ');
+
+        std::string text = instr.valid ? opName(instr.op) : "???";
+        if (instr.valid)
+        {
+            switch (instr.mode)
+            {
+            case AddressMode::Immediate:
+                text += " #$" + hex(bytes[1], 2);
+                break;
+            case AddressMode::ZeroPage:
+                text += " $" + hex(bytes[1], 2);
+                break;
+            case AddressMode::Absolute:
+            {
+                uint32_t target = bytes[1] | (bytes[2] << 8);
+                text += " $" + hex(target, 4);
+                auto callee = names.find(target);
+                if (instr.op == Op::JSR && callee != names.end())
+                    text += " ; " + callee->second;
+                break;
+            }
+            case AddressMode::Relative:
+                text += " $" + hex(address + 2 + static_cast<int8_t>(bytes[1]), 4);
+                break;
+            default:
+                break;
+            }
+        }
+        out += "  " + hex(address, 4) + "  " + encoded + text + "\n";
+        address += size;
+    }
+
+    if (program.framesAddress > program.stringsAddress)
+        out += "; strings $" + hex(program.stringsAddress, 4) + "-$" + hex(program.framesAddress - 1, 4) + "\n";
+    out += "; frames $" + hex(program.framesAddress, 4) + "-$" + hex(program.end, 4) + ", " +
+           std::to_string(program.image.size()) + " bytes loaded at $" + hex(LOAD_ADDRESS, 4) + "\n";
+    return out;
+}
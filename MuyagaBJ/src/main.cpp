@@ -1,30 +1,217 @@
-#include <iostream>
+#include <algorithm>
 #include <fstream>
-#include <vector>
+#include <iostream>
 #include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
 #include "../include/token.hpp"
+#include "../include/lexer.hpp"
+#include "../include/parser.hpp"
+#include "../include/semantic.hpp"
+#include "../include/compiler.hpp"
+#include "../include/linker.hpp"
+#include "../include/pass_stats.hpp"
+#include "../include/source_file.hpp"
+
+/*----- Helper: outputPathFor() -----*/
+static std::string outputPathFor(const std::string &path)
+{
+    size_t slash = path.find_last_of('/');
+    size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+        return path + ".bin";
+    return path.substr(0, dot) + ".bin";
+}
+
+/*----- Helper: parseCount() -----*/
+// A decimal number of up to four digits; false for anything else
+static bool parseCount(const std::string &text, unsigned &count)
+{
+    if (text.empty() || text.size() > 4 || text.find_first_not_of("0123456789") != std::string::npos)
+        return false;
+    count = static_cast<unsigned>(std::stoul(text));
+    return true;
+}
 
 int main(int argc, char *argv[])
 {
-    if (argc != 2)
+    bool dumpTokens = false;
+    bool dumpTree = false;
+    bool listing = false;
+    bool timePasses = false;
+    bool showStats = false;
+    bool usageError = false;
+    CompileOptions options;
+    options.threads = std::max(1u, std::thread::hardware_concurrency());
+    std::string path;
+    std::string outputPath;
+
+    for (int i = 1; i < argc; ++i)
     {
-        std::cerr << "Usage: " << argv[0] << " <source_file>\n";
-        return 1;
+        std::string arg = argv[i];
+        if (arg == "--tokens")
+            dumpTokens = true;
+        else if (arg == "--ast")
+            dumpTree = true;
+        else if (arg == "--asm")
+            listing = true;
+        else if (arg == "--time-passes")
+            timePasses = true;
+        else if (arg == "--stats")
+            showStats = true;
+        else if (arg == "-O0")
+            options.codegen.optimize = false;
+        else if (arg == "-j" && i + 1 < argc)
+        {
+            // -j 0 means one thread per hardware core, the default
+            if (!parseCount(argv[++i], options.threads))
+                usageError = true;
+            else if (options.threads == 0)
+                options.threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        else if (arg == "--cache" && i + 1 < argc)
+            options.cacheDir = argv[++i];
+        else if (arg == "-o" && i + 1 < argc)
+            outputPath = argv[++i];
+        else if (path.empty() && arg[0] != '-')
+            path = arg;
+        else
+            usageError = true;
     }
 
-    std::ifstream source(argv[1]);
-    if (!source.is_open())
+    if (usageError || path.empty())
     {
-        throw std::runtime_error("Error: could not open file '" + std::string(argv[1]) + "'");
+        std::cerr << "Usage: " << argv[0] << " [--tokens | --ast | --asm] [-O0] [-j threads] [--cache dir] [--time-passes] [--stats]\n"
+                  << "       [-o <output>] <source_file>\n";
+        return 1;
     }
 
-    std::string line;
-    size_t count = 0;
+    try
+    {
+        SourceFile source(path);
+        Lexer lexer(source.text());
+
+        if (dumpTokens)
+        {
+            for (Token token = lexer.nextToken(); token.type != TokenType::EndOfFile; token = lexer.nextToken())
+            {
+                std::cout << token.toString() << "\n";
+            }
+            return 0;
+        }
+
+        // Lexing and parsing are one pass (the parser pulls tokens), so when
+        // measuring, a separate sweep over the tokens shows what lexing costs
+        bool measuring = timePasses || showStats;
+        if (measuring)
+            enableAllocationTracking();
+        std::vector<PassStats> passes;
+        uint64_t tokenCount = 0;
+        if (measuring)
+        {
+            PassTimer timer("lex");
+            Lexer sweep(source.text());
+            while (sweep.nextToken().type != TokenType::EndOfFile)
+            {
+                ++tokenCount;
+            }
+            passes.push_back(timer.finish());
+        }
+
+        PassTimer parseTimer("parse (+lex)");
+        AstArena ast;
+        Parser parser(lexer, ast);
+        NodeIndex program = parser.parseProgram();
+        passes.push_back(parseTimer.finish());
+
+        PassTimer declareTimer("declare");
+        StringInterner names;
+        SymbolTable symbols;
+        Resolver resolver(ast, source.text(), names, symbols);
+        std::vector<FunctionInfo> functions = resolver.declareFunctions(program);
+        passes.push_back(declareTimer.finish());
 
-    while (std::getline(source, line))
+        if (dumpTree)
+        {
+            for (FunctionInfo &function : functions)
+            {
+                resolver.resolveFunction(function);
+            }
+            std::cout << dumpAst(ast, program, source.text());
+            return 0;
+        }
+
+        // Resolution and codegen interleave per function on the workers;
+        // they share the peak heap of the phase
+        PassTimer compileTimer("compile");
+        CompileStats compileStats;
+        std::vector<MachineFunction> machineCode =
+            compileFunctions(ast, source.text(), names, symbols, functions, options, measuring ? &compileStats : nullptr);
+        int64_t compilePeak = compileTimer.finish().peakBytes;
+        for (PassStats *pass : {&compileStats.resolve, &compileStats.codegen, &compileStats.cache})
+        {
+            pass->peakBytes = compilePeak;
+        }
+        passes.push_back(compileStats.resolve);
+        passes.push_back(compileStats.codegen);
+        if (!options.cacheDir.empty())
+            passes.push_back(compileStats.cache);
+
+        PassTimer linkTimer("link");
+        std::vector<std::string> functionNames;
+        functionNames.reserve(functions.size());
+        uint32_t mainIndex = 0;
+        for (const FunctionInfo &function : functions)
+        {
+            functionNames.emplace_back(names.text(symbols.symbol(function.symbol).name));
+            if (functionNames.back() == "main")
+                mainIndex = static_cast<uint32_t>(functionNames.size() - 1);
+        }
+        LinkedProgram linked = link(machineCode, mainIndex, functionNames);
+        passes.push_back(linkTimer.finish());
+
+        if (listing)
+            std::cout << listProgram(linked, functionNames);
+        else
+        {
+            if (outputPath.empty())
+                outputPath = outputPathFor(path);
+            std::ofstream out(outputPath, std::ios::binary);
+            out.write(reinterpret_cast<const char *>(linked.image.data()), static_cast<std::streamsize>(linked.image.size()));
+            if (!out)
+                throw std::runtime_error(" error: could not write '" + outputPath + "'");
+        }
+
+        if (timePasses)
+        {
+            std::cerr << formatPassTable(passes);
+            if (options.threads > 1 && functions.size() > 1)
+                std::cerr << "[Stats] resolve, codegen and cache times are summed over up to " << options.threads
+                          << " threads\n";
+        }
+        if (showStats)
+        {
+            uint64_t instructions = 0;
+            for (const MachineFunction &function : machineCode)
+            {
+                instructions += instructionCount(function);
+            }
+            std::string_view text = source.text();
+            std::cerr << "[Stats] " << std::count(text.begin(), text.end(), '\n') << " lines, "
+                      << tokenCount << " tokens, " << ast.nodeCount() << " AST nodes, " << functions.size()
+                      << " functions\n";
+            std::cerr << "[Stats] " << instructions << " instructions, " << linked.image.size() << " bytes, ends at $"
+                      << std::hex << linked.end << std::dec << "\n";
+            if (!options.cacheDir.empty())
+                std::cerr << "[Stats] " << compileStats.cacheHits << " of " << functions.size()
+                          << " functions reused from " << options.cacheDir << "\n";
+        }
+    }
+    catch (const std::runtime_error &e)
     {
-        std::cout << count << ". " << line << "\n";
-        count++;
+        std::cerr << path << ":" << e.what() << "\n";
+        return 1;
     }
 
     return 0;
@@ -0,0 +1,319 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../include/lexer.hpp"
+#include "../include/object_cache.hpp"
+
+constexpr char OBJECT_MAGIC[8] = {'M', 'B', 'J', 'O', 'B', 'J', 0, 0};
+
+// Written as a native integer, so a file from a machine of the other byte
+// order is rejected
+constexpr uint32_t OBJECT_BYTE_ORDER = 0x01020304;
+
+struct ObjectHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t keySize;
+    uint32_t byteCount;
+    uint32_t relocationCount;
+    uint32_t stringCount;
+    uint32_t calleeCount;
+    uint32_t frameSize;
+    uint32_t savedBytes;
+    uint32_t recursive;
+};
+
+struct StoredRelocation
+{
+    uint32_t offset;
+    uint32_t kind;
+    uint32_t value;
+};
+
+std::string functionCacheKey(std::string_view text, bool recursive, const AstArena &ast, const StringInterner &names,
+                             const SymbolTable &symbols, const CodegenOptions &options)
+{
+    std::string key;
+    key.reserve(text.size() + 64);
+    std::vector<uint32_t> callees;
+
+    Lexer lexer(text);
+    for (Token token = lexer.nextToken(); token.type != TokenType::EndOfFile; token = lexer.nextToken())
+    {
+        key += static_cast<char>(token.type);
+        key += token.lexeme;
+        key += '\0';
+
+        // Any name of a declared function, even one a local shadows
+        if (token.type != TokenType::Identifier)
+            continue;
+        NameId name = names.find(token.lexeme);
+        uint32_t symbol = name == NO_NAME ? NO_SYMBOL : symbols.lookup(name);
+        if (symbol != NO_SYMBOL && std::find(callees.begin(), callees.end(), symbol) == callees.end())
+            callees.push_back(symbol);
+    }
+
+    key += "\n";
+    for (uint32_t callee : callees)
+    {
+        const Symbol &function = symbols.symbol(callee);
+        key += names.text(function.name);
+        key += '(';
+        for (NodeIndex param : ast.list(ast.node(function.decl).b))
+        {
+            key += valueTypeName(ast.node(param).type);
+            key += ',';
+        }
+        key += ')';
+        key += valueTypeName(function.type);
+        key += '\n';
+    }
+    key += options.optimize ? "O1" : "O0";
+    if (recursive)
+        key += " recursive";
+    return key;
+}
+
+std::string objectCacheName(const std::string &key)
+{
+    uint64_t hash = 14695981039346656037ull; // FNV-1a
+    for (char c : key)
+    {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+    hash ^= OBJECT_CACHE_VERSION;
+    hash *= 1099511628211ull;
+
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.mbo", static_cast<unsigned long long>(hash));
+    return name;
+}
+
+/*----- Helper: appendBytes() -----*/
+static void appendBytes(std::string &image, const void *data, size_t size)
+{
+    image.append(static_cast<const char *>(data), size);
+}
+
+static void appendText(std::string &image, std::string_view text)
+{
+    uint32_t size = static_cast<uint32_t>(text.size());
+    appendBytes(image, &size, sizeof(size));
+    image.append(text);
+}
+
+bool saveCachedFunction(const std::string &path, const std::string &key, const MachineFunction &function,
+                        const std::vector<std::string_view> &functionNames)
+{
+    // Callees in order of first use; relocations refer to them by position
+    std::vector<uint32_t> callees;
+    std::vector<StoredRelocation> relocations;
+    relocations.reserve(function.relocations.size());
+    for (const Relocation &relocation : function.relocations)
+    {
+        StoredRelocation stored{relocation.offset, static_cast<uint32_t>(relocation.kind), relocation.value};
+        if (relocation.kind == RelocKind::Function)
+        {
+            auto known = std::find(callees.begin(), callees.end(), relocation.value);
+            stored.value = static_cast<uint32_t>(known - callees.begin());
+            if (known == callees.end())
+                callees.push_back(relocation.value);
+        }
+        relocations.push_back(stored);
+    }
+
+    ObjectHeader header{};
+    memcpy(header.magic, OBJECT_MAGIC, sizeof(OBJECT_MAGIC));
+    header.version = OBJECT_CACHE_VERSION;
+    header.byteOrder = OBJECT_BYTE_ORDER;
+    header.keySize = static_cast<uint32_t>(key.size());
+    header.byteCount = static_cast<uint32_t>(function.bytes.size());
+    header.relocationCount = static_cast<uint32_t>(relocations.size());
+    header.stringCount = static_cast<uint32_t>(function.strings.size());
+    header.calleeCount = static_cast<uint32_t>(callees.size());
+    header.frameSize = function.frameSize;
+    header.savedBytes = function.savedBytes;
+    header.recursive = function.recursive;
+
+    std::string image;
+    appendBytes(image, &header, sizeof(header));
+    image += key;
+    appendBytes(image, function.bytes.data(), function.bytes.size());
+    appendBytes(image, relocations.data(), relocations.size() * sizeof(StoredRelocation));
+    for (const std::string &text : function.strings)
+    {
+        appendText(image, text);
+    }
+    for (uint32_t callee : callees)
+    {
+        appendText(image, functionNames[callee]);
+    }
+
+    // Every writer, thread or process, uses its own temporary file; readers
+    // only ever see complete files
+    static std::atomic<uint32_t> serial{0};
+    std::string temporary = path + ".tmp" + std::to_string(getpid()) + "." + std::to_string(serial++);
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        if (!out.write(image.data(), static_cast<std::streamsize>(image.size())))
+        {
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0)
+    {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+namespace
+{
+// Bounds-checked reads from a file image
+struct Reader
+{
+    const std::string &image;
+    size_t at = 0;
+
+    bool read(void *out, size_t size)
+    {
+        if (size > image.size() - at)
+            return false;
+        memcpy(out, image.data() + at, size);
+        at += size;
+        return true;
+    }
+
+    bool readText(std::string &out)
+    {
+        uint32_t size;
+        if (!read(&size, sizeof(size)) || size > image.size() - at)
+            return false;
+        out.assign(image, at, size);
+        at += size;
+        return true;
+    }
+};
+} // namespace
+
+bool loadCachedFunction(const std::string &path, const std::string &key, const StringInterner &names,
+                        const SymbolTable &symbols, MachineFunction &function)
+{
+    // Plain POSIX reads: one cache file per function makes stream setup
+    // cost more than the read itself
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat info;
+    std::string image;
+    if (fstat(fd, &info) == 0)
+    {
+        image.resize(static_cast<size_t>(info.st_size));
+        if (read(fd, &image[0], image.size()) != static_cast<ssize_t>(image.size()))
+            image.clear();
+    }
+    close(fd);
+
+    Reader reader{image};
+    ObjectHeader header;
+    if (!reader.read(&header, sizeof(header)) || memcmp(header.magic, OBJECT_MAGIC, sizeof(OBJECT_MAGIC)) != 0 ||
+        header.version != OBJECT_CACHE_VERSION || header.byteOrder != OBJECT_BYTE_ORDER ||
+        header.keySize != key.size())
+        return false;
+    if (key.size() > image.size() - reader.at || image.compare(reader.at, key.size(), key) != 0)
+        return false;
+    reader.at += key.size();
+
+    MachineFunction loaded;
+    loaded.frameSize = header.frameSize;
+    loaded.savedBytes = header.savedBytes;
+    loaded.recursive = header.recursive != 0;
+    loaded.bytes.resize(header.byteCount);
+    if (!reader.read(loaded.bytes.data(), loaded.bytes.size()))
+        return false;
+
+    if (header.relocationCount > (image.size() - reader.at) / sizeof(StoredRelocation))
+        return false;
+    std::vector<StoredRelocation> relocations(header.relocationCount);
+    reader.read(relocations.data(), relocations.size() * sizeof(StoredRelocation));
+
+    if (header.stringCount > image.size() || header.calleeCount > image.size())
+        return false;
+    loaded.strings.resize(header.stringCount);
+    for (std::string &text : loaded.strings)
+    {
+        if (!reader.readText(text))
+            return false;
+    }
+
+    std::vector<uint32_t> callees;
+    for (uint32_t i = 0; i < header.calleeCount; ++i)
+    {
+        std::string name;
+        if (!reader.readText(name))
+            return false;
+        NameId id = names.find(name);
+        uint32_t symbol = id == NO_NAME ? NO_SYMBOL : symbols.lookup(id);
+        if (symbol == NO_SYMBOL || symbols.symbol(symbol).kind != SymbolKind::Function)
+            return false;
+        callees.push_back(symbols.symbol(symbol).slot);
+    }
+
+    // Every relocation must stay inside the code and refer to something
+    for (const StoredRelocation &stored : relocations)
+    {
+        RelocKind kind = static_cast<RelocKind>(stored.kind);
+        uint32_t width = kind == RelocKind::FrameLo || kind == RelocKind::FrameHi || kind == RelocKind::StringLo ||
+                                 kind == RelocKind::StringHi || kind == RelocKind::StackCheck
+                             ? 1
+                             : 2;
+        if (stored.kind > static_cast<uint32_t>(RelocKind::StackCheck) || stored.offset > loaded.bytes.size() ||
+            width > loaded.bytes.size() - stored.offset)
+            return false;
+
+        uint32_t value = stored.value;
+        switch (kind)
+        {
+        case RelocKind::Function:
+            if (value >= callees.size())
+                return false;
+            value = callees[value];
+            break;
+        case RelocKind::Runtime:
+            if (value >= static_cast<uint32_t>(RuntimeRoutine::Count))
+                return false;
+            break;
+        case RelocKind::StringLo:
+        case RelocKind::StringHi:
+            if (value >= loaded.strings.size())
+                return false;
+            break;
+        case RelocKind::Code:
+            if (value > loaded.bytes.size())
+                return false;
+            break;
+        case RelocKind::StackCheck:
+            if (value != 0 || !loaded.recursive)
+                return false;
+            break;
+        default:
+            if (value >= loaded.frameSize)
+                return false;
+            break;
+        }
+        loaded.relocations.push_back({stored.offset, kind, value});
+    }
+
+    function = std::move(loaded);
+    return true;
+}
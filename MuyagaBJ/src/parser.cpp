@@ -0,0 +1,399 @@
+#include <stdexcept>
+#include "../include/parser.hpp"
+
+// -----------------------------
+// Operator precedence
+// -----------------------------
+
+// Binary operators from lowest to highest precedence, as in grammer.md
+static constexpr int BINARY_LEVELS = 4;
+
+static Operator binaryOperator(TokenType type, int level)
+{
+    switch (level)
+    {
+    case 0:
+        return type == TokenType::EqualEqual ? Operator::Equal : type == TokenType::NotEqual ? Operator::NotEqual : Operator::None;
+    case 1:
+        switch (type)
+        {
+        case TokenType::Less:
+            return Operator::Less;
+        case TokenType::LessEqual:
+            return Operator::LessEqual;
+        case TokenType::Greater:
+            return Operator::Greater;
+        case TokenType::GreaterEqual:
+            return Operator::GreaterEqual;
+        default:
+            return Operator::None;
+        }
+    case 2:
+        return type == TokenType::Plus ? Operator::Add : type == TokenType::Minus ? Operator::Sub : Operator::None;
+    default:
+        return type == TokenType::Star ? Operator::Mul : type == TokenType::Slash ? Operator::Div : Operator::None;
+    }
+}
+
+static bool isTypeKeyword(TokenType type)
+{
+    return type == TokenType::Int || type == TokenType::Char || type == TokenType::String;
+}
+
+// -----------------------------
+// Parser
+// -----------------------------
+
+Parser::Parser(Lexer &lexer, AstArena &ast) : lexer(lexer), ast(ast) {}
+
+/*----- Helper: error() -----*/
+void Parser::error(const Token &token, const std::string &message) const
+{
+    std::string found = token.type == TokenType::EndOfFile ? "end of file" : "'" + std::string(token.lexeme) + "'";
+    throw std::runtime_error(std::to_string(token.line) + ":" + std::to_string(token.column) + ": error: " +
+                             message + ", found " + found);
+}
+
+bool Parser::match(TokenType type)
+{
+    if (lexer.peek().type != type)
+        return false;
+    lexer.nextToken();
+    return true;
+}
+
+Token Parser::expect(TokenType type, const char *what)
+{
+    Token token = lexer.nextToken();
+    if (token.type != type)
+        error(token, std::string("expected ") + what);
+    return token;
+}
+
+NodeIndex Parser::makeNode(NodeKind kind, const Token &at, uint32_t a, uint32_t b, uint32_t c)
+{
+    AstNode node;
+    node.kind = kind;
+    node.a = a;
+    node.b = b;
+    node.c = c;
+    node.offset = lexer.offsetOf(at);
+    return ast.addNode(node);
+}
+
+NodeIndex Parser::makeIdentifier(const Token &token)
+{
+    return makeNode(NodeKind::Identifier, token, lexer.offsetOf(token), static_cast<uint32_t>(token.lexeme.size()));
+}
+
+// Children pushed on scratch since mark become one arena list
+ListIndex Parser::closeList(size_t mark)
+{
+    ListIndex list = ast.addList(scratch.data() + mark, scratch.size() - mark);
+    scratch.resize(mark);
+    return list;
+}
+
+ValueType Parser::parseType()
+{
+    Token token = lexer.nextToken();
+    switch (token.type)
+    {
+    case TokenType::Int:
+        return ValueType::Int;
+    case TokenType::Char:
+        return ValueType::Char;
+    case TokenType::String:
+        return ValueType::String;
+    default:
+        error(token, "expected a type");
+    }
+}
+
+NodeIndex Parser::parseProgram()
+{
+    const Token &first = lexer.peek();
+    NodeIndex program = makeNode(NodeKind::Program, first);
+
+    size_t mark = scratch.size();
+    while (lexer.peek().type != TokenType::EndOfFile)
+    {
+        scratch.push_back(parseFunction());
+    }
+    ast.node(program).a = closeList(mark);
+    return program;
+}
+
+// func [Type | void] IDENT ( [Param {, Param}] ) Block
+NodeIndex Parser::parseFunction()
+{
+    Token func = expect(TokenType::Func, "'func'");
+
+    // No return type is the same as void
+    ValueType returnType = ValueType::Void;
+    if (!match(TokenType::Void) && isTypeKeyword(lexer.peek().type))
+        returnType = parseType();
+
+    NodeIndex name = makeIdentifier(expect(TokenType::Identifier, "a function name"));
+    expect(TokenType::LParen, "'(' after the function name");
+
+    size_t mark = scratch.size();
+    if (lexer.peek().type != TokenType::RParen)
+    {
+        do
+        {
+            scratch.push_back(parseParam());
+        } while (match(TokenType::Comma));
+    }
+    ListIndex params = closeList(mark);
+    expect(TokenType::RParen, "')' after the parameters");
+
+    NodeIndex body = parseBlock();
+    NodeIndex function = makeNode(NodeKind::Function, func, name, params, body);
+    ast.node(function).type = returnType;
+    return function;
+}
+
+NodeIndex Parser::parseParam()
+{
+    const Token &at = lexer.peek();
+    uint32_t offset = lexer.offsetOf(at);
+    ValueType type = parseType();
+
+    NodeIndex name = makeIdentifier(expect(TokenType::Identifier, "a parameter name"));
+    AstNode param;
+    param.kind = NodeKind::Param;
+    param.type = type;
+    param.a = name;
+    param.offset = offset;
+    return ast.addNode(param);
+}
+
+NodeIndex Parser::parseBlock()
+{
+    Token open = expect(TokenType::LBrace, "'{'");
+
+    size_t mark = scratch.size();
+    while (lexer.peek().type != TokenType::RBrace && lexer.peek().type != TokenType::EndOfFile)
+    {
+        scratch.push_back(parseStatement());
+    }
+    expect(TokenType::RBrace, "'}'");
+    return makeNode(NodeKind::Block, open, closeList(mark));
+}
+
+// (Type | let) IDENT = Expression ;
+NodeIndex Parser::parseVarDecl()
+{
+    const Token &at = lexer.peek();
+    uint32_t offset = lexer.offsetOf(at);
+    ValueType type = ValueType::Inferred;
+    if (!match(TokenType::Let))
+        type = parseType();
+
+    NodeIndex name = makeIdentifier(expect(TokenType::Identifier, "a variable name"));
+    expect(TokenType::Equal, "'=' in the declaration");
+    NodeIndex value = parseExpression();
+    expect(TokenType::Semicolon, "';' after the declaration");
+
+    AstNode decl;
+    decl.kind = NodeKind::VarDecl;
+    decl.type = type;
+    decl.a = name;
+    decl.b = value;
+    decl.offset = offset;
+    return ast.addNode(decl);
+}
+
+NodeIndex Parser::parseStatement()
+{
+    const Token &next = lexer.peek();
+    switch (next.type)
+    {
+    case TokenType::LBrace:
+        return parseBlock();
+
+    case TokenType::Let:
+    case TokenType::Int:
+    case TokenType::Char:
+    case TokenType::String:
+        return parseVarDecl();
+
+    case TokenType::Return:
+    {
+        Token keyword = lexer.nextToken();
+        NodeIndex value = lexer.peek().type == TokenType::Semicolon ? NO_NODE : parseExpression();
+        expect(TokenType::Semicolon, "';' after return");
+        return makeNode(NodeKind::Return, keyword, value);
+    }
+
+    case TokenType::While:
+    {
+        Token keyword = lexer.nextToken();
+        expect(TokenType::LParen, "'(' after while");
+        NodeIndex condition = parseExpression();
+        expect(TokenType::RParen, "')' after the condition");
+        NodeIndex body = parseBlock();
+        return makeNode(NodeKind::While, keyword, condition, body);
+    }
+
+    case TokenType::If:
+    {
+        Token keyword = lexer.nextToken();
+        expect(TokenType::LParen, "'(' after if");
+        NodeIndex condition = parseExpression();
+        expect(TokenType::RParen, "')' after the condition");
+        NodeIndex thenBlock = parseBlock();
+        NodeIndex elseBlock = match(TokenType::Else) ? parseBlock() : NO_NODE;
+        return makeNode(NodeKind::If, keyword, condition, thenBlock, elseBlock);
+    }
+
+    case TokenType::Print:
+    {
+        Token keyword = lexer.nextToken();
+        expect(TokenType::LParen, "'(' after print");
+        NodeIndex value = parseExpression();
+        expect(TokenType::RParen, "')' after the value");
+        expect(TokenType::Semicolon, "';' after print");
+        return makeNode(NodeKind::Print, keyword, value);
+    }
+
+    case TokenType::Free:
+    {
+        Token keyword = lexer.nextToken();
+        expect(TokenType::LParen, "'(' after free");
+        NodeIndex pointer = makeIdentifier(expect(TokenType::Identifier, "a variable name"));
+        expect(TokenType::RParen, "')' after the variable");
+        expect(TokenType::Semicolon, "';' after free");
+        return makeNode(NodeKind::Free, keyword, pointer);
+    }
+
+    case TokenType::Identifier:
+        if (lexer.peek(1).type == TokenType::Equal)
+        {
+            Token target = lexer.nextToken();
+            lexer.nextToken();
+            NodeIndex name = makeIdentifier(target);
+            NodeIndex value = parseExpression();
+            expect(TokenType::Semicolon, "';' after the assignment");
+            return makeNode(NodeKind::Assign, target, name, value);
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    Token at = next;
+    NodeIndex expression = parseExpression();
+    expect(TokenType::Semicolon, "';' after the expression");
+    return makeNode(NodeKind::ExprStmt, at, expression);
+}
+
+NodeIndex Parser::parseExpression()
+{
+    return parseBinary(0);
+}
+
+// One precedence level: operand { op operand }, left-associative
+NodeIndex Parser::parseBinary(int level)
+{
+    if (level == BINARY_LEVELS)
+        return parseUnary();
+
+    NodeIndex left = parseBinary(level + 1);
+    while (true)
+    {
+        const Token &next = lexer.peek();
+        Operator op = binaryOperator(next.type, level);
+        if (op == Operator::None)
+            return left;
+
+        Token opToken = lexer.nextToken();
+        NodeIndex right = parseBinary(level + 1);
+        NodeIndex binary = makeNode(NodeKind::Binary, opToken, left, right);
+        ast.node(binary).op = op;
+        left = binary;
+    }
+}
+
+NodeIndex Parser::parseUnary()
+{
+    const Token &next = lexer.peek();
+    if (next.type != TokenType::Minus && next.type != TokenType::Ampersand)
+        return parsePrimary();
+
+    Token opToken = lexer.nextToken();
+    NodeIndex operand = parsePrimary();
+    NodeIndex unary = makeNode(NodeKind::Unary, opToken, operand);
+    ast.node(unary).op = opToken.type == TokenType::Minus ? Operator::Negate : Operator::AddressOf;
+    return unary;
+}
+
+NodeIndex Parser::parsePrimary()
+{
+    Token token = lexer.nextToken();
+    switch (token.type)
+    {
+    case TokenType::Number:
+    {
+        uint64_t value = 0;
+        for (char digit : token.lexeme)
+        {
+            value = value * 10 + static_cast<uint64_t>(digit - '0');
+            if (value > INT32_MAX)
+                error(token, "integer literal out of range");
+        }
+        return makeNode(NodeKind::Number, token, static_cast<uint32_t>(value));
+    }
+
+    case TokenType::CharLiteral:
+        return makeNode(NodeKind::CharLit, token, static_cast<unsigned char>(token.lexeme[1]));
+
+    case TokenType::StringLiteral:
+        return makeNode(NodeKind::StringLit, token, lexer.offsetOf(token) + 1,
+                        static_cast<uint32_t>(token.lexeme.size() - 2));
+
+    case TokenType::Identifier:
+        if (lexer.peek().type == TokenType::LParen)
+            return parseCall(token);
+        return makeIdentifier(token);
+
+    case TokenType::Alloc:
+    {
+        expect(TokenType::LParen, "'(' after alloc");
+        NodeIndex size = parseExpression();
+        expect(TokenType::RParen, "')' after the size");
+        return makeNode(NodeKind::Alloc, token, size);
+    }
+
+    case TokenType::LParen:
+    {
+        NodeIndex inner = parseExpression();
+        expect(TokenType::RParen, "')'");
+        return inner;
+    }
+
+    default:
+        error(token, "expected an expression");
+    }
+}
+
+// IDENT ( [Expression {, Expression}] )
+NodeIndex Parser::parseCall(const Token &name)
+{
+    NodeIndex callee = makeIdentifier(name);
+    lexer.nextToken();
+
+    size_t mark = scratch.size();
+    if (lexer.peek().type != TokenType::RParen)
+    {
+        do
+        {
+            scratch.push_back(parseExpression());
+        } while (match(TokenType::Comma));
+    }
+    ListIndex args = closeList(mark);
+    expect(TokenType::RParen, "')' after the arguments");
+    return makeNode(NodeKind::Call, name, callee, args);
+}
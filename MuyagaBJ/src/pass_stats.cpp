@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include "../include/pass_stats.hpp"
+
+namespace
+{
+std::atomic<bool> tracking{false};
+std::atomic<uint64_t> allocations{0};
+std::atomic<int64_t> inUse{0};
+std::atomic<int64_t> peak{0};
+thread_local uint64_t threadAllocations = 0;
+
+// Just before every block: what malloc returned, and the size asked for,
+// with the top bit set if the block was counted. Only counted blocks are
+// taken off inUse, so blocks from before tracking cannot drive it negative.
+struct alignas(std::max_align_t) Header
+{
+    void *base;
+    size_t size;
+};
+constexpr size_t COUNTED = ~(~size_t(0) >> 1);
+
+void *allocate(size_t size, size_t alignment)
+{
+    // malloc already aligns for max_align_t, and so does the header's size
+    size_t slack = alignment > alignof(std::max_align_t) ? alignment - 1 : 0;
+    if (size > SIZE_MAX / 2 - sizeof(Header) - slack)
+        throw std::bad_alloc();
+    void *base = std::malloc(sizeof(Header) + slack + size);
+    if (!base)
+        throw std::bad_alloc();
+
+    uintptr_t at = reinterpret_cast<uintptr_t>(base) + sizeof(Header);
+    if (slack)
+        at = (at + slack) & ~static_cast<uintptr_t>(slack);
+    Header *header = reinterpret_cast<Header *>(at) - 1;
+    header->base = base;
+    header->size = size;
+
+    if (tracking.load(std::memory_order_relaxed))
+    {
+        header->size |= COUNTED;
+        ++threadAllocations;
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        int64_t now = inUse.fetch_add(static_cast<int64_t>(size), std::memory_order_relaxed) + static_cast<int64_t>(size);
+        int64_t seen = peak.load(std::memory_order_relaxed);
+        while (now > seen && !peak.compare_exchange_weak(seen, now, std::memory_order_relaxed))
+        {
+        }
+    }
+    return reinterpret_cast<void *>(at);
+}
+
+void *allocateOrNull(size_t size, size_t alignment) noexcept
+{
+    try
+    {
+        return allocate(size, alignment);
+    }
+    catch (const std::bad_alloc &)
+    {
+        return nullptr;
+    }
+}
+
+void release(void *block) noexcept
+{
+    if (!block)
+        return;
+    Header *header = static_cast<Header *>(block) - 1;
+    if (header->size & COUNTED)
+        inUse.fetch_sub(static_cast<int64_t>(header->size & ~COUNTED), std::memory_order_relaxed);
+    std::free(header->base);
+}
+
+constexpr size_t DEFAULT_ALIGNMENT = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+} // namespace
+
+void *operator new(size_t size) { return allocate(size, DEFAULT_ALIGNMENT); }
+void *operator new[](size_t size) { return allocate(size, DEFAULT_ALIGNMENT); }
+void *operator new(size_t size, const std::nothrow_t &) noexcept { return allocateOrNull(size, DEFAULT_ALIGNMENT); }
+void *operator new[](size_t size, const std::nothrow_t &) noexcept { return allocateOrNull(size, DEFAULT_ALIGNMENT); }
+void *operator new(size_t size, std::align_val_t alignment) { return allocate(size, static_cast<size_t>(alignment)); }
+void *operator new[](size_t size, std::align_val_t alignment) { return allocate(size, static_cast<size_t>(alignment)); }
+void *operator new(size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    return allocateOrNull(size, static_cast<size_t>(alignment));
+}
+void *operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    return allocateOrNull(size, static_cast<size_t>(alignment));
+}
+void operator delete(void *block) noexcept { release(block); }
+void operator delete[](void *block) noexcept { release(block); }
+void operator delete(void *block, size_t) noexcept { release(block); }
+void operator delete[](void *block, size_t) noexcept { release(block); }
+void operator delete(void *block, std::align_val_t) noexcept { release(block); }
+void operator delete[](void *block, std::align_val_t) noexcept { release(block); }
+void operator delete(void *block, size_t, std::align_val_t) noexcept { release(block); }
+void operator delete[](void *block, size_t, std::align_val_t) noexcept { release(block); }
+
+void enableAllocationTracking()
+{
+    peak = inUse.load();
+    tracking = true;
+}
+
+uint64_t allocationCount() { return allocations.load(); }
+uint64_t threadAllocationCount() { return threadAllocations; }
+int64_t heapInUse() { return inUse.load(); }
+int64_t heapPeak() { return peak.load(); }
+void resetHeapPeak() { peak = inUse.load(); }
+
+PassTimer::PassTimer(std::string name)
+    : name(std::move(name)), start(std::chrono::steady_clock::now()), allocationsAtStart(allocationCount())
+{
+    resetHeapPeak();
+}
+
+PassStats PassTimer::finish() const
+{
+    PassStats stats;
+    stats.name = name;
+    stats.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    stats.allocations = allocationCount() - allocationsAtStart;
+    stats.peakBytes = heapPeak();
+    return stats;
+}
+
+std::string formatPassTable(const std::vector<PassStats> &passes)
+{
+    std::string out = "[Stats] pass               time ms   allocations   peak heap KB\n";
+    char line[128];
+    PassStats total;
+    total.name = "total";
+    for (const PassStats &pass : passes)
+    {
+        std::snprintf(line, sizeof(line), "[Stats] %-16s %9.2f %13llu %14lld\n", pass.name.c_str(), pass.milliseconds,
+                      static_cast<unsigned long long>(pass.allocations), static_cast<long long>(pass.peakBytes / 1024));
+        out += line;
+        total.milliseconds += pass.milliseconds;
+        total.allocations += pass.allocations;
+        total.peakBytes = std::max(total.peakBytes, pass.peakBytes);
+    }
+    std::snprintf(line, sizeof(line), "[Stats] %-16s %9.2f %13llu %14lld\n", total.name.c_str(), total.milliseconds,
+                  static_cast<unsigned long long>(total.allocations), static_cast<long long>(total.peakBytes / 1024));
+    out += line;
+    return out;
+}
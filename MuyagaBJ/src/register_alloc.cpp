@@ -0,0 +1,248 @@
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+#include "../include/register_alloc.hpp"
+
+namespace
+{
+constexpr uint32_t UNUSED = UINT32_MAX;
+constexpr uint32_t MAX_LOOP_DEPTH = 6; // weights stay well inside 64 bits
+
+struct LiveRange
+{
+    uint32_t byte;
+    uint32_t start = UNUSED;
+    uint32_t end = 0;
+    uint64_t weight = 0;
+    bool startsWithStore = false;
+    bool acrossCall = false;
+};
+
+// Locations with the ranges already placed in them
+struct Slot
+{
+    Operand location;
+    bool acrossCall;
+    std::vector<std::pair<uint32_t, uint32_t>> ranges;
+
+    bool fits(const LiveRange &range) const
+    {
+        for (const auto &[start, end] : ranges)
+        {
+            if (range.start <= end && start <= range.end)
+                return false;
+        }
+        return true;
+    }
+};
+
+bool isStore(Op op)
+{
+    return op == Op::STA || op == Op::STX || op == Op::STY;
+}
+
+// Place range in the first slot that has room for it
+Slot *firstFit(std::vector<Slot> &slots, const LiveRange &range)
+{
+    for (Slot &slot : slots)
+    {
+        if (slot.acrossCall == range.acrossCall && slot.fits(range))
+            return &slot;
+    }
+    return nullptr;
+}
+
+std::vector<Slot> zeroPagePool(uint16_t base, uint16_t bytes, bool acrossCall)
+{
+    std::vector<Slot> pool(bytes);
+    for (uint16_t i = 0; i < bytes; ++i)
+    {
+        pool[i].location = {OperandKind::Fixed, static_cast<uint32_t>(base + i)};
+        pool[i].acrossCall = acrossCall;
+    }
+    return pool;
+}
+} // namespace
+
+FrameLayout allocateFrame(const std::vector<Instr> &code, uint32_t frameSize, const std::vector<uint32_t> &pinned,
+                          uint32_t savedBytes)
+{
+    const uint32_t size = static_cast<uint32_t>(code.size());
+
+    // Loops are a label and a later jump back to it; depth is how many
+    // of them an instruction sits in
+    std::unordered_map<uint32_t, uint32_t> labelAt;
+    std::vector<std::pair<uint32_t, uint32_t>> loops;
+    std::vector<int32_t> depthChange(size + 1, 0);
+    std::vector<uint32_t> calls;
+    for (uint32_t i = 0; i < size; ++i)
+    {
+        const Instr &instr = code[i];
+        if (instr.op == Op::Label)
+            labelAt[instr.operand.value] = i;
+        else if (instr.operand.kind == OperandKind::Label)
+        {
+            auto target = labelAt.find(instr.operand.value);
+            if (target != labelAt.end())
+            {
+                loops.emplace_back(target->second, i);
+                ++depthChange[target->second];
+                --depthChange[i + 1];
+            }
+        }
+        else if (instr.op == Op::JSR && instr.operand.kind == OperandKind::Function)
+            calls.push_back(i);
+    }
+
+    std::vector<LiveRange> ranges(frameSize);
+    int32_t depth = 0;
+    for (uint32_t i = 0; i < size; ++i)
+    {
+        depth += depthChange[i];
+        const Instr &instr = code[i];
+        if (instr.operand.kind != OperandKind::Frame)
+            continue;
+
+        LiveRange &range = ranges[instr.operand.value];
+        if (range.start == UNUSED)
+        {
+            range.start = i;
+            range.startsWithStore = isStore(instr.op);
+        }
+        range.end = i;
+        range.weight += uint64_t(1) << (3 * std::min<uint32_t>(depth, MAX_LOOP_DEPTH));
+    }
+
+    for (uint32_t byte = 0; byte < frameSize; ++byte)
+    {
+        ranges[byte].byte = byte;
+    }
+    for (uint32_t byte : pinned)
+    {
+        ranges[byte].start = 0;
+        ranges[byte].end = size;
+    }
+
+    // A value read around a loop's back edge is live over the whole loop;
+    // one written first thing inside the loop is not. Widening can bring a
+    // range into an outer loop, so repeat until nothing changes
+    for (LiveRange &range : ranges)
+    {
+        if (range.start == UNUSED)
+            continue;
+        bool changed = true;
+        while (changed)
+        {
+            changed = false;
+            for (const auto &[start, end] : loops)
+            {
+                if (range.end < start || range.start > end)
+                    continue;
+                if (range.start >= start && range.end <= end && range.startsWithStore)
+                    continue;
+                if (range.start > start || range.end < end)
+                {
+                    if (range.start > start)
+                        range.startsWithStore = false;
+                    range.start = std::min(range.start, start);
+                    range.end = std::max(range.end, end);
+                    changed = true;
+                }
+            }
+        }
+
+        auto call = std::upper_bound(calls.begin(), calls.end(), range.start);
+        range.acrossCall = call != calls.end() && *call < range.end;
+    }
+
+    FrameLayout layout;
+    layout.location.assign(frameSize, Operand{});
+
+    // Pinned bytes keep their order, so a string's two bytes stay adjacent
+    std::vector<bool> isPinned(frameSize, false);
+    for (uint32_t byte : pinned)
+    {
+        isPinned[byte] = true;
+    }
+    for (uint32_t byte = 0; byte < frameSize; ++byte)
+    {
+        if (isPinned[byte])
+        {
+            layout.location[byte] = {OperandKind::Frame, layout.frameSize++};
+            layout.saved.push_back(layout.location[byte]);
+        }
+    }
+
+    std::vector<LiveRange *> order;
+    order.reserve(frameSize);
+    for (LiveRange &range : ranges)
+    {
+        if (range.start != UNUSED && !isPinned[range.byte])
+            order.push_back(&range);
+    }
+    std::stable_sort(order.begin(), order.end(), [](const LiveRange *a, const LiveRange *b)
+                     { return a->weight > b->weight; });
+
+    std::vector<Slot> scratch = zeroPagePool(ZP_SCRATCH, ZP_SCRATCH_BYTES, false);
+    std::vector<Slot> saved = zeroPagePool(ZP_SAVED, static_cast<uint16_t>(std::min<uint32_t>(savedBytes, ZP_SAVED_BYTES)), true);
+    std::vector<Slot> frame;
+
+    for (LiveRange *range : order)
+    {
+        Slot *slot = firstFit(range->acrossCall ? saved : scratch, *range);
+        if (!slot)
+            slot = firstFit(frame, *range);
+        if (!slot)
+        {
+            frame.push_back({{OperandKind::Frame, layout.frameSize++}, range->acrossCall, {}});
+            slot = &frame.back();
+        }
+        slot->ranges.emplace_back(range->start, range->end);
+        layout.location[range->byte] = slot->location;
+    }
+
+    // Only values live across a call need saving for a recursive activation
+    for (const std::vector<Slot> *pool : {&saved, &frame})
+    {
+        for (const Slot &slot : *pool)
+        {
+            if (slot.acrossCall && !slot.ranges.empty())
+                layout.saved.push_back(slot.location);
+        }
+    }
+    return layout;
+}
+
+FrameLayout identityLayout(uint32_t frameSize)
+{
+    FrameLayout layout;
+    layout.frameSize = frameSize;
+    for (uint32_t byte = 0; byte < frameSize; ++byte)
+    {
+        layout.location.push_back({OperandKind::Frame, byte});
+    }
+    layout.saved = layout.location;
+    return layout;
+}
+
+void applyLayout(std::vector<Instr> &code, const FrameLayout &layout)
+{
+    for (Instr &instr : code)
+    {
+        Operand &operand = instr.operand;
+        switch (operand.kind)
+        {
+        case OperandKind::Frame:
+            operand = layout.location[operand.value];
+            break;
+        case OperandKind::FrameLo:
+        case OperandKind::FrameHi:
+            if (layout.location[operand.value].kind != OperandKind::Frame)
+                throw std::logic_error("applyLayout: address taken of a byte outside the frame");
+            operand.value = layout.location[operand.value].value;
+            break;
+        default:
+            break;
+        }
+    }
+}
@@ -0,0 +1,309 @@
+#include <stdexcept>
+#include "../include/isa.hpp"
+#include "../include/semantic.hpp"
+
+Resolver::Resolver(AstArena &ast, std::string_view source, StringInterner &names, SymbolTable &symbols)
+    : ast(ast), source(source), names(names), symbols(symbols)
+{
+}
+
+/*----- Helper: error() -----*/
+void Resolver::error(uint32_t offset, const std::string &message) const
+{
+    // Line and column are only worked out when something is wrong
+    int line = 1;
+    size_t lineStart = 0;
+    for (size_t i = 0; i < offset; ++i)
+    {
+        if (source[i] == '\n')
+        {
+            ++line;
+            lineStart = i + 1;
+        }
+    }
+    throw std::runtime_error(std::to_string(line) + ":" + std::to_string(offset - lineStart + 1) +
+                             ": error: " + message);
+}
+
+NameId Resolver::nameOf(NodeIndex identifier)
+{
+    const AstNode &node = ast.node(identifier);
+    return names.intern(source.substr(node.a, node.b));
+}
+
+uint32_t Resolver::declareLocal(NodeIndex identifier, SymbolKind kind, ValueType type)
+{
+    Symbol symbol;
+    symbol.name = nameOf(identifier);
+    symbol.kind = kind;
+    symbol.type = type;
+    symbol.slot = current->frameSize;
+    symbol.decl = identifier;
+
+    uint32_t index = symbols.declare(symbol);
+    if (index == NO_SYMBOL)
+        error(ast.node(identifier).offset, "'" + std::string(names.text(symbol.name)) + "' is already declared in this scope");
+
+    current->frameSize += valueWidth(type);
+    ast.node(identifier).c = index;
+    return index;
+}
+
+uint32_t Resolver::resolveName(NodeIndex identifier)
+{
+    NameId name = nameOf(identifier);
+    uint32_t index = symbols.lookup(name);
+    if (index == NO_SYMBOL)
+        error(ast.node(identifier).offset, "'" + std::string(names.text(name)) + "' is not declared");
+
+    ast.node(identifier).c = index;
+    return index;
+}
+
+std::vector<FunctionInfo> Resolver::declareFunctions(NodeIndex program)
+{
+    std::vector<FunctionInfo> functions;
+    NodeList list = ast.list(ast.node(program).a);
+    functions.reserve(list.count);
+
+    for (NodeIndex function : list)
+    {
+        const AstNode &node = ast.node(function);
+        Symbol symbol;
+        symbol.name = nameOf(node.a);
+        symbol.kind = SymbolKind::Function;
+        symbol.type = node.type;
+        symbol.slot = static_cast<uint32_t>(functions.size());
+        symbol.decl = function;
+
+        uint32_t index = symbols.declare(symbol);
+        if (index == NO_SYMBOL)
+            error(node.offset, "function '" + std::string(names.text(symbol.name)) + "' is defined twice");
+        ast.node(node.a).c = index;
+
+        FunctionInfo info;
+        info.node = function;
+        info.symbol = index;
+        info.paramCount = ast.list(node.b).count;
+        functions.push_back(info);
+    }
+
+    NameId main = names.find("main");
+    if (main == NO_NAME || symbols.lookup(main) == NO_SYMBOL)
+        error(static_cast<uint32_t>(source.size()), "the program has no main function");
+    return functions;
+}
+
+void Resolver::resolveFunction(FunctionInfo &function)
+{
+    current = &function;
+    function.frameSize = 0;
+
+    // Parameters and the outermost block of the body share one scope
+    const AstNode node = ast.node(function.node);
+    symbols.enterScope();
+    for (NodeIndex param : ast.list(node.b))
+    {
+        const AstNode &paramNode = ast.node(param);
+        declareLocal(paramNode.a, SymbolKind::Parameter, paramNode.type);
+    }
+    function.paramBytes = function.frameSize;
+    if (function.paramBytes > ARG_BYTES)
+        error(node.offset, "function '" + std::string(names.text(symbols.symbol(function.symbol).name)) +
+                               "' has more than " + std::to_string(ARG_BYTES) + " bytes of parameters");
+    for (NodeIndex statement : ast.list(ast.node(node.c).a))
+    {
+        resolveStatement(statement);
+    }
+    symbols.leaveScope();
+
+    current = nullptr;
+}
+
+void Resolver::resolveBlock(NodeIndex block)
+{
+    symbols.enterScope();
+    for (NodeIndex statement : ast.list(ast.node(block).a))
+    {
+        resolveStatement(statement);
+    }
+    symbols.leaveScope();
+}
+
+void Resolver::resolveStatement(NodeIndex statement)
+{
+    const AstNode node = ast.node(statement);
+    switch (node.kind)
+    {
+    case NodeKind::Block:
+        resolveBlock(statement);
+        break;
+
+    case NodeKind::VarDecl:
+    {
+        // The initializer cannot see the variable it initializes
+        ValueType type = resolveValue(node.b, "an initializer");
+        if (node.type != ValueType::Inferred)
+        {
+            checkAssignable(node.type, type, node.offset, "initialize");
+            type = node.type;
+        }
+        else
+            ast.node(statement).type = type;
+        declareLocal(node.a, SymbolKind::Variable, type);
+        break;
+    }
+
+    case NodeKind::Assign:
+    {
+        uint32_t target = resolveName(node.a);
+        if (symbols.symbol(target).kind == SymbolKind::Function)
+            error(node.offset, "cannot assign to function '" + std::string(names.text(symbols.symbol(target).name)) + "'");
+        checkAssignable(symbols.symbol(target).type, resolveValue(node.b, "an assignment"), node.offset, "assign");
+        break;
+    }
+
+    case NodeKind::Return:
+    {
+        ValueType returnType = symbols.symbol(current->symbol).type;
+        if (node.a == NO_NODE)
+        {
+            if (returnType != ValueType::Void)
+                error(node.offset, "return without a value in a function returning " + std::string(valueTypeName(returnType)));
+        }
+        else
+        {
+            if (returnType == ValueType::Void)
+                error(node.offset, "return with a value in a void function");
+            checkAssignable(returnType, resolveValue(node.a, "a return"), node.offset, "return");
+        }
+        break;
+    }
+
+    case NodeKind::While:
+        checkAssignable(ValueType::Int, resolveValue(node.a, "a condition"), node.offset, "test");
+        resolveBlock(node.b);
+        break;
+
+    case NodeKind::If:
+        checkAssignable(ValueType::Int, resolveValue(node.a, "a condition"), node.offset, "test");
+        resolveBlock(node.b);
+        if (node.c != NO_NODE)
+            resolveBlock(node.c);
+        break;
+
+    case NodeKind::Print:
+        resolveValue(node.a, "print");
+        break;
+
+    case NodeKind::Free:
+    {
+        uint32_t pointer = resolveName(node.a);
+        if (symbols.symbol(pointer).type != ValueType::String)
+            error(node.offset, "free needs a string");
+        break;
+    }
+
+    case NodeKind::ExprStmt:
+        resolveExpression(node.a);
+        break;
+
+    default:
+        error(node.offset, "unexpected node in a statement");
+    }
+}
+
+/*----- Helper: checkAssignable() -----*/
+// int and char convert freely; strings only go where strings are expected
+void Resolver::checkAssignable(ValueType target, ValueType value, uint32_t offset, const char *context)
+{
+    if ((target == ValueType::String) != (value == ValueType::String))
+        error(offset, std::string("cannot ") + context + " " + valueTypeName(value) +
+                          (target == ValueType::String ? " as a string" : " as a number"));
+}
+
+// An expression whose value is used: it may not be a void call
+ValueType Resolver::resolveValue(NodeIndex expression, const char *context)
+{
+    ValueType type = resolveExpression(expression);
+    if (type == ValueType::Void)
+        error(ast.node(expression).offset, std::string("void value used in ") + context);
+    return type;
+}
+
+ValueType Resolver::resolveExpression(NodeIndex expression)
+{
+    const AstNode node = ast.node(expression);
+    ValueType type = ValueType::Int;
+
+    switch (node.kind)
+    {
+    case NodeKind::Number:
+        break;
+
+    case NodeKind::CharLit:
+        type = ValueType::Char;
+        break;
+
+    case NodeKind::StringLit:
+    case NodeKind::Alloc:
+        type = ValueType::String;
+        if (node.kind == NodeKind::Alloc)
+            checkAssignable(ValueType::Int, resolveValue(node.a, "alloc"), node.offset, "pass");
+        break;
+
+    case NodeKind::Identifier:
+    {
+        const Symbol &symbol = symbols.symbol(resolveName(expression));
+        if (symbol.kind == SymbolKind::Function)
+            error(node.offset, "function '" + std::string(names.text(symbol.name)) + "' used as a value");
+        type = symbol.type;
+        break;
+    }
+
+    case NodeKind::Call:
+    {
+        const Symbol &callee = symbols.symbol(resolveName(node.a));
+        if (callee.kind != SymbolKind::Function)
+            error(node.offset, "'" + std::string(names.text(callee.name)) + "' is not a function");
+
+        NodeList args = ast.list(node.b);
+        uint32_t expected = ast.list(ast.node(callee.decl).b).count;
+        if (args.count != expected)
+            error(node.offset, "'" + std::string(names.text(callee.name)) + "' takes " + std::to_string(expected) +
+                                   " argument(s), " + std::to_string(args.count) + " given");
+        type = callee.type;
+        NodeList params = ast.list(ast.node(callee.decl).b);
+        for (uint32_t i = 0; i < args.count; ++i)
+        {
+            ValueType paramType = ast.node(params[i]).type;
+            checkAssignable(paramType, resolveValue(args[i], "an argument"), ast.node(args[i]).offset, "pass");
+        }
+        break;
+    }
+
+    case NodeKind::Unary:
+        if (node.op == Operator::AddressOf)
+        {
+            // &x is the address of x, a pointer like a string
+            if (ast.node(node.a).kind != NodeKind::Identifier)
+                error(node.offset, "'&' needs a variable");
+            resolveValue(node.a, "an operand");
+            type = ValueType::String;
+        }
+        else
+            checkAssignable(ValueType::Int, resolveValue(node.a, "an operand"), node.offset, "negate");
+        break;
+
+    case NodeKind::Binary:
+        checkAssignable(ValueType::Int, resolveValue(node.a, "an operand"), node.offset, "use");
+        checkAssignable(ValueType::Int, resolveValue(node.b, "an operand"), node.offset, "use");
+        break;
+
+    default:
+        error(node.offset, "unexpected node in an expression");
+    }
+
+    ast.node(expression).type = type;
+    return type;
+}
@@ -0,0 +1,45 @@
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../include/source_file.hpp"
+
+SourceFile::SourceFile(const std::string &path) : filePath(path)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Error: could not open file '" + path + "'");
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0)
+    {
+        close(fd);
+        throw std::runtime_error("Error: could not stat file '" + path + "'");
+    }
+
+    size = static_cast<size_t>(info.st_size);
+    if (size > 0)
+    {
+        void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED)
+        {
+            close(fd);
+            throw std::runtime_error("Error: could not map file '" + path + "'");
+        }
+        // The lexer reads the file front to back exactly once
+        madvise(mapping, size, MADV_SEQUENTIAL);
+        data = static_cast<const char *>(mapping);
+    }
+    close(fd);
+}
+
+SourceFile::~SourceFile()
+{
+    if (data)
+    {
+        munmap(const_cast<char *>(data), size);
+    }
+}
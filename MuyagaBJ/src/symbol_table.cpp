@@ -0,0 +1,154 @@
+#include "../include/symbol_table.hpp"
+
+// -----------------------------
+// StringInterner
+// -----------------------------
+
+static constexpr size_t INITIAL_TABLE_SIZE = 64;
+
+/*----- Helper: hashText() -----*/
+// FNV-1a
+static uint32_t hashText(std::string_view text)
+{
+    uint32_t hash = 2166136261u;
+    for (char c : text)
+    {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 16777619u;
+    }
+    return hash;
+}
+
+StringInterner::StringInterner() : table(INITIAL_TABLE_SIZE, NO_NAME) {}
+
+// Slot holding text, or the empty slot where it would go
+size_t StringInterner::probe(std::string_view text, uint32_t hash) const
+{
+    size_t mask = table.size() - 1;
+    for (size_t slot = hash & mask;; slot = (slot + 1) & mask)
+    {
+        NameId id = table[slot];
+        if (id == NO_NAME || (hashes[id] == hash && names[id] == text))
+            return slot;
+    }
+}
+
+void StringInterner::grow()
+{
+    std::vector<NameId> bigger(table.size() * 2, NO_NAME);
+    size_t mask = bigger.size() - 1;
+    for (NameId id = 0; id < names.size(); ++id)
+    {
+        size_t slot = hashes[id] & mask;
+        while (bigger[slot] != NO_NAME)
+        {
+            slot = (slot + 1) & mask;
+        }
+        bigger[slot] = id;
+    }
+    table.swap(bigger);
+}
+
+NameId StringInterner::intern(std::string_view text)
+{
+    uint32_t hash = hashText(text);
+    size_t slot = probe(text, hash);
+    if (table[slot] != NO_NAME)
+        return table[slot];
+
+    NameId id = static_cast<NameId>(names.size());
+    names.push_back(text);
+    hashes.push_back(hash);
+    table[slot] = id;
+
+    // Keep the load factor at most 1/2
+    if (names.size() * 2 > table.size())
+        grow();
+    return id;
+}
+
+NameId StringInterner::find(std::string_view text) const
+{
+    return table[probe(text, hashText(text))];
+}
+
+// -----------------------------
+// SymbolTable
+// -----------------------------
+
+/*----- Helper: hashName() -----*/
+// Fibonacci hashing spreads the dense ids over the table
+static size_t hashName(NameId name)
+{
+    return static_cast<size_t>(name * 2654435769u);
+}
+
+SymbolTable::SymbolTable() : table(INITIAL_TABLE_SIZE) {}
+
+size_t SymbolTable::probe(NameId name) const
+{
+    size_t mask = table.size() - 1;
+    for (size_t slot = hashName(name) & mask;; slot = (slot + 1) & mask)
+    {
+        if (table[slot].name == name || table[slot].name == NO_NAME)
+            return slot;
+    }
+}
+
+void SymbolTable::grow()
+{
+    std::vector<Entry> old(table.size() * 2);
+    old.swap(table);
+    for (const Entry &entry : old)
+    {
+        if (entry.name != NO_NAME)
+            table[probe(entry.name)] = entry;
+    }
+}
+
+void SymbolTable::enterScope()
+{
+    scopeMarks.push_back(undoLog.size());
+}
+
+void SymbolTable::leaveScope()
+{
+    size_t mark = scopeMarks.back();
+    scopeMarks.pop_back();
+    while (undoLog.size() > mark)
+    {
+        const Undo &undo = undoLog.back();
+        table[probe(undo.name)].symbol = undo.previous;
+        undoLog.pop_back();
+    }
+}
+
+uint32_t SymbolTable::declare(Symbol symbol)
+{
+    size_t slot = probe(symbol.name);
+    Entry &entry = table[slot];
+
+    uint32_t previous = entry.name == NO_NAME ? NO_SYMBOL : entry.symbol;
+    if (previous != NO_SYMBOL && symbols[previous].depth == depth())
+        return NO_SYMBOL;
+
+    if (entry.name == NO_NAME)
+        ++used;
+    entry.name = symbol.name;
+
+    symbol.depth = depth();
+    uint32_t index = static_cast<uint32_t>(symbols.size());
+    symbols.push_back(symbol);
+    entry.symbol = index;
+    undoLog.push_back({symbol.name, previous});
+
+    // Entries are only reset, never removed, so used counts every name seen
+    if (used * 2 > table.size())
+        grow();
+    return index;
+}
+
+uint32_t SymbolTable::lookup(NameId name) const
+{
+    const Entry &entry = table[probe(name)];
+    return entry.name == name ? entry.symbol : NO_SYMBOL;
+}
@@ -1,3 +1,3 @@
 #!/usr/bin/env bash
 set -e
-./build/vm/main_vm
+./build/vm/main_vm "$@"
@@ -0,0 +1,85 @@
+#pragma once
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include "instructions.hpp"
+#include "memory.hpp"
+
+// -----------------------------
+// CPU
+// -----------------------------
+
+/*
+  The 6502 subset of instruction_set.md plus SYS. run() keeps the
+  registers in locals and jumps from handler to handler through a
+  256-entry table indexed by opcode, so each instruction costs one
+  indirect jump; unlisted opcodes land on a handler that stops.
+
+  N and Z are lazy: instructions that would set them only store their
+  result, and the flags are derived when a branch, PHP or status()
+  reads them. C and V are computed by the few instructions that set
+  them. Decimal mode is recorded but ADC and SBC stay binary, as the
+  compiler never sets it.
+*/
+
+enum class StopReason
+{
+    Break,         // BRK: the end of a MuyagaBJ program
+    IllegalOpcode, // not in instruction_set.md
+    Limit          // the instruction budget ran out
+};
+
+struct Registers
+{
+    uint16_t pc = LOAD_ADDRESS;
+    uint8_t a = 0;
+    uint8_t x = 0;
+    uint8_t y = 0;
+    uint8_t sp = 0xFF;
+    uint8_t status = FLAG_UNUSED | FLAG_INTERRUPT;
+};
+
+class Cpu
+{
+public:
+    /**
+     * @param console - where the SYS print services write.
+     */
+    Cpu(Memory &memory, std::ostream &console);
+
+    /**
+     * Registers as at power-on, pc at entry; frees the whole SYS heap.
+     */
+    void reset(uint16_t entry = LOAD_ADDRESS);
+
+    /**
+     * Execute until BRK, an illegal opcode, or limit instructions. BRK
+     * and an illegal opcode leave pc on the opcode; after Limit, run()
+     * continues where it stopped.
+     */
+    StopReason run(uint64_t limit = UINT64_MAX);
+
+    Registers registers() const;
+    void setRegisters(const Registers &registers);
+
+    uint64_t instructionCount() const { return executed; }
+
+private:
+    Memory &memory;
+    std::ostream &console;
+
+    uint16_t pc;
+    uint8_t a, x, y, sp;
+    uint8_t carry;      // 0 or 1
+    uint8_t overflow;   // 0 or FLAG_OVERFLOW
+    uint8_t otherFlags; // I and D
+    // The last result that set N and Z: Z when the low byte is 0, N when
+    // bit 7 or bit 8 is set. Bit 8 only comes from PLP, for N and Z together.
+    uint16_t nz;
+    uint64_t executed = 0;
+
+    std::map<uint16_t, uint16_t> heapBlocks; // SYS heap: address -> size
+
+    void systemCall();
+    uint16_t allocate(uint16_t size);
+};
@@ -0,0 +1,114 @@
+#pragma once
+#include <cstdint>
+
+// -----------------------------
+// Instruction set
+// -----------------------------
+
+/*
+  Every opcode of instruction_set.md, one X(opcode, mnemonic, mode) entry
+  each. The CPU builds its dispatch table from this list, so an opcode
+  missing here is illegal in the VM as well.
+*/
+
+enum class AddressMode : uint8_t
+{
+    Implied,
+    Immediate,
+    ZeroPage,
+    Absolute,
+    Relative
+};
+
+#define MUYAGA_INSTRUCTIONS(X)           \
+    /* Load and store */                 \
+    X(0xA9, LDA, Immediate)              \
+    X(0xA5, LDA, ZeroPage)               \
+    X(0xAD, LDA, Absolute)               \
+    X(0xA2, LDX, Immediate)              \
+    X(0xA6, LDX, ZeroPage)               \
+    X(0xAE, LDX, Absolute)               \
+    X(0xA0, LDY, Immediate)              \
+    X(0xA4, LDY, ZeroPage)               \
+    X(0xAC, LDY, Absolute)               \
+    X(0x85, STA, ZeroPage)               \
+    X(0x8D, STA, Absolute)               \
+    X(0x86, STX, ZeroPage)               \
+    X(0x8E, STX, Absolute)               \
+    X(0x84, STY, ZeroPage)               \
+    X(0x8C, STY, Absolute)               \
+    /* Arithmetic and logic */           \
+    X(0x69, ADC, Immediate)              \
+    X(0x65, ADC, ZeroPage)               \
+    X(0x6D, ADC, Absolute)               \
+    X(0xE9, SBC, Immediate)              \
+    X(0xE5, SBC, ZeroPage)               \
+    X(0xED, SBC, Absolute)               \
+    X(0xE6, INC, ZeroPage)               \
+    X(0xEE, INC, Absolute)               \
+    X(0xC6, DEC, ZeroPage)               \
+    X(0xCE, DEC, Absolute)               \
+    X(0xC9, CMP, Immediate)              \
+    X(0xC5, CMP, ZeroPage)               \
+    X(0xCD, CMP, Absolute)               \
+    X(0xE0, CPX, Immediate)              \
+    X(0xE4, CPX, ZeroPage)               \
+    X(0xEC, CPX, Absolute)               \
+    X(0xC0, CPY, Immediate)              \
+    X(0xC4, CPY, ZeroPage)               \
+    X(0xCC, CPY, Absolute)               \
+    X(0x29, AND, Immediate)              \
+    X(0x25, AND, ZeroPage)               \
+    X(0x2D, AND, Absolute)               \
+    X(0x09, ORA, Immediate)              \
+    X(0x05, ORA, ZeroPage)               \
+    X(0x0D, ORA, Absolute)               \
+    X(0x49, EOR, Immediate)              \
+    X(0x45, EOR, ZeroPage)               \
+    X(0x4D, EOR, Absolute)               \
+    /* Branching and control flow */     \
+    X(0xD0, BNE, Relative)               \
+    X(0xF0, BEQ, Relative)               \
+    X(0x90, BCC, Relative)               \
+    X(0xB0, BCS, Relative)               \
+    X(0x30, BMI, Relative)               \
+    X(0x10, BPL, Relative)               \
+    X(0x4C, JMP, Absolute)               \
+    X(0x20, JSR, Absolute)               \
+    X(0x60, RTS, Implied)                \
+    /* Stack */                          \
+    X(0x48, PHA, Implied)                \
+    X(0x68, PLA, Implied)                \
+    X(0x08, PHP, Implied)                \
+    X(0x28, PLP, Implied)                \
+    X(0x9A, TXS, Implied)                \
+    X(0xBA, TSX, Implied)                \
+    /* Flags and processor control */    \
+    X(0x18, CLC, Implied)                \
+    X(0x38, SEC, Implied)                \
+    X(0x58, CLI, Implied)                \
+    X(0x78, SEI, Implied)                \
+    X(0xB8, CLV, Implied)                \
+    X(0xD8, CLD, Implied)                \
+    X(0xF8, SED, Implied)                \
+    X(0xEA, NOP, Implied)                \
+    X(0x00, BRK, Implied)                \
+    /* MuyagaBJ extension */             \
+    X(0xFF, SYS, Implied)
+
+// Processor status bits, as PHP pushes them
+constexpr uint8_t FLAG_CARRY = 0x01;
+constexpr uint8_t FLAG_ZERO = 0x02;
+constexpr uint8_t FLAG_INTERRUPT = 0x04;
+constexpr uint8_t FLAG_DECIMAL = 0x08;
+constexpr uint8_t FLAG_BREAK = 0x10;
+constexpr uint8_t FLAG_UNUSED = 0x20; // always reads as 1
+constexpr uint8_t FLAG_OVERFLOW = 0x40;
+constexpr uint8_t FLAG_NEGATIVE = 0x80;
+
+// SYS services, selected by X
+constexpr uint8_t SYS_PRINT_INT = 0x01;  // Y as an unsigned number
+constexpr uint8_t SYS_PRINT_STR = 0x02;  // null-terminated string at A:Y
+constexpr uint8_t SYS_ALLOC = 0x03;      // Y bytes; address in A:Y, 0 if the heap is full
+constexpr uint8_t SYS_FREE = 0x04;       // block at A:Y
+constexpr uint8_t SYS_PRINT_CHAR = 0x05; // Y as a character
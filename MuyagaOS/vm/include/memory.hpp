@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "vm_config.hpp"
+
+// -----------------------------
+// Memory
+// -----------------------------
+
+/*
+  64 KB of flat RAM. The CPU reads and writes data() directly, so there
+  is no per-access call on the hot path; devices are not mapped yet.
+*/
+class Memory
+{
+public:
+    Memory();
+
+    uint8_t *data() { return bytes.data(); }
+    uint8_t read(uint16_t address) const { return bytes[address]; }
+    void write(uint16_t address, uint8_t value) { bytes[address] = value; }
+
+    /**
+     * Copy an image into memory at address.
+     * @throws std::runtime_error if it does not fit below 0x10000.
+     */
+    void load(uint16_t address, const std::vector<uint8_t> &image);
+
+    /**
+     * Read a program file (e.g. a MuyagaBJ .bin) into memory at address.
+     * @throws std::runtime_error if it cannot be read or does not fit.
+     */
+    void loadFile(uint16_t address, const std::string &path);
+
+private:
+    std::vector<uint8_t> bytes;
+};
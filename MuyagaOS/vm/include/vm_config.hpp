@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+
+// -----------------------------
+// VM configuration
+// -----------------------------
+
+/*
+  The memory map shared with the MuyagaBJ compiler (instruction_set.md,
+  section 9): programs load and start at LOAD_ADDRESS, and SYS 03 hands
+  out heap blocks from HEAP_START up to HEAP_END.
+*/
+
+constexpr uint32_t MEMORY_SIZE = 0x10000;
+constexpr uint16_t STACK_PAGE = 0x0100;
+constexpr uint16_t LOAD_ADDRESS = 0x0200;
+constexpr uint16_t HEAP_START = 0x6000;
+constexpr uint16_t HEAP_END = 0x8000; // exclusive; 0x8000 and up is reserved for the OS
+
+/*
+  The CPU dispatches through a 256-entry table of handler addresses
+  (computed goto) where the compiler has labels as values, and through
+  a switch elsewhere. Define MUYAGA_THREADED_DISPATCH as 0 to force the
+  switch.
+*/
+#ifndef MUYAGA_THREADED_DISPATCH
+#if defined(__GNUC__) || defined(__clang__)
+#define MUYAGA_THREADED_DISPATCH 1
+#else
+#define MUYAGA_THREADED_DISPATCH 0
+#endif
+#endif
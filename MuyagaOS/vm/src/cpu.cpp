@@ -0,0 +1,368 @@
+#include <algorithm>
+#include <ostream>
+#include "cpu.hpp"
+
+/*----- Helper: nzFromStatus() -----*/
+// The lazy N/Z value that reads back as the N and Z bits of status
+static uint16_t nzFromStatus(uint8_t status)
+{
+    bool negative = status & FLAG_NEGATIVE;
+    if (status & FLAG_ZERO)
+        return negative ? 0x100 : 0;
+    return negative ? 0x80 : 1;
+}
+
+/*----- Helper: packStatus() -----*/
+static uint8_t packStatus(uint16_t nz, uint8_t overflow, uint8_t otherFlags, uint8_t carry)
+{
+    uint8_t negative = (nz & 0x180) ? FLAG_NEGATIVE : 0;
+    uint8_t zero = (nz & 0xFF) == 0 ? FLAG_ZERO : 0;
+    return negative | overflow | FLAG_UNUSED | otherFlags | zero | carry;
+}
+
+Cpu::Cpu(Memory &memory, std::ostream &console) : memory(memory), console(console)
+{
+    reset();
+}
+
+void Cpu::reset(uint16_t entry)
+{
+    Registers initial;
+    initial.pc = entry;
+    setRegisters(initial);
+    heapBlocks.clear();
+    executed = 0;
+}
+
+Registers Cpu::registers() const
+{
+    Registers current;
+    current.pc = pc;
+    current.a = a;
+    current.x = x;
+    current.y = y;
+    current.sp = sp;
+    current.status = packStatus(nz, overflow, otherFlags, carry);
+    return current;
+}
+
+void Cpu::setRegisters(const Registers &registers)
+{
+    pc = registers.pc;
+    a = registers.a;
+    x = registers.x;
+    y = registers.y;
+    sp = registers.sp;
+    carry = registers.status & FLAG_CARRY;
+    overflow = registers.status & FLAG_OVERFLOW;
+    otherFlags = registers.status & (FLAG_INTERRUPT | FLAG_DECIMAL);
+    nz = nzFromStatus(registers.status);
+}
+
+/*
+  The handlers are written once. With threaded dispatch HANDLER is a
+  label whose address goes in the table and NEXT jumps straight to the
+  next handler; otherwise HANDLER is a case and NEXT loops back to the
+  switch. NEXT also spends one instruction of the budget.
+*/
+#define OPERAND (mem[uint16_t(pc + 1)])
+#define ADDRESS (uint16_t(mem[uint16_t(pc + 1)] | mem[uint16_t(pc + 2)] << 8))
+#define PUSH(value) (mem[STACK_PAGE + sp--] = (value))
+#define PULL() (mem[STACK_PAGE + ++sp])
+
+#if MUYAGA_THREADED_DISPATCH
+#define HANDLER(opcode) op_##opcode:
+#define NEXT                     \
+    if (--remaining == 0)        \
+        goto outOfBudget;        \
+    goto *table[mem[pc]]
+#else
+#define HANDLER(opcode) case opcode:
+#define NEXT                     \
+    if (--remaining == 0)        \
+        goto outOfBudget;        \
+    continue
+#endif
+
+// C is the carry out of bit 7; V is set when both inputs have the same
+// sign and the sum has the other one
+#define ADD(value)                                                                     \
+    {                                                                                  \
+        uint8_t operand = (value);                                                     \
+        unsigned sum = a + operand + carry;                                            \
+        overflow = (~(a ^ operand) & (a ^ sum) & 0x80) ? FLAG_OVERFLOW : 0;            \
+        carry = uint8_t(sum >> 8);                                                     \
+        a = uint8_t(sum);                                                              \
+        nz = a;                                                                        \
+    }
+
+// SBC is ADC of the complement, with C as "no borrow"
+#define SUBTRACT(value) ADD(uint8_t(~(value)))
+
+#define COMPARE(reg, value)                 \
+    {                                       \
+        uint8_t operand = (value);          \
+        carry = (reg) >= operand;           \
+        nz = uint8_t((reg) - operand);      \
+    }
+
+#define BRANCH(condition)                                    \
+    {                                                        \
+        if (condition)                                       \
+            pc = uint16_t(pc + 2 + int8_t(OPERAND));         \
+        else                                                 \
+            pc += 2;                                         \
+    }
+
+StopReason Cpu::run(uint64_t limit)
+{
+    uint8_t *mem = memory.data();
+    // The registers live in locals while running and are written back
+    // on every way out, so the compiler can keep them in host registers
+    uint16_t pc = this->pc;
+    uint8_t a = this->a, x = this->x, y = this->y, sp = this->sp;
+    uint8_t carry = this->carry, overflow = this->overflow, otherFlags = this->otherFlags;
+    uint16_t nz = this->nz;
+    uint64_t remaining = limit;
+    StopReason reason;
+
+    if (remaining == 0)
+        goto outOfBudget;
+
+#if MUYAGA_THREADED_DISPATCH
+    void *table[256];
+    for (void *&handler : table)
+    {
+        handler = &&illegal;
+    }
+#define FILL_TABLE(opcode, mnemonic, mode) table[opcode] = &&op_##opcode;
+    MUYAGA_INSTRUCTIONS(FILL_TABLE)
+#undef FILL_TABLE
+    goto *table[mem[pc]];
+#else
+    for (;;)
+    {
+        switch (mem[pc])
+        {
+        default:
+            goto illegal;
+#endif
+
+    // Load and store
+    HANDLER(0xA9) { a = OPERAND; nz = a; pc += 2; NEXT; }
+    HANDLER(0xA5) { a = mem[OPERAND]; nz = a; pc += 2; NEXT; }
+    HANDLER(0xAD) { a = mem[ADDRESS]; nz = a; pc += 3; NEXT; }
+    HANDLER(0xA2) { x = OPERAND; nz = x; pc += 2; NEXT; }
+    HANDLER(0xA6) { x = mem[OPERAND]; nz = x; pc += 2; NEXT; }
+    HANDLER(0xAE) { x = mem[ADDRESS]; nz = x; pc += 3; NEXT; }
+    HANDLER(0xA0) { y = OPERAND; nz = y; pc += 2; NEXT; }
+    HANDLER(0xA4) { y = mem[OPERAND]; nz = y; pc += 2; NEXT; }
+    HANDLER(0xAC) { y = mem[ADDRESS]; nz = y; pc += 3; NEXT; }
+    HANDLER(0x85) { mem[OPERAND] = a; pc += 2; NEXT; }
+    HANDLER(0x8D) { mem[ADDRESS] = a; pc += 3; NEXT; }
+    HANDLER(0x86) { mem[OPERAND] = x; pc += 2; NEXT; }
+    HANDLER(0x8E) { mem[ADDRESS] = x; pc += 3; NEXT; }
+    HANDLER(0x84) { mem[OPERAND] = y; pc += 2; NEXT; }
+    HANDLER(0x8C) { mem[ADDRESS] = y; pc += 3; NEXT; }
+
+    // Arithmetic and logic
+    HANDLER(0x69) { ADD(OPERAND); pc += 2; NEXT; }
+    HANDLER(0x65) { ADD(mem[OPERAND]); pc += 2; NEXT; }
+    HANDLER(0x6D) { ADD(mem[ADDRESS]); pc += 3; NEXT; }
+    HANDLER(0xE9) { SUBTRACT(OPERAND); pc += 2; NEXT; }
+    HANDLER(0xE5) { SUBTRACT(mem[OPERAND]); pc += 2; NEXT; }
+    HANDLER(0xED) { SUBTRACT(mem[ADDRESS]); pc += 3; NEXT; }
+    HANDLER(0xE6) { uint8_t &cell = mem[OPERAND]; nz = ++cell; pc += 2; NEXT; }
+    HANDLER(0xEE) { uint8_t &cell = mem[ADDRESS]; nz = ++cell; pc += 3; NEXT; }
+    HANDLER(0xC6) { uint8_t &cell = mem[OPERAND]; nz = --cell; pc += 2; NEXT; }
+    HANDLER(0xCE) { uint8_t &cell = mem[ADDRESS]; nz = --cell; pc += 3; NEXT; }
+    HANDLER(0xC9) { COMPARE(a, OPERAND); pc += 2; NEXT; }
+    HANDLER(0xC5) { COMPARE(a, mem[OPERAND]); pc += 2; NEXT; }
+    HANDLER(0xCD) { COMPARE(a, mem[ADDRESS]); pc += 3; NEXT; }
+    HANDLER(0xE0) { COMPARE(x, OPERAND); pc += 2; NEXT; }
+    HANDLER(0xE4) { COMPARE(x, mem[OPERAND]); pc += 2; NEXT; }
+    HANDLER(0xEC) { COMPARE(x, mem[ADDRESS]); pc += 3; NEXT; }
+    HANDLER(0xC0) { COMPARE(y, OPERAND); pc += 2; NEXT; }
+    HANDLER(0xC4) { COMPARE(y, mem[OPERAND]); pc += 2; NEXT; }
+    HANDLER(0xCC) { COMPARE(y, mem[ADDRESS]); pc += 3; NEXT; }
+    HANDLER(0x29) { a &= OPERAND; nz = a; pc += 2; NEXT; }
+    HANDLER(0x25) { a &= mem[OPERAND]; nz = a; pc += 2; NEXT; }
+    HANDLER(0x2D) { a &= mem[ADDRESS]; nz = a; pc += 3; NEXT; }
+    HANDLER(0x09) { a |= OPERAND; nz = a; pc += 2; NEXT; }
+    HANDLER(0x05) { a |= mem[OPERAND]; nz = a; pc += 2; NEXT; }
+    HANDLER(0x0D) { a |= mem[ADDRESS]; nz = a; pc += 3; NEXT; }
+    HANDLER(0x49) { a ^= OPERAND; nz = a; pc += 2; NEXT; }
+    HANDLER(0x45) { a ^= mem[OPERAND]; nz = a; pc += 2; NEXT; }
+    HANDLER(0x4D) { a ^= mem[ADDRESS]; nz = a; pc += 3; NEXT; }
+
+    // Branching and control flow
+    HANDLER(0xD0) { BRANCH((nz & 0xFF) != 0); NEXT; }
+    HANDLER(0xF0) { BRANCH((nz & 0xFF) == 0); NEXT; }
+    HANDLER(0x90) { BRANCH(!carry); NEXT; }
+    HANDLER(0xB0) { BRANCH(carry); NEXT; }
+    HANDLER(0x30) { BRANCH(nz & 0x180); NEXT; }
+    HANDLER(0x10) { BRANCH(!(nz & 0x180)); NEXT; }
+    HANDLER(0x4C) { pc = ADDRESS; NEXT; }
+    HANDLER(0x20)
+    {
+        // Pushes the address of its own last byte; RTS adds the one
+        uint16_t target = ADDRESS;
+        uint16_t last = uint16_t(pc + 2);
+        PUSH(uint8_t(last >> 8));
+        PUSH(uint8_t(last));
+        pc = target;
+        NEXT;
+    }
+    HANDLER(0x60)
+    {
+        uint8_t low = PULL();
+        uint8_t high = PULL();
+        pc = uint16_t((high << 8 | low) + 1);
+        NEXT;
+    }
+
+    // Stack
+    HANDLER(0x48) { PUSH(a); pc += 1; NEXT; }
+    HANDLER(0x68) { a = PULL(); nz = a; pc += 1; NEXT; }
+    HANDLER(0x08) { PUSH(packStatus(nz, overflow, otherFlags, carry) | FLAG_BREAK); pc += 1; NEXT; }
+    HANDLER(0x28)
+    {
+        uint8_t status = PULL();
+        carry = status & FLAG_CARRY;
+        overflow = status & FLAG_OVERFLOW;
+        otherFlags = status & (FLAG_INTERRUPT | FLAG_DECIMAL);
+        nz = nzFromStatus(status);
+        pc += 1;
+        NEXT;
+    }
+    HANDLER(0x9A) { sp = x; pc += 1; NEXT; }
+    HANDLER(0xBA) { x = sp; nz = x; pc += 1; NEXT; }
+
+    // Flags and processor control
+    HANDLER(0x18) { carry = 0; pc += 1; NEXT; }
+    HANDLER(0x38) { carry = 1; pc += 1; NEXT; }
+    HANDLER(0x58) { otherFlags &= ~FLAG_INTERRUPT; pc += 1; NEXT; }
+    HANDLER(0x78) { otherFlags |= FLAG_INTERRUPT; pc += 1; NEXT; }
+    HANDLER(0xB8) { overflow = 0; pc += 1; NEXT; }
+    HANDLER(0xD8) { otherFlags &= ~FLAG_DECIMAL; pc += 1; NEXT; }
+    HANDLER(0xF8) { otherFlags |= FLAG_DECIMAL; pc += 1; NEXT; }
+    HANDLER(0xEA) { pc += 1; NEXT; }
+    HANDLER(0x00)
+    {
+        --remaining;
+        reason = StopReason::Break;
+        goto stop;
+    }
+
+    // SYS goes through the members, like any other way out of the loop
+    HANDLER(0xFF)
+    {
+        this->a = a;
+        this->x = x;
+        this->y = y;
+        systemCall();
+        a = this->a;
+        y = this->y;
+        pc += 1;
+        NEXT;
+    }
+
+#if !MUYAGA_THREADED_DISPATCH
+        }
+    }
+#endif
+
+illegal:
+    reason = StopReason::IllegalOpcode;
+    goto stop;
+
+outOfBudget:
+    reason = StopReason::Limit;
+
+stop:
+    this->pc = pc;
+    this->a = a;
+    this->x = x;
+    this->y = y;
+    this->sp = sp;
+    this->carry = carry;
+    this->overflow = overflow;
+    this->otherFlags = otherFlags;
+    this->nz = nz;
+    executed += limit - remaining;
+    return reason;
+}
+
+#undef OPERAND
+#undef ADDRESS
+#undef PUSH
+#undef PULL
+#undef HANDLER
+#undef NEXT
+#undef ADD
+#undef SUBTRACT
+#undef COMPARE
+#undef BRANCH
+
+void Cpu::systemCall()
+{
+    const uint8_t *mem = memory.data();
+    uint16_t address = uint16_t(a << 8 | y);
+
+    switch (x)
+    {
+    case SYS_PRINT_INT:
+        console << unsigned(y) << '\n';
+        break;
+
+    case SYS_PRINT_STR:
+        // Bounded, in case the string runs off the end of memory
+        for (uint32_t i = 0; i < MEMORY_SIZE && mem[uint16_t(address + i)] != 0; ++i)
+        {
+            console.put(static_cast<char>(mem[uint16_t(address + i)]));
+        }
+        console.put('\n');
+        break;
+
+    case SYS_ALLOC:
+    {
+        uint16_t block = allocate(y);
+        a = uint8_t(block >> 8);
+        y = uint8_t(block);
+        break;
+    }
+
+    case SYS_FREE:
+        heapBlocks.erase(address);
+        break;
+
+    case SYS_PRINT_CHAR:
+        console.put(static_cast<char>(y));
+        console.put('\n');
+        break;
+
+    default:
+        break; // unknown services do nothing
+    }
+}
+
+/*----- Helper: allocate() -----*/
+// First fit between the blocks in use; zeroed, so a fresh string is empty
+uint16_t Cpu::allocate(uint16_t size)
+{
+    size = size == 0 ? 1 : size;
+    uint32_t start = HEAP_START;
+    for (const auto &[address, length] : heapBlocks)
+    {
+        if (address - start >= size)
+            break;
+        start = uint32_t(address) + length;
+    }
+    if (start + size > HEAP_END)
+        return 0;
+
+    heapBlocks.emplace(uint16_t(start), size);
+    uint8_t *mem = memory.data();
+    std::fill(mem + start, mem + start + size, 0);
+    return uint16_t(start);
+}
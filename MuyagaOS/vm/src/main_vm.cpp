@@ -0,0 +1,74 @@
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include "cpu.hpp"
+#include "memory.hpp"
+
+/*
+  main_vm: load a MuyagaBJ binary at LOAD_ADDRESS and run it until BRK.
+
+  Usage: main_vm [--stats] [--limit N] <program.bin>
+*/
+
+int main(int argc, char *argv[])
+{
+    bool showStats = false;
+    bool usageError = false;
+    uint64_t limit = UINT64_MAX;
+    std::string path;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--stats")
+            showStats = true;
+        else if (arg == "--limit" && i + 1 < argc)
+            limit = std::stoull(argv[++i]);
+        else if (path.empty() && arg[0] != '-')
+            path = arg;
+        else
+            usageError = true;
+    }
+    if (usageError || path.empty())
+    {
+        std::cerr << "Usage: " << argv[0] << " [--stats] [--limit N] <program.bin>\n";
+        return 1;
+    }
+
+    std::ios::sync_with_stdio(false);
+    Memory memory;
+    try
+    {
+        memory.loadFile(LOAD_ADDRESS, path);
+    }
+    catch (const std::runtime_error &e)
+    {
+        std::cerr << path << ": " << e.what() << "\n";
+        return 1;
+    }
+
+    Cpu cpu(memory, std::cout);
+    auto start = std::chrono::steady_clock::now();
+    StopReason reason = cpu.run(limit);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout.flush();
+
+    Registers registers = cpu.registers();
+    char where[8];
+    std::snprintf(where, sizeof where, "$%04X", registers.pc);
+    if (reason == StopReason::IllegalOpcode)
+    {
+        char opcode[4];
+        std::snprintf(opcode, sizeof opcode, "$%02X", memory.read(registers.pc));
+        std::cerr << path << ": illegal opcode " << opcode << " at " << where << "\n";
+    }
+    else if (reason == StopReason::Limit)
+        std::cerr << path << ": stopped at " << where << " after " << cpu.instructionCount() << " instructions\n";
+
+    if (showStats)
+        std::cerr << "[Stats] " << cpu.instructionCount() << " instructions in " << seconds * 1e3 << " ms, "
+                  << (seconds > 0 ? cpu.instructionCount() / seconds / 1e6 : 0) << " million per second\n";
+    return reason == StopReason::Break ? 0 : 1;
+}
@@ -0,0 +1,24 @@
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include "memory.hpp"
+
+Memory::Memory() : bytes(MEMORY_SIZE, 0) {}
+
+void Memory::load(uint16_t address, const std::vector<uint8_t> &image)
+{
+    if (address + image.size() > MEMORY_SIZE)
+        throw std::runtime_error("image of " + std::to_string(image.size()) + " bytes does not fit at address " +
+                                 std::to_string(address));
+    std::copy(image.begin(), image.end(), bytes.begin() + address);
+}
+
+void Memory::loadFile(uint16_t address, const std::string &path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        throw std::runtime_error("cannot open '" + path + "'");
+    std::vector<uint8_t> image((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    load(address, image);
+}
@@ -0,0 +1,342 @@
+#include <cstdio>
+#include <sstream>
+#include <vector>
+#include "cpu.hpp"
+#include "memory.hpp"
+
+/*
+  CPU tests. Each loads a few hand-assembled instructions at LOAD_ADDRESS,
+  runs them to BRK and checks registers, flags, the stack and the heap.
+  vm/CMakeLists.txt builds this file twice, once per dispatch mode.
+*/
+
+static int failures = 0;
+
+#define CHECK(condition) check((condition), #condition, __FILE__, __LINE__)
+
+static void check(bool ok, const char *what, const char *file, int line)
+{
+    if (ok)
+        return;
+    std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, what);
+    ++failures;
+}
+
+static bool flag(const Registers &registers, uint8_t mask)
+{
+    return (registers.status & mask) != 0;
+}
+
+// A CPU with its own memory and console
+struct Machine
+{
+    Memory memory;
+    std::ostringstream console;
+    Cpu cpu{memory, console};
+
+    // Load code at LOAD_ADDRESS and run it from a reset to BRK
+    Registers run(const std::vector<uint8_t> &code)
+    {
+        memory.load(LOAD_ADDRESS, code);
+        cpu.reset();
+        CHECK(cpu.run(10000) == StopReason::Break);
+        return cpu.registers();
+    }
+
+    // One SYS call with service in X, without a reset, so the heap persists
+    Registers sys(uint8_t service, uint8_t a, uint8_t y)
+    {
+        memory.load(LOAD_ADDRESS, {0xFF, 0x00}); // SYS; BRK
+        Registers registers = cpu.registers();
+        registers.pc = LOAD_ADDRESS;
+        registers.a = a;
+        registers.x = service;
+        registers.y = y;
+        cpu.setRegisters(registers);
+        CHECK(cpu.run(10) == StopReason::Break);
+        return cpu.registers();
+    }
+};
+
+struct ArithmeticCase
+{
+    bool carryIn;
+    uint8_t a;
+    uint8_t operand;
+    uint8_t result;
+    bool carry;
+    bool overflow;
+};
+
+static void testAddWithCarry()
+{
+    const ArithmeticCase cases[] = {
+        {false, 0x01, 0x01, 0x02, false, false},
+        {false, 0x50, 0x50, 0xA0, false, true},  // positive + positive = negative
+        {false, 0xFF, 0x01, 0x00, true, false},  // carry out, zero
+        {true, 0x7F, 0x00, 0x80, false, true},   // the carry in overflows
+        {false, 0xD0, 0x90, 0x60, true, true},   // negative + negative = positive
+        {true, 0xFF, 0xFF, 0xFF, true, false},
+    };
+    for (const ArithmeticCase &test : cases)
+    {
+        Machine machine;
+        // CLC or SEC; LDA #a; ADC #operand; BRK
+        Registers r = machine.run({uint8_t(test.carryIn ? 0x38 : 0x18), 0xA9, test.a, 0x69, test.operand, 0x00});
+        CHECK(r.a == test.result);
+        CHECK(flag(r, FLAG_CARRY) == test.carry);
+        CHECK(flag(r, FLAG_OVERFLOW) == test.overflow);
+        CHECK(flag(r, FLAG_ZERO) == (test.result == 0));
+        CHECK(flag(r, FLAG_NEGATIVE) == ((test.result & 0x80) != 0));
+    }
+
+    // Zero-page and absolute operands take the same path
+    Machine machine;
+    machine.memory.write(0x10, 0x30);
+    machine.memory.write(0x1234, 0x40);
+    // CLC; LDA #$10; ADC $10; ADC $1234; BRK
+    Registers r = machine.run({0x18, 0xA9, 0x10, 0x65, 0x10, 0x6D, 0x34, 0x12, 0x00});
+    CHECK(r.a == 0x80);
+    CHECK(flag(r, FLAG_OVERFLOW));
+    CHECK(!flag(r, FLAG_CARRY));
+}
+
+static void testSubtractWithBorrow()
+{
+    // C set means no borrow, in and out
+    const ArithmeticCase cases[] = {
+        {true, 0x05, 0x03, 0x02, true, false},
+        {false, 0x05, 0x03, 0x01, true, false},  // the borrow in takes one more
+        {true, 0x50, 0xF0, 0x60, false, false},  // 80 - (-16) = 96
+        {true, 0x50, 0xB0, 0xA0, false, true},   // 80 - (-80) overflows
+        {true, 0xD0, 0x70, 0x60, true, true},    // -48 - 112 overflows
+        {true, 0x00, 0x01, 0xFF, false, false},
+        {true, 0x42, 0x42, 0x00, true, false},
+    };
+    for (const ArithmeticCase &test : cases)
+    {
+        Machine machine;
+        // CLC or SEC; LDA #a; SBC #operand; BRK
+        Registers r = machine.run({uint8_t(test.carryIn ? 0x38 : 0x18), 0xA9, test.a, 0xE9, test.operand, 0x00});
+        CHECK(r.a == test.result);
+        CHECK(flag(r, FLAG_CARRY) == test.carry);
+        CHECK(flag(r, FLAG_OVERFLOW) == test.overflow);
+        CHECK(flag(r, FLAG_ZERO) == (test.result == 0));
+        CHECK(flag(r, FLAG_NEGATIVE) == ((test.result & 0x80) != 0));
+    }
+}
+
+static void testCompare()
+{
+    struct CompareCase
+    {
+        uint8_t value;
+        uint8_t operand;
+        bool carry;
+        bool zero;
+        bool negative;
+    };
+    const CompareCase cases[] = {
+        {0x40, 0x40, true, true, false},
+        {0x40, 0x41, false, false, true},
+        {0x40, 0x10, true, false, false},
+        {0x00, 0xFF, false, false, false}, // 0 - 255 = 1, so N is clear
+        {0xFF, 0x00, true, false, true},
+    };
+    // Load and compare opcodes for A, X and Y, immediate mode
+    const uint8_t loadCompare[][2] = {{0xA9, 0xC9}, {0xA2, 0xE0}, {0xA0, 0xC0}};
+    for (const auto &ops : loadCompare)
+    {
+        for (const CompareCase &test : cases)
+        {
+            Machine machine;
+            Registers r = machine.run({ops[0], test.value, ops[1], test.operand, 0x00});
+            CHECK(flag(r, FLAG_CARRY) == test.carry);
+            CHECK(flag(r, FLAG_ZERO) == test.zero);
+            CHECK(flag(r, FLAG_NEGATIVE) == test.negative);
+        }
+    }
+
+    // CMP leaves A and V alone
+    Machine machine;
+    // CLC; LDA #$50; ADC #$50; CMP #$A0; BRK
+    Registers r = machine.run({0x18, 0xA9, 0x50, 0x69, 0x50, 0xC9, 0xA0, 0x00});
+    CHECK(r.a == 0xA0);
+    CHECK(flag(r, FLAG_OVERFLOW));
+    CHECK(flag(r, FLAG_ZERO));
+}
+
+static void testLazyFlags()
+{
+    {
+        // PLP brings back Z from before a load that cleared it
+        Machine machine;
+        // LDA #0; PHP; LDA #$80; PLP; BRK
+        Registers r = machine.run({0xA9, 0x00, 0x08, 0xA9, 0x80, 0x28, 0x00});
+        CHECK(flag(r, FLAG_ZERO));
+        CHECK(!flag(r, FLAG_NEGATIVE));
+        CHECK(r.a == 0x80);
+        CHECK(r.sp == 0xFF);
+        // PHP pushed Z with B and the unused bit
+        CHECK(machine.memory.read(0x01FF) == (FLAG_UNUSED | FLAG_BREAK | FLAG_INTERRUPT | FLAG_ZERO));
+    }
+    {
+        // N and Z together, which no load can produce, survive PLP; PHP
+        Machine machine;
+        // LDA #$C3; PHA; PLP; PHP; PLA; BRK
+        Registers r = machine.run({0xA9, 0xC3, 0x48, 0x28, 0x08, 0x68, 0x00});
+        CHECK(r.a == (0xC3 | FLAG_UNUSED | FLAG_BREAK));
+    }
+    {
+        // ...and both branches see them
+        Machine machine;
+        // LDA #$82; PHA; PLP; BEQ +1; BRK; BMI +1; BRK; BRK
+        Registers r = machine.run({0xA9, 0x82, 0x48, 0x28, 0xF0, 0x01, 0x00, 0x30, 0x01, 0x00, 0x00});
+        CHECK(r.pc == LOAD_ADDRESS + 10);
+        CHECK(flag(r, FLAG_ZERO) && flag(r, FLAG_NEGATIVE));
+    }
+    {
+        // Stores, CLC and SEC leave N and Z as the last load set them
+        Machine machine;
+        // LDA #$80; STA $10; SEC; BPL +1 (not taken); BNE +1; BRK; BRK
+        Registers r = machine.run({0xA9, 0x80, 0x85, 0x10, 0x38, 0x10, 0x01, 0xD0, 0x01, 0x00, 0x00});
+        CHECK(r.pc == LOAD_ADDRESS + 10);
+        CHECK(flag(r, FLAG_NEGATIVE));
+    }
+}
+
+static void testBranches()
+{
+    {
+        // A backward branch: count $10 down from 3
+        Machine machine;
+        // LDA #3; STA $10; loop: DEC $10; BNE loop; BRK
+        Registers r = machine.run({0xA9, 0x03, 0x85, 0x10, 0xC6, 0x10, 0xD0, 0xFC, 0x00});
+        CHECK(machine.memory.read(0x10) == 0);
+        CHECK(r.pc == LOAD_ADDRESS + 8);
+        CHECK(machine.cpu.instructionCount() == 2 + 3 * 2 + 1);
+    }
+    {
+        // BCC and BCS follow C
+        Machine machine;
+        // SEC; BCC +1 (not taken); BCS +1; BRK; BRK
+        Registers r = machine.run({0x38, 0x90, 0x01, 0xB0, 0x01, 0x00, 0x00});
+        CHECK(r.pc == LOAD_ADDRESS + 6);
+    }
+}
+
+static void testSubroutines()
+{
+    {
+        Machine machine;
+        // JSR $0206; LDX #1; BRK; $0206: LDA #$42; RTS
+        Registers r = machine.run({0x20, 0x06, 0x02, 0xA2, 0x01, 0x00, 0xA9, 0x42, 0x60});
+        CHECK(r.a == 0x42);
+        CHECK(r.x == 0x01);
+        CHECK(r.sp == 0xFF);
+        CHECK(r.pc == LOAD_ADDRESS + 5);
+    }
+    {
+        // JSR pushes the address of its own last byte, high byte first
+        Machine machine;
+        // JSR $0204; BRK; $0204: BRK
+        Registers r = machine.run({0x20, 0x04, 0x02, 0x00, 0x00});
+        CHECK(r.pc == LOAD_ADDRESS + 4);
+        CHECK(r.sp == 0xFD);
+        CHECK(machine.memory.read(0x01FF) == 0x02);
+        CHECK(machine.memory.read(0x01FE) == 0x02);
+    }
+    {
+        // Nested calls unwind in order; TSX sees the depth
+        Machine machine;
+        // JSR $0204; BRK; $0204: JSR $0208; RTS; $0208: TSX; RTS
+        Registers r = machine.run({0x20, 0x04, 0x02, 0x00, 0x20, 0x08, 0x02, 0x60, 0xBA, 0x60});
+        CHECK(r.x == 0xFB);
+        CHECK(r.sp == 0xFF);
+        CHECK(r.pc == LOAD_ADDRESS + 3);
+    }
+}
+
+static void testHeap()
+{
+    Machine machine;
+    auto address = [](const Registers &r)
+    { return uint16_t(r.a << 8 | r.y); };
+
+    uint16_t first = address(machine.sys(SYS_ALLOC, 0, 16));
+    uint16_t second = address(machine.sys(SYS_ALLOC, 0, 16));
+    CHECK(first == HEAP_START);
+    CHECK(second == HEAP_START + 16);
+
+    // A freed block is reused first fit, and handed out zeroed
+    machine.memory.write(first, 0xAA);
+    machine.sys(SYS_FREE, uint8_t(first >> 8), uint8_t(first));
+    uint16_t third = address(machine.sys(SYS_ALLOC, 0, 8));
+    CHECK(third == first);
+    CHECK(machine.memory.read(third) == 0);
+
+    // Size 0 still takes a byte, from the rest of the gap
+    CHECK(address(machine.sys(SYS_ALLOC, 0, 0)) == first + 8);
+    CHECK(address(machine.sys(SYS_ALLOC, 0, 16)) == second + 16);
+
+    // Allocation fails with 0 once the heap is full
+    uint32_t blocks = 0;
+    uint16_t block;
+    while ((block = address(machine.sys(SYS_ALLOC, 0, 255))) != 0)
+    {
+        CHECK(block + 255 <= HEAP_END);
+        ++blocks;
+    }
+    CHECK(blocks == (HEAP_END - HEAP_START - 48) / 255);
+
+    // reset() frees everything
+    machine.cpu.reset();
+    CHECK(address(machine.sys(SYS_ALLOC, 0, 16)) == HEAP_START);
+}
+
+static void testPrint()
+{
+    Machine machine;
+    machine.memory.load(0x3000, {'h', 'i', 0});
+    machine.sys(SYS_PRINT_INT, 0, 200);
+    machine.sys(SYS_PRINT_STR, 0x30, 0x00);
+    machine.sys(SYS_PRINT_CHAR, 0, 'x');
+    CHECK(machine.console.str() == "200\nhi\nx\n");
+}
+
+static void testStops()
+{
+    {
+        // An unlisted opcode stops on itself
+        Machine machine;
+        machine.memory.load(LOAD_ADDRESS, {0xEA, 0x02});
+        CHECK(machine.cpu.run() == StopReason::IllegalOpcode);
+        CHECK(machine.cpu.registers().pc == LOAD_ADDRESS + 1);
+    }
+    {
+        // The budget stops an endless loop, and run() resumes it
+        Machine machine;
+        machine.memory.load(LOAD_ADDRESS, {0x4C, 0x00, 0x02}); // JMP $0200
+        CHECK(machine.cpu.run(100) == StopReason::Limit);
+        CHECK(machine.cpu.instructionCount() == 100);
+        CHECK(machine.cpu.run(50) == StopReason::Limit);
+        CHECK(machine.cpu.instructionCount() == 150);
+    }
+}
+
+int main()
+{
+    testAddWithCarry();
+    testSubtractWithBorrow();
+    testCompare();
+    testLazyFlags();
+    testBranches();
+    testSubroutines();
+    testHeap();
+    testPrint();
+    testStops();
+
+    if (failures)
+        std::fprintf(stderr, "%d checks failed\n", failures);
+    return failures ? 1 : 0;
+}
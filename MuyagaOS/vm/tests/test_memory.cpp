@@ -0,0 +1,92 @@
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "memory.hpp"
+
+/*
+  Memory tests: the image loaders and their bounds.
+*/
+
+static int failures = 0;
+
+#define CHECK(condition) check((condition), #condition, __FILE__, __LINE__)
+
+static void check(bool ok, const char *what, const char *file, int line)
+{
+    if (ok)
+        return;
+    std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, what);
+    ++failures;
+}
+
+// True if action throws std::runtime_error
+template <typename Action>
+static bool throwsRuntimeError(Action action)
+{
+    try
+    {
+        action();
+    }
+    catch (const std::runtime_error &)
+    {
+        return true;
+    }
+    return false;
+}
+
+static void testReadWrite()
+{
+    Memory memory;
+    CHECK(memory.read(0x0000) == 0);
+    CHECK(memory.read(0xFFFF) == 0);
+    memory.write(0xFFFF, 0x5A);
+    CHECK(memory.read(0xFFFF) == 0x5A);
+    CHECK(memory.data()[0xFFFF] == 0x5A);
+}
+
+static void testLoad()
+{
+    Memory memory;
+    memory.load(LOAD_ADDRESS, {0xA9, 0x01, 0x00});
+    CHECK(memory.read(LOAD_ADDRESS) == 0xA9);
+    CHECK(memory.read(LOAD_ADDRESS + 2) == 0x00);
+    CHECK(memory.read(LOAD_ADDRESS - 1) == 0);
+
+    // An image may end on the last byte, not past it
+    memory.load(0xFFFE, {0x11, 0x22});
+    CHECK(memory.read(0xFFFF) == 0x22);
+    CHECK(throwsRuntimeError([&] { memory.load(0xFFFF, {0x11, 0x22}); }));
+    CHECK(throwsRuntimeError([&] { memory.load(0, std::vector<uint8_t>(MEMORY_SIZE + 1)); }));
+    CHECK(memory.read(0x0000) == 0);
+}
+
+static void testLoadFile()
+{
+    const std::string path = "test_memory_image.bin";
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write("\x20\x04\x02\x00", 4);
+    }
+
+    Memory memory;
+    memory.loadFile(LOAD_ADDRESS, path);
+    CHECK(memory.read(LOAD_ADDRESS) == 0x20);
+    CHECK(memory.read(LOAD_ADDRESS + 3) == 0x00);
+    CHECK(throwsRuntimeError([&] { memory.loadFile(0xFFFE, path); }));
+    std::remove(path.c_str());
+
+    CHECK(throwsRuntimeError([&] { memory.loadFile(LOAD_ADDRESS, "no/such/file.bin"); }));
+}
+
+int main()
+{
+    testReadWrite();
+    testLoad();
+    testLoadFile();
+
+    if (failures)
+        std::fprintf(stderr, "%d checks failed\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,307 @@
+#include "regex/matcher.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/*
+============================================================
+  regex_bench
+  --------------------------------
+  Measures compile time, automaton size and scan throughput
+  of the engine on generated corpora, next to std::regex and
+  the grep_clone CLI. Corpora come from a fixed-seed Mersenne
+  Twister, so every run (and every machine) scans exactly the
+  same bytes.
+
+  Usage: regex_bench [--size MB] [--repeat N] [--no-std-regex] [--no-cli]
+============================================================
+*/
+
+using Clock = std::chrono::steady_clock;
+
+struct Corpus
+{
+    std::string name;
+    std::string text;
+    bool longLines; // std::regex recurses per character and is skipped here
+};
+
+struct BenchPattern
+{
+    std::string name;
+    std::vector<std::string> patterns; // several: searched as a set, like grep_clone -e ... -e ...
+};
+
+/*------------------------------------------------------------
+  Corpus generators. Only rng() itself is used (no
+  std::*_distribution), since the distributions are
+  implementation-defined while mt19937's output is not.
+------------------------------------------------------------*/
+static std::string randomAscii(std::mt19937 &rng, size_t bytes)
+{
+    std::string text;
+    text.reserve(bytes);
+    while (text.size() < bytes)
+    {
+        size_t lineLength = 20 + rng() % 100;
+        for (size_t i = 0; i < lineLength; ++i)
+        {
+            text.push_back(static_cast<char>(' ' + rng() % 95)); // printable ASCII
+        }
+        text.push_back('\n');
+    }
+    return text;
+}
+
+static std::string logLike(std::mt19937 &rng, size_t bytes)
+{
+    static const char *levels[] = {"INFO", "INFO", "INFO", "DEBUG", "WARN", "ERROR"};
+    static const char *words[] = {"request", "served", "cache", "miss", "hit", "user", "login", "session",
+                                  "timeout", "latency", "ms", "GET", "POST", "200", "404", "500",
+                                  "connection", "refused", "retry", "db"};
+    std::string text;
+    text.reserve(bytes);
+    for (size_t line = 0; text.size() < bytes; ++line)
+    {
+        char stamp[32];
+        std::snprintf(stamp, sizeof(stamp), "2026-10-17 %02zu:%02zu:%02zu ", line / 3600 % 24, line / 60 % 60,
+                      line % 60);
+        text += stamp;
+        text += levels[rng() % 6];
+        size_t count = 4 + rng() % 10;
+        for (size_t i = 0; i < count; ++i)
+        {
+            text += ' ';
+            text += words[rng() % 20];
+        }
+        text += '\n';
+    }
+    return text;
+}
+
+static std::string longLines(std::mt19937 &rng, size_t bytes)
+{
+    // Lowercase text in 1 MB lines, with a sprinkling of the words the
+    // patterns look for
+    static const char *words[] = {"error", "abb", "abcd", "timeout"};
+    std::string text;
+    text.reserve(bytes);
+    while (text.size() < bytes)
+    {
+        for (size_t i = 0; i < (1 << 20); ++i)
+        {
+            if (rng() % 4096 == 0)
+                text += words[rng() % 4];
+            else
+                text.push_back(static_cast<char>('a' + rng() % 26));
+        }
+        text.push_back('\n');
+    }
+    return text;
+}
+
+/*------------------------------------------------------------
+  Helper: bestSeconds()
+  Fastest of repeat runs: the least disturbed by the rest of
+  the machine.
+------------------------------------------------------------*/
+static double bestSeconds(size_t repeat, const std::function<void()> &run)
+{
+    double best = 1e30;
+    for (size_t i = 0; i < repeat; ++i)
+    {
+        auto begin = Clock::now();
+        run();
+        best = std::min(best, std::chrono::duration<double>(Clock::now() - begin).count());
+    }
+    return best;
+}
+
+static double megabytesPerSecond(size_t bytes, double seconds)
+{
+    return seconds > 0 ? bytes / 1e6 / seconds : 0;
+}
+
+/*------------------------------------------------------------
+  Helper: countMatchingLines()
+  The number every engine must agree on, whatever its match
+  semantics: how many lines contain at least one match.
+------------------------------------------------------------*/
+static size_t countMatchingLines(const CompiledRegex &compiled, std::string_view text)
+{
+    size_t lines = 0;
+    size_t lineBegin = 0;
+    size_t lineEnd = 0;
+    for (size_t from = 0; from < text.size() && findNextMatchingLine(compiled, text, from, lineBegin, lineEnd);
+         from = lineEnd + 1)
+    {
+        ++lines;
+    }
+    return lines;
+}
+
+static std::string describeStates(const CompiledRegex &compiled)
+{
+    if (compiled.engine == MatchEngine::PikeVM)
+        return std::to_string(compiled.nfa.states.size()) + " nfa";
+    if (compiled.engine == MatchEngine::BitParallel)
+        return std::to_string(compiled.glushkov.positions) + " pos";
+    if (compiled.lazy)
+        return "lazy";
+    if (compiled.stats.ahoCorasick)
+        return std::to_string(compiled.stats.dfaStates) + " ac";
+    return std::to_string(compiled.stats.dfaStates) + "->" + std::to_string(compiled.stats.minimizedStates);
+}
+
+int main(int argc, char *argv[])
+{
+    size_t megabytes = 16;
+    size_t repeat = 3;
+    bool runStdRegex = true;
+    bool runCli = true;
+    CompileOptions options;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string flag = argv[i];
+        if (flag == "--size" && i + 1 < argc)
+            megabytes = std::stoul(argv[++i]);
+        else if (flag == "--repeat" && i + 1 < argc)
+            repeat = std::max<size_t>(1, std::stoul(argv[++i]));
+        else if (flag == "--no-std-regex")
+            runStdRegex = false;
+        else if (flag == "--no-cli")
+            runCli = false;
+        else if (flag == "--dfa")
+            options.engine = MatchEngine::DFA;
+        else
+        {
+            std::cerr << "Usage: regex_bench [--size MB] [--repeat N] [--no-std-regex] [--no-cli] [--dfa]\n";
+            return 2;
+        }
+    }
+
+    std::mt19937 rng(20261017);
+    const size_t bytes = megabytes << 20;
+    std::vector<Corpus> corpora = {
+        {"random", randomAscii(rng, bytes), false},
+        {"log", logLike(rng, bytes), false},
+        {"long-lines", longLines(rng, bytes), true},
+    };
+
+    const std::vector<BenchPattern> patterns = {
+        {"literal", {"timeout"}},
+        {"alternation", {"(ERROR|WARN|refused|timeout|abcd|xyz)"}},
+        {"literal-set", {"connection", "retry", "latency", "session", "miss"}},
+        {"star", {"a(b|c)*d"}},
+        {"star-heavy", {"(a|b)*abb(a|b)*"}},
+        {"class", {"[a-z]+[0-9]+"}},
+        {"exponential", {"(a|b)*a(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)"}},
+    };
+
+    std::cout << std::left << std::setw(12) << "corpus" << std::setw(13) << "pattern" << std::right
+              << std::setw(12) << "compile ms" << std::setw(12) << "states" << std::setw(10) << "lines"
+              << std::setw(12) << "findAll" << std::setw(12) << "lineScan" << std::setw(12) << "pikeVM"
+              << std::setw(12) << "std::regex" << std::setw(12) << "CLI" << "   (MB/s)\n";
+
+    for (const Corpus &corpus : corpora)
+    {
+        std::string corpusPath = "regex_bench_" + corpus.name + ".txt";
+        if (runCli)
+            std::ofstream(corpusPath, std::ios::binary) << corpus.text;
+
+        for (const BenchPattern &bench : patterns)
+        {
+            CompiledRegex compiled;
+            double compileSeconds = bestSeconds(repeat, [&]
+            {
+                freeRegex(compiled);
+                compiled = compileDFA(bench.patterns, options);
+            });
+
+            size_t lines = countMatchingLines(compiled, corpus.text);
+            double findAll = bestSeconds(repeat, [&] { findAllMatches(compiled, corpus.text); });
+            double lineScan = bestSeconds(repeat, [&] { countMatchingLines(compiled, corpus.text); });
+
+            CompileOptions pikeOptions;
+            pikeOptions.engine = MatchEngine::PikeVM;
+            CompiledRegex pike = compileDFA(bench.patterns, pikeOptions);
+            double pikeScan = bestSeconds(1, [&] { pikeFindAllMatches(pike.nfa, corpus.text); });
+
+            std::string mark;
+            std::string stdRegexRate = "-";
+            if (runStdRegex && !corpus.longLines)
+            {
+                std::string joined;
+                for (const std::string &pattern : bench.patterns)
+                {
+                    joined += (joined.empty() ? "" : "|") + pattern;
+                }
+                std::regex baseline(joined, std::regex::extended | std::regex::nosubs | std::regex::optimize);
+                size_t baselineLines = 0;
+                double seconds = bestSeconds(1, [&]
+                {
+                    baselineLines = 0;
+                    for (size_t begin = 0; begin < corpus.text.size();)
+                    {
+                        size_t end = corpus.text.find('\n', begin);
+                        end = end == std::string::npos ? corpus.text.size() : end;
+                        if (std::regex_search(corpus.text.begin() + begin, corpus.text.begin() + end, baseline))
+                            ++baselineLines;
+                        begin = end + 1;
+                    }
+                });
+                std::ostringstream rate;
+                rate << std::fixed << std::setprecision(1) << megabytesPerSecond(corpus.text.size(), seconds);
+                stdRegexRate = rate.str();
+                if (baselineLines != lines)
+                    mark = "  MISMATCH: std::regex found " + std::to_string(baselineLines) + " lines";
+            }
+
+            std::string cliRate = "-";
+            if (runCli)
+            {
+                std::string command = std::string("\"") + GREP_CLONE_PATH + "\" -c";
+                if (options.engine == MatchEngine::DFA)
+                    command += " --dfa";
+                for (const std::string &pattern : bench.patterns)
+                {
+                    command += " -e \"" + pattern + "\"";
+                }
+                command += " " + corpusPath + " > /dev/null";
+                double seconds = bestSeconds(repeat, [&]
+                {
+                    if (std::system(command.c_str()) == -1)
+                        std::cerr << "cannot run " << command << "\n";
+                });
+                std::ostringstream rate;
+                rate << std::fixed << std::setprecision(1) << megabytesPerSecond(corpus.text.size(), seconds);
+                cliRate = rate.str();
+            }
+
+            std::cout << std::left << std::setw(12) << corpus.name << std::setw(13) << bench.name << std::right
+                      << std::fixed << std::setprecision(3) << std::setw(12) << compileSeconds * 1e3
+                      << std::setw(12) << describeStates(compiled) << std::setw(10) << lines << std::setprecision(1)
+                      << std::setw(12) << megabytesPerSecond(corpus.text.size(), findAll)
+                      << std::setw(12) << megabytesPerSecond(corpus.text.size(), lineScan)
+                      << std::setw(12) << megabytesPerSecond(corpus.text.size(), pikeScan)
+                      << std::setw(12) << stdRegexRate << std::setw(12) << cliRate << mark << "\n";
+
+            freeRegex(compiled);
+            freeRegex(pike);
+        }
+
+        if (runCli)
+            std::remove(corpusPath.c_str());
+    }
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include "dfa.hpp"
+#include <string>
+#include <vector>
+
+// -----------------------------
+// Aho–Corasick Literal Sets
+// -----------------------------
+
+/**
+ * Build a frozen DFA for a set of literal strings directly from their trie,
+ * in time linear in their total length. This replaces Thompson's
+ * construction and subset construction when every pattern is a plain literal.
+ * @param literals - non-empty strings; pattern i is literals[i].
+ * @param unanchored - false: the trie itself (anchored, dead on mismatch);
+ *                     true: the Aho–Corasick automaton, with failure links
+ *                     folded into a full transition table. Same meaning as
+ *                     in convertNFAtoDFA.
+ * @param recordPatterns - fill in FlatDFA::matchOffsets / matchPatterns.
+ */
+FlatDFA buildLiteralDFA(const std::vector<std::string> &literals, bool unanchored, bool recordPatterns);
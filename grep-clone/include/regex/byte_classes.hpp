@@ -0,0 +1,40 @@
+#pragma once
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// -----------------------------
+// Byte Sets and Equivalence Classes
+// -----------------------------
+
+/// The bytes one NFA transition is taken on: a literal, a [class] or '.'
+using ByteSet = std::bitset<256>;
+
+/*
+  Two bytes are equivalent when every transition label of a pattern holds
+  either both or neither of them: no automaton built from the pattern can
+  tell them apart. DFA rows therefore get one column per class rather than
+  one per byte, and a scan maps each input byte to its class first.
+  [0-9]+ needs two columns (digits, everything else) instead of 256, and
+  subset construction computes one transition per class, not per byte.
+*/
+struct ByteClasses
+{
+    std::array<uint8_t, 256> classOf{};        // byte -> its class
+    std::array<uint8_t, 256> representative{}; // class -> its smallest byte (first count entries)
+    uint32_t count = 1;                        // number of classes
+    uint32_t strideBits = 0;                   // rows are 1 << strideBits cells: count rounded up to a power of two
+};
+
+/**
+ * Coarsest partition of the 256 byte values that every label respects.
+ * Bytes outside all labels form one class of their own.
+ */
+ByteClasses computeByteClasses(const std::vector<ByteSet> &labels);
+
+/**
+ * Readable form of a label for debug output: "a", "[0-9_]", ".", ...
+ */
+std::string describeByteSet(const ByteSet &bytes);
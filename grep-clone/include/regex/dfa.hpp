@@ -1,8 +1,11 @@
 #pragma once
-#include "../regex/utils.hpp" // for State, Transition, etc.
+#include "../regex/utils.hpp" // for State
 #include "../include/regex/nfa.hpp"
+#include <cstdint>
 #include <map>
 #include <set>
+#include <utility>
+#include <vector>
 
 // -----------------------------
 // DFA Core Structures
@@ -12,16 +15,114 @@ struct DFAState
 {
     int id;
     bool isAccepting;
-    std::map<char, DFAState *> transitions; // deterministic transitions
-    std::set<State *> nfaStates;            // NFA states this DFA state represents
+    std::vector<DFAState *> transitions;    // deterministic transitions, one per byte class
+    std::set<uint32_t> nfaStates;           // NFA states this DFA state represents
+    std::vector<uint32_t> patterns;         // multi-pattern DFAs: IDs of the patterns accepted here
 };
 
 struct DFA
 {
     DFAState *start;
     std::vector<DFAState *> states; // for memory management
+    ByteClasses classes;            // what transitions are indexed by
+    bool unanchored = false;        // the empty subset is the restart state, not a dead end
 };
 
+// -----------------------------
+// Frozen (table-driven) DFA
+// -----------------------------
+
+// Row 0 of every frozen table is the dead state: all of its transitions
+// point back to itself and it never accepts.
+constexpr uint32_t DFA_DEAD_STATE = 0;
+
+/*
+  Read-only array used by the frozen tables. It either owns its elements or
+  views memory kept alive elsewhere, e.g. a mapped cache file, so a DFA can
+  be scanned straight out of a file without copying it.
+*/
+template <typename T>
+class FrozenArray
+{
+  public:
+    FrozenArray() = default;
+    FrozenArray(std::vector<T> &&elements) : owned_(std::move(elements)), data_(owned_.data()), size_(owned_.size()) {}
+
+    static FrozenArray view(const T *data, size_t size)
+    {
+        FrozenArray array;
+        array.data_ = data;
+        array.size_ = size;
+        return array;
+    }
+
+    FrozenArray(const FrozenArray &other) : owned_(other.owned_), size_(other.size_)
+    {
+        data_ = other.isView() ? other.data_ : owned_.data();
+    }
+    FrozenArray(FrozenArray &&other) noexcept
+        : owned_(std::move(other.owned_)), data_(other.data_), size_(other.size_)
+    {
+        other.data_ = nullptr;
+        other.size_ = 0;
+    }
+    FrozenArray &operator=(FrozenArray other) noexcept
+    {
+        owned_.swap(other.owned_);
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+        return *this;
+    }
+
+    const T &operator[](size_t i) const { return data_[i]; }
+    const T *data() const { return data_; }
+    const T *begin() const { return data_; }
+    const T *end() const { return data_ + size_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    bool isView() const { return data_ != owned_.data(); }
+
+  private:
+    std::vector<T> owned_;
+    const T *data_ = nullptr;
+    size_t size_ = 0;
+};
+
+struct FlatDFA
+{
+    uint32_t start = DFA_DEAD_STATE;
+    uint32_t numStates = 0;            // including the dead state
+    ByteClasses classes;               // columns of the table
+    FrozenArray<uint32_t> table;       // numStates rows of 1 << classes.strideBits next-state indices
+    FrozenArray<uint64_t> acceptBits;  // bit i set <=> state i is accepting
+
+    // Multi-pattern DFAs only (empty otherwise): the IDs of the patterns
+    // accepted by state i are matchPatterns[matchOffsets[i] .. matchOffsets[i + 1]).
+    FrozenArray<uint32_t> matchOffsets;
+    FrozenArray<uint32_t> matchPatterns;
+};
+
+inline uint32_t nextState(const FlatDFA &dfa, uint32_t state, unsigned char byte)
+{
+    return dfa.table[(static_cast<size_t>(state) << dfa.classes.strideBits) + dfa.classes.classOf[byte]];
+}
+
+inline bool isAcceptingState(const FlatDFA &dfa, uint32_t state)
+{
+    return (dfa.acceptBits[state >> 6] >> (state & 63)) & 1;
+}
+
+/**
+ * Append the IDs of the patterns accepted by a state to out.
+ */
+inline void appendAcceptedPatterns(const FlatDFA &dfa, uint32_t state, std::vector<uint32_t> &out)
+{
+    if (dfa.matchOffsets.empty())
+        return;
+    out.insert(out.end(), dfa.matchPatterns.begin() + dfa.matchOffsets[state],
+               dfa.matchPatterns.begin() + dfa.matchOffsets[state + 1]);
+}
+
 // -----------------------------
 // DFA Construction API
 // -----------------------------
@@ -29,25 +130,55 @@ struct DFA
 /**
  * Convert an NFA to its equivalent DFA using subset construction.
  * @param nfa - input NFA.
- * @param alphabet - set of valid input symbols (non-operators).
- * @return A fully constructed DFA.
+ * @param classes - byte classes of the NFA's labels (computeByteClasses);
+ *                  one transition is computed per class.
+ * @param unanchored - if true, the NFA start state is re-entered before every
+ *                     byte, as if the pattern were prefixed with (any byte)*.
+ *                     Accepting states then mark positions where a non-empty
+ *                     match ends.
+ * @param maxStates - give up once more than this many states would be needed
+ *                    (0 = no limit).
+ * @return A fully constructed DFA, or an empty one (start == nullptr) if the
+ *         state budget was exceeded.
  */
-DFA convertNFAtoDFA(const NFA &nfa, const std::set<char> &alphabet);
+DFA convertNFAtoDFA(const NFA &nfa, const ByteClasses &classes, bool unanchored = false, size_t maxStates = 0);
 
 /**
  * Compute the epsilon-closure of a set of NFA states.
  */
-std::set<State *> epsilonClosure(const std::set<State *> &states);
+std::set<uint32_t> epsilonClosure(const NFA &nfa, const std::set<uint32_t> &states);
 
 /**
- * Move operation: given a set of NFA states and a symbol, find all reachable states.
+ * Move operation: given a set of NFA states and a byte, find all reachable states.
  */
-std::set<State *> move(const std::set<State *> &states, char symbol);
+std::set<uint32_t> move(const NFA &nfa, const std::set<uint32_t> &states, unsigned char byte);
 
 /**
  * Helper to check if any state in a set is an accepting NFA state.
  */
-bool containsAcceptState(const std::set<State *> &states, State *accept);
+bool containsAcceptState(const std::set<uint32_t> &states, uint32_t accept);
+
+/**
+ * IDs of the patterns of a multi-pattern NFA whose accept states are in a set.
+ */
+std::vector<uint32_t> acceptedPatterns(const std::set<uint32_t> &states, const std::vector<uint32_t> &patternAccepts);
+
+/**
+ * Freeze a pointer-based DFA into a dense, row-major transition table.
+ * States are renumbered by index and rows are indexed by byte class; in an
+ * anchored DFA the empty NFA subset maps to DFA_DEAD_STATE. The source DFA
+ * is left untouched.
+ */
+FlatDFA freezeDFA(const DFA &dfa);
+
+/**
+ * Minimize a frozen DFA with Hopcroft's partition refinement.
+ * Equivalent states are merged, and every state that can never reach an
+ * accept merges into DFA_DEAD_STATE. States accepting different pattern
+ * sets are never merged.
+ * @return A language-equivalent DFA with the fewest possible states.
+ */
+FlatDFA minimizeDFA(const FlatDFA &dfa);
 
 /**
  * Clean up all allocated DFA states.
@@ -0,0 +1,41 @@
+#pragma once
+#include "line_search.hpp"
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// -----------------------------
+// Recursive Directory Search
+// -----------------------------
+
+// A file is treated as binary, and skipped, if a NUL byte occurs this early.
+constexpr size_t BINARY_SNIFF_BYTES = 8192;
+
+/**
+ * Cheap binary-file test in the style of grep: look for a NUL byte in the
+ * first BINARY_SNIFF_BYTES bytes.
+ */
+bool looksBinary(std::string_view contents);
+
+/**
+ * Search root, and every file below it if it is a directory, with one
+ * compiled regex shared by threads workers.
+ *
+ * Directories and files are tasks on a work-stealing pool: each worker
+ * pushes the entries of the directories it lists onto its own deque, takes
+ * work from the back of that deque and steals from the front of the others'
+ * when it runs dry. Symbolic links, binary files and entries that cannot be
+ * read are skipped.
+ *
+ * onFile is called once per file with at least one matching line, with the
+ * file's contents and its matching lines (only the first one if
+ * firstLineOnly is set; the file is not scanned further). Calls never
+ * overlap, so the output of one file is never interleaved with another's; the
+ * order of files depends on scheduling. Returning false from onFile ends the
+ * whole search.
+ */
+void searchDirectory(const CompiledRegex &compiled, const std::string &root, unsigned threads, LineDetail detail,
+                     bool firstLineOnly,
+                     const std::function<bool(const std::string &path, std::string_view contents,
+                                              const std::vector<MatchedLine> &lines)> &onFile);
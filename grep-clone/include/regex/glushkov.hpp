@@ -0,0 +1,71 @@
+#pragma once
+#include "parser.hpp"
+#include <array>
+#include <cstdint>
+#include <queue>
+#include <vector>
+
+// -----------------------------
+// Bit-parallel Glushkov NFA
+// -----------------------------
+
+/*
+  Glushkov's position automaton has one state per operand of the pattern
+  (every literal, class or '.') plus an initial state, no ε-transitions, and
+  every transition into a state is taken on that state's own byte set. With
+  at most 63 positions the set of active states fits in one 64-bit word and
+  a byte advances all of them at once (Navarro & Raffinot):
+
+      active' = Follow(active) & B[byte]
+
+  B[byte] holds the positions whose set contains the byte, and Follow is
+  read 8 states at a time from precomputed tables. When every position is
+  followed only by the next one (a plain sequence of bytes and classes),
+  Follow is a left shift and this is Shift-And. Building the automaton is
+  linear in the pattern: there is no subset construction at all.
+*/
+
+// Bit 0 is the initial state; bits 1 .. positions are the operands
+constexpr uint64_t GLUSHKOV_INITIAL = 1;
+constexpr uint32_t GLUSHKOV_MAX_POSITIONS = 63;
+
+struct GlushkovNFA
+{
+    uint32_t positions = 0;
+    uint32_t chunks = 0;               // 8-state slices of the active set: (positions + 8) / 8
+    bool shiftAnd = false;             // forward Follow(active) == active << 1
+    std::array<uint64_t, 256> bytes{}; // B[byte]
+    std::vector<uint64_t> follow;      // chunks tables of 256 entries: the successors of 8 states at a time
+    std::vector<uint64_t> precede;     // the same for the reversed pattern
+    uint64_t first = 0;                // positions a match can start at
+    uint64_t last = 0;                 // positions a match can end at
+    std::vector<uint64_t> patternLast; // multi-pattern: the positions where pattern i ends
+};
+
+/**
+ * Number of positions (literal, class and '.' operands) of a postfix regex.
+ */
+uint32_t countPositions(const std::queue<RegexToken> &postfix);
+
+/**
+ * Build the automaton matching any of a set of postfix patterns. Their
+ * positions together must not exceed GLUSHKOV_MAX_POSITIONS.
+ */
+GlushkovNFA buildGlushkovNFA(const std::vector<std::queue<RegexToken>> &postfixes);
+
+/**
+ * Follow(active) through one of the two tables (follow or precede). Chunks
+ * fixes the slice count at compile time so the loop unrolls; 0 reads it
+ * from nfa.chunks.
+ */
+template <uint32_t Chunks = 0>
+inline uint64_t glushkovFollow(const GlushkovNFA &nfa, const uint64_t *table, uint64_t active)
+{
+    const uint32_t chunks = Chunks ? Chunks : nfa.chunks;
+    uint64_t next = table[active & 0xff];
+    for (uint32_t k = 1; k < chunks; ++k)
+    {
+        next |= table[k * 256 + ((active >> (8 * k)) & 0xff)];
+    }
+    return next;
+}
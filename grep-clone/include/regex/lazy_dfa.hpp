@@ -0,0 +1,85 @@
+#pragma once
+#include "nfa.hpp"
+#include "dfa.hpp"
+#include <cstdint>
+#include <map>
+#include <set>
+#include <vector>
+
+// -----------------------------
+// Lazy DFA Structures
+// -----------------------------
+
+// Table cell for a transition that has not been computed yet.
+constexpr uint32_t LAZY_DFA_UNKNOWN = UINT32_MAX;
+
+// Default cache budget, in DFA states (each state costs one table row of
+// 4 bytes per byte class, rounded up to a power of two).
+constexpr uint32_t LAZY_DFA_DEFAULT_CAPACITY = 1024;
+
+/*
+  A DFA built on demand from an NFA. Transitions are computed by subset
+  construction the first time the input needs them and cached in a table
+  whose size is fixed up front. When the table is full the whole cache is
+  flushed and rebuilt from the states the scan is currently using, so memory
+  stays bounded no matter how many subsets the pattern could produce.
+
+  Row 0 is the dead state and the start state is always row 1, including
+  right after a flush, so scanners can hold on to both indices.
+*/
+struct LazyDFA
+{
+    uint32_t accept = NFA_NO_STATE; // NFA accept state; the NFA itself stays with the caller
+    bool unanchored = false;        // same meaning as in convertNFAtoDFA
+    uint32_t capacity = 0;          // maximum number of cached states
+    uint32_t numStates = 0;
+    uint32_t start = DFA_DEAD_STATE + 1;
+
+    ByteClasses classes;              // columns of the table, from the NFA's labels
+    std::vector<uint32_t> table;      // capacity rows of 1 << classes.strideBits cells
+    std::vector<uint64_t> acceptBits; // bit i set <=> cached state i is accepting
+    std::vector<std::set<uint32_t>> subsets;
+    std::map<std::set<uint32_t>, uint32_t> subsetIndex;
+
+    std::set<uint32_t> startClosure;
+    std::vector<uint32_t> patternAccepts; // copied from a multi-pattern NFA
+    size_t flushCount = 0;                // number of times the cache has been thrown away
+};
+
+// -----------------------------
+// Lazy DFA API
+// -----------------------------
+
+/**
+ * Prepare an empty cache over an NFA. Nothing beyond the start state is
+ * computed until the first scan asks for it.
+ * @param capacity - cache budget in states (at least 4).
+ */
+void initLazyDFA(LazyDFA &lazy, const NFA &nfa, bool unanchored, uint32_t capacity = LAZY_DFA_DEFAULT_CAPACITY);
+
+/**
+ * Slow path of lazyNextState: compute, cache and return one transition,
+ * flushing the cache first if it is full.
+ * @param nfa - the NFA the cache was initialized with.
+ */
+uint32_t computeLazyTransition(LazyDFA &lazy, const NFA &nfa, uint32_t state, unsigned char byte);
+
+inline uint32_t lazyNextState(LazyDFA &lazy, const NFA &nfa, uint32_t state, unsigned char byte)
+{
+    uint32_t next = lazy.table[(static_cast<size_t>(state) << lazy.classes.strideBits) + lazy.classes.classOf[byte]];
+    return next != LAZY_DFA_UNKNOWN ? next : computeLazyTransition(lazy, nfa, state, byte);
+}
+
+inline bool isLazyAcceptingState(const LazyDFA &lazy, uint32_t state)
+{
+    return (lazy.acceptBits[state >> 6] >> (state & 63)) & 1;
+}
+
+/**
+ * Append the IDs of the patterns accepted by a cached state to out.
+ */
+inline void appendLazyAcceptedPatterns(const LazyDFA &lazy, uint32_t state, std::vector<uint32_t> &out)
+{
+    std::vector<uint32_t> ids = acceptedPatterns(lazy.subsets[state], lazy.patternAccepts);
+    out.insert(out.end(), ids.begin(), ids.end());
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include "matcher.hpp"
+#include <functional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// -----------------------------
+// Line-Oriented Buffer Search
+// -----------------------------
+
+struct MatchedLine
+{
+    size_t begin;      // offset of the first byte of the line in the buffer
+    size_t end;        // offset one past its last byte (newline excluded)
+    size_t lineNumber; // 1-based
+    std::vector<std::pair<size_t, size_t>> matches; // spans relative to begin, as in findAllMatches
+};
+
+// Inputs smaller than this are never split across threads.
+constexpr size_t MIN_PARALLEL_CHUNK_BYTES = 1 << 20;
+
+/// How much searchLines works out about each matching line
+enum class LineDetail
+{
+    Spans,  // the line's bounds and every match span in it
+    Bounds, // the line's bounds only; match spans are left empty
+};
+
+/**
+ * Report every line of buffer that contains a match, in file order.
+ *
+ * With threads > 1 the buffer is split into newline-aligned chunks that are
+ * scanned concurrently against the same compiled regex. onLine is always
+ * invoked from the calling thread, in file order, with correct line numbers.
+ * Returning false from onLine stops the search: no further lines are
+ * reported and the workers stop taking chunks.
+ */
+void searchLines(const CompiledRegex &compiled, std::string_view buffer, unsigned threads, LineDetail detail,
+                 const std::function<bool(const MatchedLine &line)> &onLine);
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// -----------------------------
+// Read-only File Mapping
+// -----------------------------
+
+/*
+  A whole input file exposed as one contiguous byte range. Regular files are
+  mapped with mmap so the scanner reads the page cache directly; anything
+  that cannot be mapped (pipes, /dev/stdin, files reporting size 0 such as
+  those in /proc, or a failed mmap) is read into an owned buffer instead.
+*/
+struct MappedFile
+{
+    const char *data = nullptr;
+    size_t size = 0;
+    bool mapped = false;  // true if data points into an mmap region
+    std::string fallback; // owns the bytes when the file could not be mapped
+};
+
+inline std::string_view fileContents(const MappedFile &file)
+{
+    return std::string_view(file.data, file.size);
+}
+
+/**
+ * Map (or read) a file for scanning.
+ * @return false if the file cannot be opened.
+ */
+bool openMappedFile(const std::string &path, MappedFile &file);
+
+/**
+ * Unmap the file or release its fallback buffer.
+ */
+void closeMappedFile(MappedFile &file);
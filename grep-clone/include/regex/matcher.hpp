@@ -1,14 +1,119 @@
 #pragma once
 #include <string>
+#include <string_view>
+#include <memory>
 #include <set>
 #include "parser.hpp"
 #include "nfa.hpp"
 #include "dfa.hpp"
+#include "lazy_dfa.hpp"
+#include "prefilter.hpp"
+#include "aho_corasick.hpp"
+#include "pike_vm.hpp"
+#include "glushkov.hpp"
 #include "utils.hpp"
 
+// Eager subset construction gives up past this many states per automaton
+// and the regex falls back to lazily built DFAs.
+constexpr size_t EAGER_DFA_MAX_STATES = 1024;
+
+/// How a compiled regex searches
+enum class MatchEngine
+{
+    Auto,        // BitParallel if the pattern fits in it, DFA otherwise
+    DFA,         // frozen (or lazy) DFAs: costly to build, fastest per byte
+    BitParallel, // Glushkov NFA advanced with word operations: nothing to determinize
+    PikeVM,      // simulate the NFA directly: nothing to build beyond the NFA
+};
+
+/// Knobs for compileDFA
+struct CompileOptions
+{
+    bool minimize = true;                // run Hopcroft minimization on each frozen DFA
+    MatchEngine engine = MatchEngine::Auto;
+};
+
+/// DFA sizes observed by compileDFA, summed over the three automata
+struct CompileStats
+{
+    size_t dfaStates = 0;       // after subset construction
+    size_t minimizedStates = 0; // after minimization (== dfaStates when disabled)
+    bool ahoCorasick = false;   // built from a literal set, without subset construction
+};
+
+/// The three automata used by the leftmost-longest search
+struct MappedFile;
+
+struct CompiledRegex
+{
+    FlatDFA forward;    // anchored: longest match from a known start position
+    FlatDFA unanchored; // forward with an implicit (any byte)* prefix: finds where matches end
+    FlatDFA reverse;    // reversed pattern with the same prefix: finds where matches start
+
+    // The engine actually used (never Auto). With MatchEngine::PikeVM only nfa
+    // is built and searches simulate it; with BitParallel only glushkov is.
+    MatchEngine engine = MatchEngine::DFA;
+    GlushkovNFA glushkov;
+
+    // Lazy fallback for patterns whose DFAs are too large to build up front.
+    // The caches fill in as lines are scanned, hence mutable.
+    bool lazy = false;
+    NFA nfa;
+    NFA reversedNFA;
+    mutable LazyDFA lazyForward;
+    mutable LazyDFA lazyUnanchored;
+    mutable LazyDFA lazyReverse;
+
+    // Literal every match contains; scans skip straight to its occurrences
+    RequiredLiteral literal;
+
+    // Number of patterns unioned into the automata (see matchingPatterns)
+    size_t patternCount = 1;
+
+    CompileStats stats;
+
+    // Set when the tables view a mapped cache file (see regex_cache.hpp);
+    // shared so that copies keep the mapping alive too
+    std::shared_ptr<MappedFile> cacheFile;
+};
+
 /// High-level API: compiles a regex into an internal automaton and tests input
-void matchRegex(const DFA &compiledDFA, const std::string &line);
+void matchRegex(const CompiledRegex &compiled, std::string_view line);
+
+/**
+ * Report every leftmost-longest, non-overlapping, non-empty match in input as
+ * inclusive [start, end] byte spans.
+ */
+std::vector<std::pair<size_t, size_t>> findAllMatches(const CompiledRegex &compiled, std::string_view input);
+
+/**
+ * Find the next '\n'-terminated line of buffer, at or after offset from, that
+ * contains a match. The whole buffer is scanned in one pass; line boundaries
+ * are only looked up around the first match found.
+ * @param lineBegin, lineEnd - set to the [begin, end) bytes of that line,
+ *                             excluding its newline.
+ * @return false if no line from offset from onwards matches.
+ */
+bool findNextMatchingLine(const CompiledRegex &compiled, std::string_view buffer, size_t from,
+                          size_t &lineBegin, size_t &lineEnd);
+
+/**
+ * IDs of the patterns that match somewhere in input, in ascending order.
+ * Pattern i is the i-th pattern given to compileDFA.
+ */
+std::vector<uint32_t> matchingPatterns(const CompiledRegex &compiled, std::string_view input);
+
+CompiledRegex compileDFA(const std::string &pattern, const CompileOptions &options = {});
 
-std::vector<std::pair<size_t, size_t>> findAllMatches(const DFA &dfa, const std::string &input);
+/**
+ * Compile a set of patterns into one automaton matching any of them.
+ * Accepting states remember which patterns they accept. When every pattern
+ * is a plain literal the automata are built directly as Aho–Corasick
+ * tries, skipping Thompson's construction and subset construction.
+ */
+CompiledRegex compileDFA(const std::vector<std::string> &patterns, const CompileOptions &options = {});
 
-DFA compileDFA(const std::string &pattern);
+/**
+ * Release the NFAs kept alive by a lazily compiled or Pike VM regex.
+ */
+void freeRegex(CompiledRegex &compiled);
@@ -1,18 +1,43 @@
 #pragma once
 #include "utils.hpp"
+#include "parser.hpp"
+#include "byte_classes.hpp"
 
+/*
+  All states of an NFA live in one arena and refer to each other by index,
+  so building one never allocates per state, fragments are combined without
+  copying, and separate NFAs can be built on separate threads.
+*/
 struct NFA
 {
-    State *start;
-    State *accept;
-    std::vector<State *> pool;
+    uint32_t start = NFA_NO_STATE;
+    uint32_t accept = NFA_NO_STATE;
+    std::vector<State> states;             // the arena
+    std::vector<ByteSet> byteSets;         // distinct transition labels, referred to by State::label
+    std::vector<uint32_t> patternAccepts; // multi-pattern NFAs: accept state of pattern i at index i
+};
+
+/// A piece of an NFA under construction: its entry and exit states in the arena
+struct NFAFragment
+{
+    uint32_t start;
+    uint32_t accept;
 };
 
 // Function declarations
-NFA createNFAfromSymbol(char symbol);
-NFA &concatenate(NFA &a, NFA &b);
-NFA unionize(NFA &a, NFA &b);
-NFA compileKleenStar(NFA &b);
-NFA buildNFA(std::queue<char> &postfix);
+NFAFragment createNFAfromBytes(NFA &nfa, const ByteSet &bytes);
+NFAFragment concatenate(NFA &nfa, NFAFragment a, NFAFragment b);
+NFAFragment unionize(NFA &nfa, NFAFragment a, NFAFragment b);
+NFAFragment compileKleenStar(NFA &nfa, NFAFragment b);
+NFAFragment compilePlus(NFA &nfa, NFAFragment b);
+NFAFragment compileOptional(NFA &nfa, NFAFragment b);
+
+/**
+ * Build the fragment for a postfix regex inside an existing arena. Several
+ * patterns built into one arena can then be joined with unionize.
+ */
+NFAFragment buildFragment(NFA &nfa, std::queue<RegexToken> &postfix);
+NFA buildNFA(std::queue<RegexToken> &postfix);
+NFA reverseNFA(const NFA &nfa);
 void freeNFA(NFA &nfa);
 void printNFA(const NFA &nfa);
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// -----------------------------
+// Buffered Output
+// -----------------------------
+
+/*
+  Results are appended to one large buffer that is handed to write(2) only
+  when it fills up, instead of several small stream insertions per line.
+  Match highlighting is only emitted when the output is a terminal, so
+  redirected output carries no escape codes.
+*/
+constexpr size_t OUTPUT_BUFFER_BYTES = 1 << 18;
+
+struct OutputBuffer
+{
+    int fd = 1;
+    bool highlight = false; // wrap matches in ANSI escape codes
+    std::vector<char> data; // OUTPUT_BUFFER_BYTES of storage
+    size_t used = 0;
+};
+
+/**
+ * Prepare a buffer for fd; highlighting is enabled if fd is a terminal.
+ */
+void initOutputBuffer(OutputBuffer &out, int fd);
+
+void writeOutput(OutputBuffer &out, std::string_view text);
+
+void writeNumber(OutputBuffer &out, size_t value);
+
+/**
+ * Write a line followed by a newline, with its matches (inclusive spans, as
+ * returned by findAllMatches) highlighted when highlighting is enabled.
+ */
+void writeHighlightedLine(OutputBuffer &out, std::string_view line,
+                          const std::vector<std::pair<size_t, size_t>> &matches);
+
+/**
+ * Hand everything buffered so far to the file descriptor.
+ */
+void flushOutput(OutputBuffer &out);
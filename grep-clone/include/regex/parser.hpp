@@ -1,8 +1,29 @@
 #pragma once
+#include "byte_classes.hpp"
 #include <string>
 #include <vector>
 #include <queue>
 
+/// What a token of a parsed regex is
+enum class TokenType
+{
+    Bytes,      // one byte out of `bytes`: a literal, a [class], '.' or an escape
+    Concat,     // implicit; inserted by addConcatenation
+    Union,      // |
+    Star,       // *
+    Plus,       // +
+    Optional,   // ?
+    LeftParen,  // (
+    RightParen, // )
+};
+
+struct RegexToken
+{
+    TokenType type;
+    ByteSet bytes;   // TokenType::Bytes only
+    size_t position; // offset in the pattern, for error messages
+};
+
 // Operator info
 struct OpInfo
 {
@@ -11,10 +32,23 @@ struct OpInfo
 };
 
 // Public parser API
-void checkMatchingParens(const std::string &regex);
 
-std::vector<char> addConcatenation(const std::string &regex);
+/**
+ * Split a pattern into tokens. Besides literal bytes and the operators
+ * ( ) | * + ? this understands:
+ *   .          any byte except a newline
+ *   [a-z_] [^0-9]  character classes, with ranges and negation
+ *   \d \w \s   digits, word bytes, whitespace (\D \W \S: their complements)
+ *   \t         a tab
+ *   \c         any other punctuation character c, literally (\. \* \[ ...)
+ * Lines never contain a newline, so no token matches one.
+ */
+std::vector<RegexToken> tokenize(const std::string &regex);
+
+void checkMatchingParens(const std::vector<RegexToken> &tokens);
+
+std::vector<RegexToken> addConcatenation(const std::string &regex);
 
-OpInfo getOpInfo(char op);
+OpInfo getOpInfo(TokenType op);
 
-std::queue<char> getPostfix(const std::vector<char> &concatRegex);
+std::queue<RegexToken> getPostfix(const std::vector<RegexToken> &concatRegex);
@@ -0,0 +1,44 @@
+#pragma once
+#include "nfa.hpp"
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// -----------------------------
+// Pike VM (NFA Simulation)
+// -----------------------------
+
+/*
+  Matches by running every NFA thread in lockstep over the input, as in
+  Thompson's original paper and Pike's sam editor, instead of building a DFA.
+  The live threads are kept in a sparse set indexed by NFA state, so each
+  byte costs at most one step per NFA state and there is nothing to compile
+  beyond the NFA itself. This suits one-shot searches where subset
+  construction would cost more than the scan.
+*/
+
+/**
+ * Find the leftmost-longest non-empty match starting at or after from.
+ * Threads carry the offset they started at; when two reach the same state the
+ * earlier start wins, and once a match is known no later start is tried.
+ * @param start, end - set to the inclusive span of the match.
+ */
+bool pikeFindMatch(const NFA &nfa, std::string_view input, size_t from, size_t &start, size_t &end);
+
+/**
+ * Every leftmost-longest, non-overlapping, non-empty match in input as
+ * inclusive spans, with the same results as findAllMatches.
+ */
+std::vector<std::pair<size_t, size_t>> pikeFindAllMatches(const NFA &nfa, std::string_view input);
+
+/**
+ * Offset of the first byte in [from, to) at which some non-empty match
+ * ends, or to if there is none. One pass, no start offsets tracked.
+ */
+size_t pikeFirstMatchEnd(const NFA &nfa, std::string_view input, size_t from, size_t to);
+
+/**
+ * IDs of the patterns of a multi-pattern NFA that match somewhere in
+ * input, in ascending order.
+ */
+std::vector<uint32_t> pikeMatchingPatterns(const NFA &nfa, std::string_view input);
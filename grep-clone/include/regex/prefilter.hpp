@@ -0,0 +1,34 @@
+#pragma once
+#include "parser.hpp"
+#include <queue>
+#include <string>
+#include <string_view>
+
+// -----------------------------
+// Literal Prefilter
+// -----------------------------
+
+/*
+  Most patterns contain a literal that every match must include, such as
+  ERROR in ERROR(x|y)*. Searching for that literal with a vectorized scan is
+  far cheaper than pushing every byte through the automaton, so the scanner
+  only runs the DFA on lines where the literal occurs.
+*/
+struct RequiredLiteral
+{
+    std::string text;   // empty if the pattern has no required literal
+    bool exact = false; // the pattern matches exactly this string and nothing else
+};
+
+/**
+ * Compute the longest literal that occurs in every match of a postfix regex.
+ * The queue is taken by value because analysing it consumes it.
+ */
+RequiredLiteral extractRequiredLiteral(std::queue<RegexToken> postfix);
+
+/**
+ * Find the first occurrence of needle in haystack at or after from.
+ * Uses AVX2 or SSE2 when the target supports them, memchr/memcmp otherwise.
+ * @return its offset, or std::string_view::npos.
+ */
+size_t findLiteral(std::string_view haystack, std::string_view needle, size_t from = 0);
@@ -0,0 +1,56 @@
+#pragma once
+#include "matcher.hpp"
+#include <string>
+#include <vector>
+
+// -----------------------------
+// On-disk Compiled DFA Cache
+// -----------------------------
+
+/*
+  A compiled regex is written as one file that can be mapped and scanned in
+  place: a fixed header, then each table as a 64-byte aligned section. Every
+  reference inside the file is an offset from its first byte, so the file
+  works wherever it is mapped, and loading it is one mmap plus a few bounds
+  checks; no table is copied or rebuilt.
+
+    [CacheHeader][patterns][literal][forward: table, accept bits, match ids]
+                                    [unanchored: ...][reverse: ...]
+
+  Only eagerly built DFAs are cached. Lazy, bit-parallel and Pike VM
+  regexes have no tables to store and are compiled as usual.
+*/
+
+// Bump whenever the layout or the meaning of any field changes
+constexpr uint32_t REGEX_CACHE_VERSION = 2;
+
+/**
+ * Name of the cache file for a pattern set under the given options:
+ * a 64-bit FNV-1a hash of both, in hex, with a .dfa extension.
+ */
+std::string regexCacheKey(const std::vector<std::string> &patterns, const CompileOptions &options);
+
+/**
+ * Write a compiled regex to path, atomically (temporary file + rename).
+ * @return false if the regex cannot be cached or the file cannot be written.
+ */
+bool saveCompiledRegex(const CompiledRegex &compiled, const std::vector<std::string> &patterns,
+                       const CompileOptions &options, const std::string &path);
+
+/**
+ * Map a cache file and point a regex's tables into it. The file is checked
+ * for its magic, version, byte order, section bounds and the exact pattern
+ * set, so a stale or colliding file is rejected rather than misused.
+ * @return false (leaving compiled untouched) if the file is missing or unusable.
+ */
+bool loadCompiledRegex(const std::string &path, const std::vector<std::string> &patterns,
+                       const CompileOptions &options, CompiledRegex &compiled);
+
+/**
+ * compileDFA through a cache directory: load the cached DFAs for this
+ * pattern set if present, otherwise compile and store them for next time.
+ * Cache failures never fail the compile.
+ * @param hit - if not null, set to whether the regex came from the cache.
+ */
+CompiledRegex compileCached(const std::vector<std::string> &patterns, const CompileOptions &options,
+                            const std::string &cacheDir, bool *hit = nullptr);
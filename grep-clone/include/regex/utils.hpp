@@ -1,27 +1,28 @@
 #pragma once
+#include <cstdint>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <queue>
 #include <stack>
-#include <set>
 #include <iostream>
 
-struct State;
-
-struct Transition
-{
-    char symbol;
-    State *target;
-};
+// Index of "no state": an empty transition slot or an unset start/accept
+constexpr uint32_t NFA_NO_STATE = UINT32_MAX;
 
+/*
+  One NFA state, stored by value in its NFA's arena and referred to by index.
+  Thompson's construction never gives a state more than one labeled
+  transition or more than two ε-transitions, so both fit inline and no state
+  owns any heap memory.
+*/
 struct State
 {
-    int id;
-    std::vector<Transition> transitions;
-    std::vector<State *> epsilonTransitions;
+    uint32_t label = NFA_NO_STATE;                      // index into NFA::byteSets: the bytes target is taken on
+    uint32_t target = NFA_NO_STATE;                     // labeled transition
+    uint32_t epsilon[2] = {NFA_NO_STATE, NFA_NO_STATE}; // ε-transitions
 };
 
 // Utility helpers
-std::set<char> extractSymbolsFromRegex(const std::string &regex);
 
-void printHighlightedLine(const std::string &line, const std::vector<std::pair<size_t, size_t>> &matches);
+void printHighlightedLine(std::string_view line, const std::vector<std::pair<size_t, size_t>> &matches);
@@ -0,0 +1,125 @@
+#include "../include/regex/aho_corasick.hpp"
+#include <algorithm>
+#include <queue>
+
+/*------------------------------------------------------------
+  Aho–Corasick (1975), built straight into FlatDFA rows:
+
+    1. insert every literal into a trie (row 1 is the root)
+    2. walk the trie breadth-first; each node's failure link is
+       the longest proper suffix of its path that is also a
+       trie path, and every missing edge is filled with the
+       edge of that suffix
+    3. a node accepts every literal that ends at it or at any
+       node on its failure chain
+
+  Skipping step 2 leaves the anchored trie, where a missing
+  edge leads to the dead state.
+
+  Rows are indexed by byte class: each byte that occurs in a
+  literal is a class of its own, and all other bytes share
+  one more.
+------------------------------------------------------------*/
+FlatDFA buildLiteralDFA(const std::vector<std::string> &literals, bool unanchored, bool recordPatterns)
+{
+    std::vector<ByteSet> labels;
+    ByteSet seen;
+    for (const std::string &literal : literals)
+    {
+        for (char c : literal)
+        {
+            unsigned char byte = static_cast<unsigned char>(c);
+            if (!seen[byte])
+            {
+                seen.set(byte);
+                labels.push_back(ByteSet().set(byte));
+            }
+        }
+    }
+    const ByteClasses classes = computeByteClasses(labels);
+    const size_t stride = size_t{1} << classes.strideBits;
+
+    const uint32_t root = DFA_DEAD_STATE + 1;
+    std::vector<uint32_t> table(2 * stride, DFA_DEAD_STATE);
+    std::vector<std::vector<uint32_t>> outputs(2);
+
+    for (uint32_t id = 0; id < literals.size(); ++id)
+    {
+        uint32_t node = root;
+        for (char c : literals[id])
+        {
+            size_t edge = node * stride + classes.classOf[static_cast<unsigned char>(c)];
+            if (table[edge] == DFA_DEAD_STATE)
+            {
+                table[edge] = static_cast<uint32_t>(outputs.size());
+                outputs.emplace_back();
+                table.resize(table.size() + stride, DFA_DEAD_STATE);
+            }
+            node = table[edge];
+        }
+        outputs[node].push_back(id);
+    }
+
+    const uint32_t numStates = static_cast<uint32_t>(outputs.size());
+
+    if (unanchored)
+    {
+        std::vector<uint32_t> fail(numStates, root);
+        std::queue<uint32_t> bfs;
+        bfs.push(root);
+
+        while (!bfs.empty())
+        {
+            uint32_t node = bfs.front();
+            bfs.pop();
+            uint32_t *row = &table[node * stride];
+            const uint32_t *failRow = &table[fail[node] * stride];
+
+            for (uint32_t c = 0; c < classes.count; ++c)
+            {
+                uint32_t child = row[c];
+                if (child != DFA_DEAD_STATE && child != root)
+                {
+                    // Real trie edge (rows are filled only after their
+                    // node is dequeued, so no filled edge is seen here)
+                    fail[child] = node == root ? root : failRow[c];
+                    outputs[child].insert(outputs[child].end(), outputs[fail[child]].begin(),
+                                          outputs[fail[child]].end());
+                    bfs.push(child);
+                }
+                else
+                {
+                    row[c] = node == root ? root : failRow[c];
+                }
+            }
+        }
+    }
+
+    FlatDFA flat;
+    flat.start = root;
+    flat.numStates = numStates;
+    flat.classes = classes;
+    std::vector<uint64_t> acceptBits((numStates + 63) / 64, 0);
+    std::vector<uint32_t> matchOffsets;
+    std::vector<uint32_t> matchPatterns;
+    if (recordPatterns)
+        matchOffsets.push_back(0);
+
+    for (uint32_t s = 0; s < numStates; ++s)
+    {
+        if (!outputs[s].empty())
+            acceptBits[s >> 6] |= uint64_t{1} << (s & 63);
+
+        if (recordPatterns)
+        {
+            std::sort(outputs[s].begin(), outputs[s].end());
+            matchPatterns.insert(matchPatterns.end(), outputs[s].begin(), outputs[s].end());
+            matchOffsets.push_back(static_cast<uint32_t>(matchPatterns.size()));
+        }
+    }
+    flat.table = std::move(table);
+    flat.acceptBits = std::move(acceptBits);
+    flat.matchOffsets = std::move(matchOffsets);
+    flat.matchPatterns = std::move(matchPatterns);
+    return flat;
+}
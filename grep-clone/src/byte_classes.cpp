@@ -0,0 +1,86 @@
+#include "../include/regex/byte_classes.hpp"
+#include <cstdio>
+
+ByteClasses computeByteClasses(const std::vector<ByteSet> &labels)
+{
+    ByteClasses classes;
+
+    // Refine one label at a time: each class splits into its bytes inside
+    // and outside the label. Classes are numbered in order of their
+    // smallest byte, so the result does not depend on the label order.
+    for (const ByteSet &label : labels)
+    {
+        std::array<int, 512> split;
+        split.fill(-1);
+        uint32_t count = 0;
+        for (uint32_t byte = 0; byte < 256; ++byte)
+        {
+            int &fresh = split[classes.classOf[byte] * 2 + label[byte]];
+            if (fresh < 0)
+                fresh = static_cast<int>(count++);
+            classes.classOf[byte] = static_cast<uint8_t>(fresh);
+        }
+        classes.count = count;
+    }
+
+    for (uint32_t byte = 256; byte-- > 0;)
+    {
+        classes.representative[classes.classOf[byte]] = static_cast<uint8_t>(byte);
+    }
+    while ((1u << classes.strideBits) < classes.count)
+    {
+        classes.strideBits++;
+    }
+    return classes;
+}
+
+/*------------------------------------------------------------
+  Helper: appendByte()
+  Printable ASCII as itself, anything else as \xHH.
+------------------------------------------------------------*/
+static void appendByte(std::string &out, uint32_t byte)
+{
+    if (byte > ' ' && byte < 0x7f)
+    {
+        out += static_cast<char>(byte);
+        return;
+    }
+    char escaped[8];
+    std::snprintf(escaped, sizeof(escaped), "\\x%02x", byte);
+    out += escaped;
+}
+
+std::string describeByteSet(const ByteSet &bytes)
+{
+    std::string out;
+    if (bytes.count() == 1)
+    {
+        for (uint32_t byte = 0; byte < 256; ++byte)
+        {
+            if (bytes[byte])
+                appendByte(out, byte);
+        }
+        return out;
+    }
+    if (bytes.count() == 255 && !bytes['\n'])
+        return ".";
+
+    out = "[";
+    for (uint32_t lo = 0; lo < 256; ++lo)
+    {
+        if (!bytes[lo])
+            continue;
+        uint32_t hi = lo;
+        while (hi + 1 < 256 && bytes[hi + 1])
+            ++hi;
+
+        appendByte(out, lo);
+        if (hi > lo)
+        {
+            out += '-';
+            appendByte(out, hi);
+        }
+        lo = hi;
+    }
+    return out + "]";
+}
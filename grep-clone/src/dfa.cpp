@@ -1,4 +1,5 @@
 #include "../include/regex/dfa.hpp"
+#include <algorithm>
 #include <iostream>
 #include <queue>
 #include <map>
@@ -13,35 +14,39 @@ void freeDFA(DFA &dfa)
     dfa.states.shrink_to_fit();
 }
 
-bool containsAcceptState(const std::set<State *> &states, State *accept)
+bool containsAcceptState(const std::set<uint32_t> &states, uint32_t accept)
 {
+    return states.count(accept) != 0;
+}
 
-    for (State *s : states)
+std::vector<uint32_t> acceptedPatterns(const std::set<uint32_t> &states, const std::vector<uint32_t> &patternAccepts)
+{
+    std::vector<uint32_t> patterns;
+    for (uint32_t id = 0; id < patternAccepts.size(); ++id)
     {
-        if (s == accept)
-        {
-            return true;
-        }
+        if (states.count(patternAccepts[id]))
+            patterns.push_back(id);
     }
-    return false;
+    return patterns;
 }
-std::set<State *> epsilonClosure(const std::set<State *> &states)
+
+std::set<uint32_t> epsilonClosure(const NFA &nfa, const std::set<uint32_t> &states)
 {
-    std::set<State *> epselonStates;
-    std::queue<State *> q;
-    for (State *s : states)
+    std::set<uint32_t> epselonStates;
+    std::queue<uint32_t> q;
+    for (uint32_t s : states)
     {
         q.push(s);
     }
     while (!q.empty())
     {
-        State *currState = q.front();
+        uint32_t currState = q.front();
         epselonStates.insert(currState);
         q.pop();
 
-        for (State *child : currState->epsilonTransitions)
+        for (uint32_t child : nfa.states[currState].epsilon)
         {
-            if (!epselonStates.count(child))
+            if (child != NFA_NO_STATE && !epselonStates.count(child))
             {
                 q.push(child);
             }
@@ -50,49 +55,70 @@ std::set<State *> epsilonClosure(const std::set<State *> &states)
     return epselonStates;
 }
 
-std::set<State *> move(const std::set<State *> &states, char symbol)
+std::set<uint32_t> move(const NFA &nfa, const std::set<uint32_t> &states, unsigned char byte)
 {
-    std::set<State *> nextStates;
+    std::set<uint32_t> nextStates;
 
-    for (State *s : states)
+    for (uint32_t s : states)
     {
-        for (const Transition &trans : s->transitions)
+        const State &state = nfa.states[s];
+        if (state.target != NFA_NO_STATE && nfa.byteSets[state.label][byte])
         {
-            if (trans.symbol == symbol)
-            {
-                nextStates.insert(trans.target);
-            }
+            nextStates.insert(state.target);
         }
     }
     return nextStates;
 }
 
-DFA convertNFAtoDFA(const NFA &nfa, const std::set<char> &alphabet)
+DFA convertNFAtoDFA(const NFA &nfa, const ByteClasses &classes, bool unanchored, size_t maxStates)
 {
-    std::map<std::set<State *>, DFAState *> subsetToDFA;
-    std::queue<std::set<State *>> unmarked;
+    std::map<std::set<uint32_t>, DFAState *> subsetToDFA;
+    std::queue<std::set<uint32_t>> unmarked;
 
     int nextId = 0;
-    std::set<State *> startClosure = epsilonClosure({nfa.start});
-    DFAState *start = new DFAState{nextId++, containsAcceptState(startClosure, nfa.accept), {}, startClosure};
+    std::set<uint32_t> startClosure = epsilonClosure(nfa, {nfa.start});
+
+    // An unanchored DFA starts from the empty subset and re-enters the start
+    // closure before every byte, so a match may begin anywhere. The empty
+    // subset is then a live "restart" state rather than a dead end, and it is
+    // also where every byte no label contains leads.
+    std::set<uint32_t> initial = unanchored ? std::set<uint32_t>{} : startClosure;
+    DFAState *start = new DFAState{nextId++, containsAcceptState(initial, nfa.accept), {}, initial,
+                                   acceptedPatterns(initial, nfa.patternAccepts)};
     DFA dfa;
     dfa.start = start;
     dfa.states.push_back(start);
-    unmarked.push(startClosure);
-    subsetToDFA[startClosure] = start;
+    dfa.classes = classes;
+    dfa.unanchored = unanchored;
+    unmarked.push(initial);
+    subsetToDFA[initial] = start;
 
     while (!unmarked.empty())
     {
-        std::set<State *> currentState = unmarked.front();
+        std::set<uint32_t> currentState = unmarked.front();
         unmarked.pop();
-        for (char token : alphabet)
+
+        std::set<uint32_t> source = currentState;
+        if (unanchored)
+            source.insert(startClosure.begin(), startClosure.end());
+
+        // All bytes of a class lead to the same subset: one move per class
+        DFAState *from = subsetToDFA[currentState];
+        from->transitions.resize(classes.count);
+        for (uint32_t c = 0; c < classes.count; ++c)
         {
-            std::set<State *> nextState = move(currentState, token);
-            std::set<State *> nextStateEps = epsilonClosure(nextState);
+            std::set<uint32_t> nextState = move(nfa, source, classes.representative[c]);
+            std::set<uint32_t> nextStateEps = epsilonClosure(nfa, nextState);
             DFAState *target;
             if (!subsetToDFA.count(nextStateEps))
             {
-                target = new DFAState{nextId++, containsAcceptState(nextStateEps, nfa.accept), {}, nextStateEps};
+                if (maxStates && dfa.states.size() == maxStates)
+                {
+                    freeDFA(dfa);
+                    return DFA{};
+                }
+                target = new DFAState{nextId++, containsAcceptState(nextStateEps, nfa.accept), {}, nextStateEps,
+                                      acceptedPatterns(nextStateEps, nfa.patternAccepts)};
                 subsetToDFA[nextStateEps] = target;
                 dfa.states.push_back(target);
                 unmarked.push(nextStateEps);
@@ -102,8 +128,276 @@ DFA convertNFAtoDFA(const NFA &nfa, const std::set<char> &alphabet)
                 target = subsetToDFA[nextStateEps];
             }
 
-            subsetToDFA[currentState]->transitions[token] = target;
+            from->transitions[c] = target;
         }
     }
     return dfa;
 }
+
+FlatDFA freezeDFA(const DFA &dfa)
+{
+    FlatDFA flat;
+    if (!dfa.start)
+        return flat;
+
+    // Renumber live states densely after the dead sentinel. In an anchored DFA
+    // the state built from the empty NFA subset can never reach an accept, so
+    // it collapses into the sentinel instead of taking a row of its own.
+    std::map<const DFAState *, uint32_t> index;
+    uint32_t nextIndex = DFA_DEAD_STATE + 1;
+    for (const DFAState *s : dfa.states)
+    {
+        index[s] = (s->nfaStates.empty() && !dfa.unanchored) ? DFA_DEAD_STATE : nextIndex++;
+    }
+
+    flat.numStates = nextIndex;
+    flat.start = index[dfa.start];
+    flat.classes = dfa.classes;
+    const uint32_t stride = uint32_t{1} << dfa.classes.strideBits;
+    std::vector<uint32_t> table(static_cast<size_t>(flat.numStates) * stride, DFA_DEAD_STATE);
+    std::vector<uint64_t> acceptBits((flat.numStates + 63) / 64, 0);
+    std::vector<uint32_t> matchOffsets;
+    std::vector<uint32_t> matchPatterns;
+
+    // Pattern IDs, laid out by row (the dead row accepts nothing)
+    bool multiPattern = false;
+    for (const DFAState *s : dfa.states)
+    {
+        multiPattern = multiPattern || !s->patterns.empty();
+    }
+    if (multiPattern)
+    {
+        std::vector<const DFAState *> byRow(flat.numStates, nullptr);
+        for (const DFAState *s : dfa.states)
+        {
+            byRow[index[s]] = index[s] == DFA_DEAD_STATE ? nullptr : s;
+        }
+        matchOffsets.push_back(0);
+        for (const DFAState *s : byRow)
+        {
+            if (s)
+                matchPatterns.insert(matchPatterns.end(), s->patterns.begin(), s->patterns.end());
+            matchOffsets.push_back(static_cast<uint32_t>(matchPatterns.size()));
+        }
+    }
+
+    for (const DFAState *s : dfa.states)
+    {
+        uint32_t row = index[s];
+        if (row == DFA_DEAD_STATE)
+            continue;
+
+        if (s->isAccepting)
+            acceptBits[row >> 6] |= uint64_t{1} << (row & 63);
+
+        uint32_t *cells = &table[static_cast<size_t>(row) * stride];
+        for (uint32_t c = 0; c < s->transitions.size(); ++c)
+        {
+            cells[c] = index[s->transitions[c]];
+        }
+    }
+    flat.table = std::move(table);
+    flat.acceptBits = std::move(acceptBits);
+    flat.matchOffsets = std::move(matchOffsets);
+    flat.matchPatterns = std::move(matchPatterns);
+    return flat;
+}
+
+FlatDFA minimizeDFA(const FlatDFA &dfa)
+{
+    const uint32_t n = dfa.numStates;
+    if (n <= 1)
+        return dfa;
+
+    // Only the first classes.count cells of each row are real transitions;
+    // the rest pad the row to a power of two.
+    const uint32_t k = dfa.classes.count;
+    const uint32_t strideBits = dfa.classes.strideBits;
+
+    // Reverse edges in CSR form: the predecessors of state t on class c are
+    // preds[predStart[t * k + c] .. predStart[t * k + c + 1]).
+    const size_t cells = static_cast<size_t>(n) * k;
+    std::vector<uint32_t> predStart(cells + 1, 0);
+    for (uint32_t s = 0; s < n; ++s)
+    {
+        for (uint32_t c = 0; c < k; ++c)
+        {
+            predStart[static_cast<size_t>(dfa.table[(static_cast<size_t>(s) << strideBits) + c]) * k + c + 1]++;
+        }
+    }
+    for (size_t i = 0; i < cells; ++i)
+    {
+        predStart[i + 1] += predStart[i];
+    }
+    std::vector<uint32_t> preds(cells);
+    std::vector<uint32_t> fill(predStart.begin(), predStart.end() - 1);
+    for (uint32_t s = 0; s < n; ++s)
+    {
+        for (uint32_t c = 0; c < k; ++c)
+        {
+            preds[fill[static_cast<size_t>(dfa.table[(static_cast<size_t>(s) << strideBits) + c]) * k + c]++] = s;
+        }
+    }
+
+    // Initial partition: non-accepting states, then one block per distinct
+    // set of accepted patterns (just "accepting" for a single pattern).
+    std::vector<std::vector<uint32_t>> blocks;
+    std::vector<uint32_t> blockOf(n);
+    std::map<std::vector<uint32_t>, uint32_t> blockOfPatterns;
+    for (uint32_t s = 0; s < n; ++s)
+    {
+        std::vector<uint32_t> key;
+        if (isAcceptingState(dfa, s))
+        {
+            key.push_back(UINT32_MAX);
+            appendAcceptedPatterns(dfa, s, key);
+        }
+
+        auto it = blockOfPatterns.find(key);
+        if (it == blockOfPatterns.end())
+        {
+            it = blockOfPatterns.emplace(key, static_cast<uint32_t>(blocks.size())).first;
+            blocks.emplace_back();
+        }
+        blockOf[s] = it->second;
+        blocks[it->second].push_back(s);
+    }
+
+    std::vector<bool> inWorklist(blocks.size(), true);
+    std::queue<uint32_t> worklist;
+    for (uint32_t b = 0; b < blocks.size(); ++b)
+    {
+        worklist.push(b);
+    }
+
+    std::vector<uint32_t> hits(n, 0);   // per block: members found in the preimage
+    std::vector<bool> marked(n, false); // per state: member of the preimage
+    std::vector<uint32_t> preimage;
+    std::vector<uint32_t> touched;
+
+    while (!worklist.empty())
+    {
+        uint32_t splitter = worklist.front();
+        worklist.pop();
+        inWorklist[splitter] = false;
+        std::vector<uint32_t> splitterStates = blocks[splitter];
+
+        for (uint32_t c = 0; c < k; ++c)
+        {
+            // Every state that moves into the splitter on class c
+            preimage.clear();
+            for (uint32_t t : splitterStates)
+            {
+                size_t cell = static_cast<size_t>(t) * k + c;
+                for (uint32_t p = predStart[cell]; p < predStart[cell + 1]; ++p)
+                {
+                    uint32_t s = preds[p];
+                    if (!marked[s])
+                    {
+                        marked[s] = true;
+                        preimage.push_back(s);
+                        if (hits[blockOf[s]]++ == 0)
+                            touched.push_back(blockOf[s]);
+                    }
+                }
+            }
+
+            // Split each block the preimage cuts through
+            for (uint32_t b : touched)
+            {
+                if (hits[b] < blocks[b].size())
+                {
+                    std::vector<uint32_t> inside;
+                    std::vector<uint32_t> outside;
+                    for (uint32_t s : blocks[b])
+                    {
+                        (marked[s] ? inside : outside).push_back(s);
+                    }
+
+                    uint32_t fresh = static_cast<uint32_t>(blocks.size());
+                    blocks[b] = std::move(outside);
+                    blocks.push_back(std::move(inside));
+                    for (uint32_t s : blocks[fresh])
+                    {
+                        blockOf[s] = fresh;
+                    }
+
+                    // Hopcroft's rule: if b is still pending, both halves are;
+                    // otherwise refining with the smaller half is enough.
+                    if (inWorklist[b] || blocks[fresh].size() <= blocks[b].size())
+                    {
+                        inWorklist.push_back(true);
+                        worklist.push(fresh);
+                    }
+                    else
+                    {
+                        inWorklist.push_back(false);
+                        inWorklist[b] = true;
+                        worklist.push(b);
+                    }
+                }
+                hits[b] = 0;
+            }
+            touched.clear();
+
+            for (uint32_t s : preimage)
+            {
+                marked[s] = false;
+            }
+        }
+    }
+
+    // Renumber blocks: the dead state's block stays row 0, the rest follow
+    // in order of their lowest original state.
+    std::vector<uint32_t> newIndex(blocks.size(), UINT32_MAX);
+    newIndex[blockOf[DFA_DEAD_STATE]] = DFA_DEAD_STATE;
+    uint32_t nextIndex = DFA_DEAD_STATE + 1;
+    for (uint32_t s = 0; s < n; ++s)
+    {
+        if (newIndex[blockOf[s]] == UINT32_MAX)
+            newIndex[blockOf[s]] = nextIndex++;
+    }
+
+    FlatDFA minimized;
+    minimized.numStates = nextIndex;
+    minimized.start = newIndex[blockOf[dfa.start]];
+    minimized.classes = dfa.classes;
+    std::vector<uint32_t> table(static_cast<size_t>(nextIndex) << strideBits, DFA_DEAD_STATE);
+    std::vector<uint64_t> acceptBits((nextIndex + 63) / 64, 0);
+    std::vector<uint32_t> matchOffsets;
+    std::vector<uint32_t> matchPatterns;
+
+    if (!dfa.matchOffsets.empty())
+    {
+        std::vector<uint32_t> representative(nextIndex);
+        for (uint32_t s = 0; s < n; ++s)
+        {
+            representative[newIndex[blockOf[s]]] = s;
+        }
+        matchOffsets.push_back(0);
+        for (uint32_t row = 0; row < nextIndex; ++row)
+        {
+            appendAcceptedPatterns(dfa, representative[row], matchPatterns);
+            matchOffsets.push_back(static_cast<uint32_t>(matchPatterns.size()));
+        }
+    }
+
+    for (uint32_t s = 0; s < n; ++s)
+    {
+        uint32_t row = newIndex[blockOf[s]];
+        if (isAcceptingState(dfa, s))
+            acceptBits[row >> 6] |= uint64_t{1} << (row & 63);
+
+        const uint32_t *from = &dfa.table[static_cast<size_t>(s) << strideBits];
+        uint32_t *to = &table[static_cast<size_t>(row) << strideBits];
+        for (uint32_t c = 0; c < k; ++c)
+        {
+            to[c] = newIndex[blockOf[from[c]]];
+        }
+    }
+    minimized.table = std::move(table);
+    minimized.acceptBits = std::move(acceptBits);
+    minimized.matchOffsets = std::move(matchOffsets);
+    minimized.matchPatterns = std::move(matchPatterns);
+    return minimized;
+}
@@ -0,0 +1,200 @@
+#include "../include/regex/directory_search.hpp"
+#include "../include/regex/mapped_file.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+bool looksBinary(std::string_view contents)
+{
+    return memchr(contents.data(), '\0', std::min(contents.size(), BINARY_SNIFF_BYTES)) != nullptr;
+}
+
+struct SearchTask
+{
+    fs::path path;
+    bool directory;
+};
+
+// One worker's deque. The owner pushes and pops at the back; thieves take
+// from the front, i.e. the oldest and, for directories, the largest work.
+struct WorkQueue
+{
+    std::mutex lock;
+    std::deque<SearchTask> tasks;
+};
+
+/*------------------------------------------------------------
+  Helper: takeTask()
+  Pops the newest task from the worker's own queue, or else
+  steals the oldest task of another worker, trying the others
+  round-robin starting after self.
+------------------------------------------------------------*/
+static bool takeTask(std::vector<std::unique_ptr<WorkQueue>> &queues, size_t self, SearchTask &task)
+{
+    {
+        WorkQueue &own = *queues[self];
+        std::lock_guard<std::mutex> guard(own.lock);
+        if (!own.tasks.empty())
+        {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    for (size_t k = 1; k < queues.size(); ++k)
+    {
+        WorkQueue &victim = *queues[(self + k) % queues.size()];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.tasks.empty())
+        {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void searchDirectory(const CompiledRegex &compiled, const std::string &root, unsigned threads, LineDetail detail,
+                     bool firstLineOnly,
+                     const std::function<bool(const std::string &path, std::string_view contents,
+                                              const std::vector<MatchedLine> &lines)> &onFile)
+{
+    threads = std::max(1u, threads);
+
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    for (unsigned t = 0; t < threads; ++t)
+    {
+        queues.push_back(std::make_unique<WorkQueue>());
+    }
+
+    std::error_code error;
+    queues[0]->tasks.push_back({fs::path(root), fs::is_directory(root, error)});
+
+    // Tasks queued or running; the search is over when it drops to zero
+    std::atomic<size_t> pending{1};
+    std::atomic<bool> stopped{false};
+    std::mutex outputLock;
+
+    // Idle workers sleep until tasks are pushed or the search ends. A worker
+    // reads the generation before it looks for work, so a push that lands
+    // after it found nothing still wakes it.
+    std::mutex idleLock;
+    std::condition_variable idle;
+    uint64_t generation = 0; // guarded by idleLock; bumped on every push
+    auto wakeIdle = [&]
+    {
+        {
+            std::lock_guard<std::mutex> guard(idleLock);
+            ++generation;
+        }
+        idle.notify_all();
+    };
+
+    auto worker = [&](size_t self)
+    {
+        // A lazy regex fills its caches while scanning, so each worker gets
+        // private caches (and its own copy of the NFAs they read).
+        CompiledRegex privateCopy;
+        if (compiled.lazy)
+            privateCopy = compiled;
+        const CompiledRegex &regex = compiled.lazy ? privateCopy : compiled;
+
+        SearchTask task;
+        while (pending.load() > 0 && !stopped)
+        {
+            uint64_t seen;
+            {
+                std::lock_guard<std::mutex> guard(idleLock);
+                seen = generation;
+            }
+            if (!takeTask(queues, self, task))
+            {
+                std::unique_lock<std::mutex> guard(idleLock);
+                idle.wait(guard, [&] { return generation != seen || pending.load() == 0 || stopped; });
+                continue;
+            }
+
+            if (task.directory)
+            {
+                std::vector<SearchTask> found;
+                std::error_code listError;
+                for (fs::directory_iterator it(task.path, listError), end; !listError && it != end;
+                     it.increment(listError))
+                {
+                    std::error_code typeError;
+                    if (it->is_symlink(typeError))
+                        continue;
+                    if (it->is_directory(typeError))
+                        found.push_back({it->path(), true});
+                    else if (it->is_regular_file(typeError))
+                        found.push_back({it->path(), false});
+                }
+
+                // Count new tasks before this one retires, so pending never
+                // reaches zero while work remains
+                pending += found.size();
+                {
+                    std::lock_guard<std::mutex> guard(queues[self]->lock);
+                    for (SearchTask &entry : found)
+                    {
+                        queues[self]->tasks.push_back(std::move(entry));
+                    }
+                }
+                if (!found.empty())
+                    wakeIdle();
+            }
+            else
+            {
+                MappedFile file;
+                if (openMappedFile(task.path.string(), file))
+                {
+                    std::string_view contents = fileContents(file);
+                    if (!looksBinary(contents))
+                    {
+                        std::vector<MatchedLine> lines;
+                        searchLines(regex, contents, 1, detail, [&](const MatchedLine &line)
+                        {
+                            lines.push_back(line);
+                            return !firstLineOnly;
+                        });
+                        if (!lines.empty())
+                        {
+                            std::unique_lock<std::mutex> guard(outputLock);
+                            if (!stopped && !onFile(task.path.string(), contents, lines))
+                            {
+                                stopped = true;
+                                guard.unlock();
+                                wakeIdle();
+                            }
+                        }
+                    }
+                    closeMappedFile(file);
+                }
+            }
+            if (--pending == 0)
+                wakeIdle();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t)
+    {
+        pool.emplace_back(worker, t);
+    }
+    worker(0);
+
+    for (std::thread &t : pool)
+    {
+        t.join();
+    }
+}
@@ -0,0 +1,160 @@
+#include "../include/regex/glushkov.hpp"
+#include <stack>
+#include <stdexcept>
+
+/*------------------------------------------------------------
+  What Glushkov's construction tracks per sub-expression:
+  the positions its matches can start and end with, and
+  whether it matches the empty string. Follow sets are filled
+  in as operators join sub-expressions:
+
+    AB   every last of A is followed by every first of B
+    A*   every last of A is followed by every first of A
+    A+   (same as A*)
+------------------------------------------------------------*/
+struct GlushkovFragment
+{
+    uint64_t first;
+    uint64_t last;
+    bool nullable;
+};
+
+/*------------------------------------------------------------
+  Helper: addFollow()
+  follow[p] |= targets for every position p in from.
+------------------------------------------------------------*/
+static void addFollow(std::array<uint64_t, 64> &follow, uint64_t from, uint64_t targets)
+{
+    for (; from; from &= from - 1)
+    {
+        follow[__builtin_ctzll(from)] |= targets;
+    }
+}
+
+/*------------------------------------------------------------
+  Helper: buildChunkTables()
+  Expands per-state successor sets into tables answering
+  Follow() for any 8 consecutive states with one lookup.
+------------------------------------------------------------*/
+static std::vector<uint64_t> buildChunkTables(const std::array<uint64_t, 64> &successors, uint32_t chunks)
+{
+    std::vector<uint64_t> tables(static_cast<size_t>(chunks) * 256, 0);
+    for (uint32_t k = 0; k < chunks; ++k)
+    {
+        uint64_t *table = &tables[k * 256];
+        for (uint32_t value = 1; value < 256; ++value)
+        {
+            // Reuse the entry without the lowest bit
+            uint32_t low = __builtin_ctz(value);
+            table[value] = table[value & (value - 1)] | successors[8 * k + low];
+        }
+    }
+    return tables;
+}
+
+uint32_t countPositions(const std::queue<RegexToken> &postfix)
+{
+    uint32_t positions = 0;
+    for (std::queue<RegexToken> copy = postfix; !copy.empty(); copy.pop())
+    {
+        if (copy.front().type == TokenType::Bytes)
+            positions++;
+    }
+    return positions;
+}
+
+GlushkovNFA buildGlushkovNFA(const std::vector<std::queue<RegexToken>> &postfixes)
+{
+    GlushkovNFA nfa;
+    std::array<uint64_t, 64> follow{};
+    uint32_t next = 1;
+
+    for (std::queue<RegexToken> postfix : postfixes)
+    {
+        std::stack<GlushkovFragment> stack;
+        while (!postfix.empty())
+        {
+            RegexToken token = postfix.front();
+            postfix.pop();
+
+            if (token.type == TokenType::Bytes)
+            {
+                if (next > GLUSHKOV_MAX_POSITIONS)
+                    throw std::invalid_argument("Pattern has more than " + std::to_string(GLUSHKOV_MAX_POSITIONS) +
+                                                " positions for the bit-parallel engine");
+                uint64_t bit = uint64_t{1} << next++;
+                for (uint32_t byte = 0; byte < 256; ++byte)
+                {
+                    if (token.bytes[byte])
+                        nfa.bytes[byte] |= bit;
+                }
+                stack.push({bit, bit, false});
+                continue;
+            }
+
+            if (stack.empty())
+                throw std::runtime_error("Invalid postfix: operator with empty stack");
+            GlushkovFragment right = stack.top();
+            stack.pop();
+
+            if (token.type == TokenType::Star || token.type == TokenType::Plus || token.type == TokenType::Optional)
+            {
+                if (token.type != TokenType::Optional)
+                    addFollow(follow, right.last, right.first);
+                stack.push({right.first, right.last, right.nullable || token.type != TokenType::Plus});
+                continue;
+            }
+
+            if (stack.empty())
+                throw std::runtime_error("Invalid postfix: binary operator requires two operands");
+            GlushkovFragment left = stack.top();
+            stack.pop();
+
+            if (token.type == TokenType::Concat)
+            {
+                addFollow(follow, left.last, right.first);
+                stack.push({left.first | (left.nullable ? right.first : 0), right.last | (right.nullable ? left.last : 0),
+                            left.nullable && right.nullable});
+            }
+            else
+            {
+                stack.push({left.first | right.first, left.last | right.last, left.nullable || right.nullable});
+            }
+        }
+
+        if (stack.size() != 1)
+            throw std::runtime_error("Invalid postfix: leftover operands on stack");
+
+        // Only non-empty matches are reported, so nullability does not matter here
+        nfa.first |= stack.top().first;
+        nfa.last |= stack.top().last;
+        nfa.patternLast.push_back(stack.top().last);
+    }
+
+    nfa.positions = next - 1;
+    nfa.chunks = (nfa.positions + 8) / 8;
+    follow[0] = nfa.first;
+
+    // The reversed automaton: from its initial state to every last
+    // position, and from each position back to its predecessors
+    std::array<uint64_t, 64> precede{};
+    precede[0] = nfa.last;
+    for (uint32_t p = 1; p <= nfa.positions; ++p)
+    {
+        for (uint64_t targets = follow[p]; targets; targets &= targets - 1)
+        {
+            precede[__builtin_ctzll(targets)] |= uint64_t{1} << p;
+        }
+    }
+
+    nfa.shiftAnd = nfa.patternLast.size() == 1;
+    for (uint32_t p = 0; p <= nfa.positions && nfa.shiftAnd; ++p)
+    {
+        uint64_t successor = p < nfa.positions ? uint64_t{1} << (p + 1) : 0;
+        nfa.shiftAnd = follow[p] == successor;
+    }
+
+    nfa.follow = buildChunkTables(follow, nfa.chunks);
+    nfa.precede = buildChunkTables(precede, nfa.chunks);
+    return nfa;
+}
@@ -0,0 +1,121 @@
+#include "../include/regex/lazy_dfa.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+/*------------------------------------------------------------
+  Helper: addLazyState()
+  Registers a subset as a new cached state with an all-unknown
+  row. The caller guarantees there is room for it.
+------------------------------------------------------------*/
+static uint32_t addLazyState(LazyDFA &lazy, const std::set<uint32_t> &subset)
+{
+    uint32_t id = lazy.numStates++;
+    lazy.subsets[id] = subset;
+    lazy.subsetIndex[subset] = id;
+
+    const size_t stride = size_t{1} << lazy.classes.strideBits;
+    uint32_t *row = &lazy.table[id * stride];
+    std::fill(row, row + stride, LAZY_DFA_UNKNOWN);
+
+    uint64_t bit = uint64_t{1} << (id & 63);
+    if (containsAcceptState(subset, lazy.accept))
+        lazy.acceptBits[id >> 6] |= bit;
+    else
+        lazy.acceptBits[id >> 6] &= ~bit;
+    return id;
+}
+
+/*------------------------------------------------------------
+  Helper: resetLazyDFA()
+  Drops every cached state and re-creates the two fixed rows:
+  the dead state (0) and the start state (1).
+------------------------------------------------------------*/
+static void resetLazyDFA(LazyDFA &lazy)
+{
+    lazy.subsetIndex.clear();
+
+    // The dead row is fully known up front: every byte leads back to it.
+    lazy.numStates = DFA_DEAD_STATE + 1;
+    lazy.subsets[DFA_DEAD_STATE].clear();
+    lazy.acceptBits[0] &= ~uint64_t{1};
+    std::fill(lazy.table.begin(), lazy.table.begin() + (size_t{1} << lazy.classes.strideBits), DFA_DEAD_STATE);
+
+    // The empty subset is the restart state of an unanchored search, so
+    // there it is the start state rather than a dead end.
+    lazy.start = addLazyState(lazy, lazy.unanchored ? std::set<uint32_t>{} : lazy.startClosure);
+}
+
+void initLazyDFA(LazyDFA &lazy, const NFA &nfa, bool unanchored, uint32_t capacity)
+{
+    if (capacity < 4)
+        throw std::invalid_argument("Lazy DFA capacity must be at least 4 states");
+
+    lazy.accept = nfa.accept;
+    lazy.patternAccepts = nfa.patternAccepts;
+    lazy.unanchored = unanchored;
+    lazy.capacity = capacity;
+    lazy.flushCount = 0;
+    lazy.startClosure = epsilonClosure(nfa, {nfa.start});
+    lazy.classes = computeByteClasses(nfa.byteSets);
+    lazy.table.assign(static_cast<size_t>(capacity) << lazy.classes.strideBits, LAZY_DFA_UNKNOWN);
+    lazy.acceptBits.assign((capacity + 63) / 64, 0);
+    lazy.subsets.assign(capacity, {});
+    resetLazyDFA(lazy);
+}
+
+/*------------------------------------------------------------
+  Helper: cell()
+  Table index of a state's transition on the class of a byte.
+------------------------------------------------------------*/
+static size_t cell(const LazyDFA &lazy, uint32_t state, unsigned char byte)
+{
+    return (static_cast<size_t>(state) << lazy.classes.strideBits) + lazy.classes.classOf[byte];
+}
+
+uint32_t computeLazyTransition(LazyDFA &lazy, const NFA &nfa, uint32_t state, unsigned char byte)
+{
+    std::set<uint32_t> source = lazy.subsets[state];
+    if (lazy.unanchored)
+        source.insert(lazy.startClosure.begin(), lazy.startClosure.end());
+
+    std::set<uint32_t> target = epsilonClosure(nfa, move(nfa, source, byte));
+
+    // An empty subset is the dead state when anchored and the start state
+    // when unanchored; both have fixed rows and survive every flush.
+    if (target.empty())
+    {
+        uint32_t next = lazy.unanchored ? lazy.start : DFA_DEAD_STATE;
+        lazy.table[cell(lazy, state, byte)] = next;
+        return next;
+    }
+
+    auto it = lazy.subsetIndex.find(target);
+    if (it != lazy.subsetIndex.end())
+    {
+        lazy.table[cell(lazy, state, byte)] = it->second;
+        return it->second;
+    }
+
+    if (lazy.numStates == lazy.capacity)
+    {
+        // Out of budget: start over, keeping only the state being left so
+        // the transition we are about to record still has a row to live in.
+        std::set<uint32_t> current = lazy.subsets[state];
+        resetLazyDFA(lazy);
+        lazy.flushCount++;
+
+        auto kept = lazy.subsetIndex.find(current);
+        state = kept != lazy.subsetIndex.end() ? kept->second : addLazyState(lazy, current);
+
+        auto again = lazy.subsetIndex.find(target);
+        if (again != lazy.subsetIndex.end())
+        {
+            lazy.table[cell(lazy, state, byte)] = again->second;
+            return again->second;
+        }
+    }
+
+    uint32_t next = addLazyState(lazy, target);
+    lazy.table[cell(lazy, state, byte)] = next;
+    return next;
+}
@@ -0,0 +1,166 @@
+#include "../include/regex/line_search.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+/*------------------------------------------------------------
+  Helper: scanChunk()
+  Reports the matching lines of one newline-aligned slice of
+  the buffer to onMatch until it returns false. Line numbers
+  are relative to the slice (its first line is 1); the
+  slice's total newline count, returned once the whole slice
+  has been scanned, lets the caller rebase them once earlier
+  slices are known.
+------------------------------------------------------------*/
+template <typename OnMatch>
+static size_t scanChunk(const CompiledRegex &compiled, std::string_view buffer, size_t chunkBegin, size_t chunkEnd,
+                        LineDetail detail, OnMatch &&onMatch)
+{
+    std::string_view chunk = buffer.substr(chunkBegin, chunkEnd - chunkBegin);
+
+    size_t lineNumber = 1;
+    size_t countedUpTo = 0;
+    size_t lineBegin = 0;
+    size_t lineEnd = 0;
+    size_t offset = 0;
+
+    while (offset < chunk.size() && findNextMatchingLine(compiled, chunk, offset, lineBegin, lineEnd))
+    {
+        lineNumber += std::count(chunk.begin() + countedUpTo, chunk.begin() + lineBegin, '\n');
+        countedUpTo = lineBegin;
+
+        MatchedLine line{chunkBegin + lineBegin, chunkBegin + lineEnd, lineNumber, {}};
+        if (detail == LineDetail::Spans)
+            line.matches = findAllMatches(compiled, chunk.substr(lineBegin, lineEnd - lineBegin));
+        if (!onMatch(std::move(line)))
+            return 0;
+        offset = lineEnd + 1;
+    }
+
+    return lineNumber - 1 + std::count(chunk.begin() + countedUpTo, chunk.end(), '\n');
+}
+
+struct ChunkResult
+{
+    size_t begin = 0;
+    size_t end = 0;
+    size_t newlines = 0;
+    std::vector<MatchedLine> lines;
+    bool done = false;
+};
+
+void searchLines(const CompiledRegex &compiled, std::string_view buffer, unsigned threads, LineDetail detail,
+                 const std::function<bool(const MatchedLine &line)> &onLine)
+{
+    // Roughly eight chunks per thread keeps workers busy when match density
+    // is uneven, without shrinking chunks below MIN_PARALLEL_CHUNK_BYTES.
+    size_t target = threads > 1 ? std::max(MIN_PARALLEL_CHUNK_BYTES, buffer.size() / (threads * 8)) : buffer.size();
+
+    std::vector<ChunkResult> chunks;
+    for (size_t begin = 0; begin < buffer.size();)
+    {
+        size_t end = std::min(buffer.size(), begin + target);
+        if (end < buffer.size())
+        {
+            // Extend to the end of the line the tentative boundary falls in
+            const void *newline = memchr(buffer.data() + end, '\n', buffer.size() - end);
+            end = newline ? static_cast<const char *>(newline) - buffer.data() + 1 : buffer.size();
+        }
+        chunks.emplace_back();
+        chunks.back().begin = begin;
+        chunks.back().end = end;
+        begin = end;
+    }
+
+    if (chunks.size() <= 1 || threads <= 1)
+    {
+        // Lines are reported as they are found, so a caller that only
+        // needs the first one never pays for the rest of the buffer
+        size_t baseLine = 0;
+        bool stopped = false;
+        for (ChunkResult &chunk : chunks)
+        {
+            chunk.newlines = scanChunk(compiled, buffer, chunk.begin, chunk.end, detail, [&](MatchedLine &&line)
+            {
+                line.lineNumber += baseLine;
+                stopped = !onLine(line);
+                return !stopped;
+            });
+            if (stopped)
+                return;
+            baseLine += chunk.newlines;
+        }
+        return;
+    }
+
+    std::mutex lock;
+    std::condition_variable chunkDone;
+    std::atomic<size_t> nextChunk{0};
+    std::atomic<bool> stopped{false};
+
+    auto worker = [&]()
+    {
+        // A lazy regex fills its caches while scanning, so each worker gets
+        // private caches (and its own copy of the NFAs they read).
+        CompiledRegex privateCopy;
+        if (compiled.lazy)
+            privateCopy = compiled;
+        const CompiledRegex &regex = compiled.lazy ? privateCopy : compiled;
+
+        for (size_t i = nextChunk++; i < chunks.size() && !stopped; i = nextChunk++)
+        {
+            std::vector<MatchedLine> lines;
+            size_t newlines = scanChunk(regex, buffer, chunks[i].begin, chunks[i].end, detail, [&](MatchedLine &&line)
+            {
+                lines.push_back(std::move(line));
+                return true;
+            });
+
+            std::lock_guard<std::mutex> guard(lock);
+            chunks[i].newlines = newlines;
+            chunks[i].lines = std::move(lines);
+            chunks[i].done = true;
+            chunkDone.notify_all();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    unsigned workers = static_cast<unsigned>(std::min<size_t>(threads, chunks.size()));
+    for (unsigned t = 0; t < workers; ++t)
+    {
+        pool.emplace_back(worker);
+    }
+
+    // Report chunks strictly in file order as soon as each one is ready
+    size_t baseLine = 0;
+    for (ChunkResult &chunk : chunks)
+    {
+        std::vector<MatchedLine> lines;
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            chunkDone.wait(guard, [&] { return chunk.done; });
+            lines = std::move(chunk.lines);
+        }
+
+        for (MatchedLine &line : lines)
+        {
+            line.lineNumber += baseLine;
+            if (!onLine(line))
+            {
+                stopped = true;
+                break;
+            }
+        }
+        if (stopped)
+            break;
+        baseLine += chunk.newlines;
+    }
+
+    for (std::thread &t : pool)
+    {
+        t.join();
+    }
+}
@@ -1,36 +1,273 @@
 #include "../include/regex/matcher.hpp"
+#include "../include/regex/mapped_file.hpp"
+#include "../include/regex/line_search.hpp"
+#include "../include/regex/directory_search.hpp"
+#include "../include/regex/output_buffer.hpp"
+#include "../include/regex/regex_cache.hpp"
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <thread>
+#include <unistd.h>
+
+/// What is printed for the files that match
+enum class ReportMode
+{
+    Lines,            // each matching line (default)
+    OnlyMatching,     // -o: each match on its own line
+    Count,            // -c: number of matching lines
+    FilesWithMatches, // -l: file names only
+    Quiet,            // -q: nothing; the exit status tells
+};
+
+/*------------------------------------------------------------
+  Helper: writeMatchedLine()
+  Writes "<prefix><N>: <line>", or with -o one
+  "<prefix><N>: <match>" per match in the line.
+------------------------------------------------------------*/
+static void writeMatchedLine(OutputBuffer &out, ReportMode mode, std::string_view prefix, std::string_view buffer,
+                             const MatchedLine &line)
+{
+    std::string_view text = buffer.substr(line.begin, line.end - line.begin);
+    if (mode == ReportMode::Lines)
+    {
+        writeOutput(out, prefix);
+        writeNumber(out, line.lineNumber);
+        writeOutput(out, ": ");
+        writeHighlightedLine(out, text, line.matches);
+        return;
+    }
+
+    for (const auto &[start, end] : line.matches)
+    {
+        writeOutput(out, prefix);
+        writeNumber(out, line.lineNumber);
+        writeOutput(out, ": ");
+        writeHighlightedLine(out, text.substr(start, end - start + 1), {{0, end - start}});
+    }
+}
+
+/*------------------------------------------------------------
+  Helper: parseThreads()
+  A decimal thread count of up to four digits, capped at
+  MAX_THREADS; false for anything else. 0 stays 0 (one per
+  hardware core).
+------------------------------------------------------------*/
+constexpr unsigned MAX_THREADS = 256;
+
+static bool parseThreads(const std::string &text, unsigned &threads)
+{
+    if (text.empty() || text.size() > 4 || text.find_first_not_of("0123456789") != std::string::npos)
+        return false;
+    threads = std::min(static_cast<unsigned>(std::stoul(text)), MAX_THREADS);
+    return true;
+}
 
 int main(int argc, char *argv[])
 {
-    if (argc != 3)
+    const char *usage = "Usage: grep_clone [-r] [-o | -c | -l | -q] [-j threads] [--stats] [--no-minimize] [--dfa | --pike-vm] [--cache dir] <pattern> <path>\n"
+                        "       grep_clone [options] (-e pattern | -f pattern_file)... <path>\n";
+    CompileOptions options;
+    bool printStats = false;
+    unsigned threads = 1;
+    bool threadsGiven = false;
+    bool recursive = false;
+    ReportMode mode = ReportMode::Lines;
+    std::vector<std::string> patterns;
+    std::string cacheDir;
+
+    int argi = 1;
+    for (; argi < argc && argv[argi][0] == '-' && argv[argi][1] != '\0'; ++argi)
     {
-        std::cerr << "Usage: grep_clone <pattern> <file_path>\n";
-        return 1;
+        std::string flag = argv[argi];
+        if (flag == "--stats")
+            printStats = true;
+        else if (flag == "-r")
+            recursive = true;
+        else if (flag == "-o")
+            mode = ReportMode::OnlyMatching;
+        else if (flag == "-c")
+            mode = ReportMode::Count;
+        else if (flag == "-l")
+            mode = ReportMode::FilesWithMatches;
+        else if (flag == "-q")
+            mode = ReportMode::Quiet;
+        else if (flag == "--no-minimize")
+            options.minimize = false;
+        else if (flag == "--dfa")
+            options.engine = MatchEngine::DFA;
+        else if (flag == "--pike-vm")
+            options.engine = MatchEngine::PikeVM;
+        else if (flag == "-j" && argi + 1 < argc)
+        {
+            // -j 0 means one thread per hardware core
+            if (!parseThreads(argv[++argi], threads))
+            {
+                std::cerr << "Error: bad thread count " << argv[argi] << "\n" << usage;
+                return 2;
+            }
+            if (threads == 0)
+                threads = std::max(1u, std::thread::hardware_concurrency());
+            threadsGiven = true;
+        }
+        else if (flag == "--cache" && argi + 1 < argc)
+            cacheDir = argv[++argi];
+        else if (flag == "-e" && argi + 1 < argc)
+            patterns.push_back(argv[++argi]);
+        else if (flag == "-f" && argi + 1 < argc)
+        {
+            // One pattern per line; blank lines are skipped
+            std::ifstream patternFile(argv[++argi]);
+            if (!patternFile)
+            {
+                std::cerr << "Error: cannot open pattern file " << argv[argi] << "\n";
+                return 2;
+            }
+            for (std::string line; std::getline(patternFile, line);)
+            {
+                if (!line.empty() && line.back() == '\r')
+                    line.pop_back();
+                if (!line.empty())
+                    patterns.push_back(line);
+            }
+        }
+        else
+        {
+            std::cerr << "Error: unknown option " << flag << "\n" << usage;
+            return 2;
+        }
     }
 
-    std::string pattern = argv[1];
-    std::string filePath = argv[2];
+    // Without -e / -f the first positional argument is the pattern
+    if (patterns.empty() && argc - argi == 2)
+        patterns.push_back(argv[argi++]);
+
+    if (argc - argi != 1 || patterns.empty())
+    {
+        std::cerr << usage;
+        return 2;
+    }
 
-    DFA compiled = compileDFA(pattern);
+    std::string path = argv[argi];
 
-    std::ifstream file(filePath);
-    if (!file)
+    bool cacheHit = false;
+    CompiledRegex compiled = cacheDir.empty() ? compileDFA(patterns, options)
+                                              : compileCached(patterns, options, cacheDir, &cacheHit);
+
+    // An invalid pattern compiles to an empty regex; compileDFA has already said why
+    if (compiled.engine == MatchEngine::DFA && !compiled.lazy && compiled.unanchored.numStates == 0)
+        return 2;
+    if (printStats)
     {
-        std::cerr << "Error: cannot open file " << filePath << "\n";
-        return 1;
+        if (cacheHit)
+            std::cerr << "[Stats] DFAs loaded from cache " << cacheDir << "\n";
+        if (compiled.patternCount > 1)
+            std::cerr << "[Stats] " << compiled.patternCount << " patterns\n";
+        if (compiled.engine == MatchEngine::BitParallel)
+            std::cerr << "[Stats] bit-parallel Glushkov NFA over " << compiled.glushkov.positions << " positions"
+                      << (compiled.glushkov.shiftAnd ? " (Shift-And)" : "") << "\n";
+        else if (compiled.engine == MatchEngine::PikeVM)
+            std::cerr << "[Stats] Pike VM over " << compiled.nfa.states.size() << " NFA states\n";
+        else if (compiled.lazy)
+            std::cerr << "[Stats] lazy DFA (eager construction exceeded " << EAGER_DFA_MAX_STATES << " states)\n";
+        else if (compiled.stats.ahoCorasick)
+            std::cerr << "[Stats] Aho-Corasick states: " << compiled.stats.dfaStates << "\n";
+        else if (options.minimize)
+            std::cerr << "[Stats] DFA states: " << compiled.stats.dfaStates
+                      << " -> " << compiled.stats.minimizedStates << " after minimization\n";
+        else
+            std::cerr << "[Stats] DFA states: " << compiled.stats.dfaStates << " (not minimized)\n";
+
+        if (!compiled.literal.text.empty())
+            std::cerr << "[Stats] required literal: \"" << compiled.literal.text << "\""
+                      << (compiled.literal.exact ? " (whole pattern)" : "") << "\n";
     }
 
-    std::string line;
-    int lineNumber = 1;
+    OutputBuffer out;
+    initOutputBuffer(out, STDOUT_FILENO);
+
+    // -c, -l and -q never need match spans, and -l / -q stop at the first
+    // matching line of a file
+    LineDetail detail = mode == ReportMode::Lines || mode == ReportMode::OnlyMatching ? LineDetail::Spans
+                                                                                     : LineDetail::Bounds;
+    bool firstLineOnly = mode == ReportMode::FilesWithMatches || mode == ReportMode::Quiet;
+    bool anyMatch = false;
 
-    while (std::getline(file, line))
+    if (recursive)
     {
-        std::cout << lineNumber << ": ";
-        matchRegex(compiled, line);
-        lineNumber++;
+        // One worker per core unless -j says otherwise. Each file's lines
+        // are printed together, prefixed with its path.
+        if (!threadsGiven)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+
+        searchDirectory(compiled, path, threads, detail, firstLineOnly,
+                        [&](const std::string &filePath, std::string_view contents, const std::vector<MatchedLine> &lines)
+        {
+            anyMatch = true;
+            if (mode == ReportMode::Quiet)
+                return false;
+
+            if (mode == ReportMode::FilesWithMatches)
+            {
+                writeOutput(out, filePath);
+                writeOutput(out, "\n");
+            }
+            else if (mode == ReportMode::Count)
+            {
+                writeOutput(out, filePath);
+                writeOutput(out, ":");
+                writeNumber(out, lines.size());
+                writeOutput(out, "\n");
+            }
+            else
+            {
+                std::string prefix = filePath + ":";
+                for (const MatchedLine &line : lines)
+                {
+                    writeMatchedLine(out, mode, prefix, contents, line);
+                }
+            }
+            return true;
+        });
     }
+    else
+    {
+        MappedFile file;
+        if (!openMappedFile(path, file))
+        {
+            std::cerr << "Error: cannot open file " << path << "\n";
+            return 2;
+        }
+
+        // Only matching lines are printed, in file order, whatever the
+        // number of threads scanning the buffer.
+        std::string_view buffer = fileContents(file);
+        size_t count = 0;
+        searchLines(compiled, buffer, threads, detail, [&](const MatchedLine &line)
+        {
+            ++count;
+            if (mode == ReportMode::Lines || mode == ReportMode::OnlyMatching)
+                writeMatchedLine(out, mode, "", buffer, line);
+            return !firstLineOnly;
+        });
+        anyMatch = count > 0;
+
+        if (mode == ReportMode::Count)
+        {
+            writeNumber(out, count);
+            writeOutput(out, "\n");
+        }
+        else if (mode == ReportMode::FilesWithMatches && anyMatch)
+        {
+            writeOutput(out, path);
+            writeOutput(out, "\n");
+        }
+        closeMappedFile(file);
+    }
+
+    flushOutput(out);
+    freeRegex(compiled);
 
-    freeDFA(compiled);
+    // grep's convention: 0 if something matched, 1 if nothing did, 2 on error
+    return anyMatch ? 0 : 1;
 }
@@ -0,0 +1,54 @@
+#include "../include/regex/mapped_file.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool openMappedFile(const std::string &path, MappedFile &file)
+{
+    file = MappedFile{};
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    // A size of 0 may still have content (/proc, /sys): only read() can tell
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0)
+    {
+        size_t size = static_cast<size_t>(info.st_size);
+        void *addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr != MAP_FAILED)
+        {
+            // The scan walks the file front to back exactly once
+            madvise(addr, size, MADV_SEQUENTIAL);
+            close(fd);
+            file.data = static_cast<const char *>(addr);
+            file.size = size;
+            file.mapped = true;
+            return true;
+        }
+    }
+
+    // Not mappable: read everything into memory
+    char chunk[1 << 16];
+    ssize_t got;
+    while ((got = read(fd, chunk, sizeof(chunk))) > 0)
+    {
+        file.fallback.append(chunk, static_cast<size_t>(got));
+    }
+    close(fd);
+    if (got < 0)
+        return false;
+
+    file.data = file.fallback.data();
+    file.size = file.fallback.size();
+    return true;
+}
+
+void closeMappedFile(MappedFile &file)
+{
+    if (file.mapped)
+        munmap(const_cast<char *>(file.data), file.size);
+    file = MappedFile{};
+}
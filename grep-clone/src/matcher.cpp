@@ -1,66 +1,574 @@
 #include "../include/regex/matcher.hpp"
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <unordered_set>
 
-std::vector<std::pair<size_t, size_t>> findAllMatches(const DFA &dfa, const std::string &input)
+/*
+  Search runs in three passes over the line, none of which ever restarts
+  the automaton at a later offset:
+
+    1. unanchored, left to right: the last position where any match ends.
+       Lines without a match are rejected here after one pass.
+    2. reversed + unanchored, right to left from that position: marks every
+       offset where some non-empty match starts.
+    3. anchored, left to right from each marked start: the longest match
+       from there, after which the search resumes past its end. A walk
+       stops where an earlier one already went without matching, so long
+       lines with many short matches stay linear.
+*/
+// Uniform stepping interface over the frozen and the lazy automata, so the
+// search below is written once for both.
+struct FlatScan
+{
+    const FlatDFA &dfa;
+
+    uint32_t start() const { return dfa.start; }
+    uint32_t step(uint32_t state, unsigned char byte) const { return nextState(dfa, state, byte); }
+    bool accepting(uint32_t state) const { return isAcceptingState(dfa, state); }
+    void patterns(uint32_t state, std::vector<uint32_t> &out) const { appendAcceptedPatterns(dfa, state, out); }
+};
+
+struct LazyScan
+{
+    LazyDFA &dfa;
+    const NFA &nfa;
+
+    uint32_t start() const { return dfa.start; }
+    uint32_t step(uint32_t state, unsigned char byte) const { return lazyNextState(dfa, nfa, state, byte); }
+    bool accepting(uint32_t state) const { return isLazyAcceptingState(dfa, state); }
+    void patterns(uint32_t state, std::vector<uint32_t> &out) const { appendLazyAcceptedPatterns(dfa, state, out); }
+};
+
+// States of the bit-parallel engine are sets of Glushkov positions; 0 (no
+// active position) is dead for an anchored scan, like DFA_DEAD_STATE.
+template <uint32_t Chunks>
+struct GlushkovScan
+{
+    const GlushkovNFA &nfa;
+    const uint64_t *table; // follow (forward) or precede (reverse)
+    bool shift;            // Follow() is a shift (Shift-And)
+    uint64_t restart;      // GLUSHKOV_INITIAL when unanchored: re-entered before every byte
+    uint64_t accept;       // last (forward) or first (reverse)
+
+    uint64_t start() const { return GLUSHKOV_INITIAL; }
+    uint64_t step(uint64_t state, unsigned char byte) const
+    {
+        state |= restart;
+        return (shift ? state << 1 : glushkovFollow<Chunks>(nfa, table, state)) & nfa.bytes[byte];
+    }
+    bool accepting(uint64_t state) const { return (state & accept) != 0; }
+    void patterns(uint64_t state, std::vector<uint32_t> &out) const
+    {
+        for (uint32_t id = 0; id < nfa.patternLast.size(); ++id)
+        {
+            if (state & nfa.patternLast[id])
+                out.push_back(id);
+        }
+    }
+};
+
+template <uint32_t Chunks>
+static GlushkovScan<Chunks> glushkovForward(const GlushkovNFA &nfa, bool unanchored)
+{
+    return {nfa, nfa.follow.data(), nfa.shiftAnd, unanchored ? GLUSHKOV_INITIAL : 0, nfa.last};
+}
+
+template <uint32_t Chunks>
+static GlushkovScan<Chunks> glushkovReverse(const GlushkovNFA &nfa)
+{
+    return {nfa, nfa.precede.data(), false, GLUSHKOV_INITIAL, nfa.first};
+}
+
+// Run body with the slice count of short automata as a compile-time
+// constant (see glushkovFollow); longer ones pass 0.
+template <typename Body>
+static auto withGlushkovChunks(const GlushkovNFA &nfa, Body body)
+{
+    switch (nfa.chunks)
+    {
+    case 1:
+        return body(std::integral_constant<uint32_t, 1>{});
+    case 2:
+        return body(std::integral_constant<uint32_t, 2>{});
+    default:
+        return body(std::integral_constant<uint32_t, 0>{});
+    }
+}
+
+struct VisitHash
+{
+    size_t operator()(const std::pair<size_t, uint64_t> &visit) const
+    {
+        return std::hash<uint64_t>{}((visit.second * 0x9E3779B97F4A7C15ull) ^ visit.first);
+    }
+};
+
+template <typename Scan>
+static std::vector<std::pair<size_t, size_t>> searchLine(const Scan &unanchored, const Scan &reverse,
+                                                         const Scan &anchored, std::string_view input)
 {
     std::vector<std::pair<size_t, size_t>> matches;
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(input.data());
+    const size_t n = input.size();
 
-    if (!dfa.start)
-        throw std::invalid_argument("DFA has no start state");
+    // Pass 1: where does the last match end?
+    auto current = unanchored.start();
+    size_t lastEnd = n;
+    for (size_t j = 0; j < n; ++j)
+    {
+        current = unanchored.step(current, bytes[j]);
+        if (unanchored.accepting(current))
+            lastEnd = j;
+    }
+    if (lastEnd == n)
+        return matches;
+
+    // Pass 2: which offsets start a match? Every match ends at or before lastEnd.
+    current = reverse.start();
+    std::vector<bool> startsMatch(lastEnd + 1, false);
+    for (size_t j = lastEnd + 1; j-- > 0;)
+    {
+        current = reverse.step(current, bytes[j]);
+        if (reverse.accepting(current))
+            startsMatch[j] = true;
+    }
 
-    for (size_t i = 0; i < input.size(); ++i)
+    // Pass 3: longest match from each leftmost remaining start. Once the
+    // walks have cost more than a few passes over the line, every (offset,
+    // state) they reach is remembered: an earlier walk that reached it found
+    // no accepting state past there (its match ended before this start), and
+    // the automaton is deterministic, so a later walk arriving there stops.
+    // Each pair is then stepped at most once, keeping the pass linear.
+    std::unordered_set<std::pair<size_t, uint64_t>, VisitHash> visited;
+    size_t budget = 2 * (lastEnd + 1) + 64;
+    size_t i = 0;
+    while (i <= lastEnd)
     {
-        DFAState *current = dfa.start;
+        if (!startsMatch[i])
+        {
+            ++i;
+            continue;
+        }
 
-        for (size_t j = i; j < input.size(); ++j)
+        size_t end = i;
+        current = anchored.start();
+        for (size_t j = i; j <= lastEnd; ++j)
         {
-            auto it = current->transitions.find(input[j]);
-            if (it == current->transitions.end())
+            current = anchored.step(current, bytes[j]);
+            if (current == DFA_DEAD_STATE)
                 break;
+            if (budget > 0)
+                --budget;
+            else if (!visited.insert({j, current}).second)
+                break;
+            if (anchored.accepting(current))
+                end = j;
+        }
 
-            current = it->second;
-            if (current->isAccepting)
+        matches.push_back({i, end});
+        i = end + 1;
+    }
+    return matches;
+}
+
+std::vector<std::pair<size_t, size_t>> findAllMatches(const CompiledRegex &compiled, std::string_view input)
+{
+    const RequiredLiteral &literal = compiled.literal;
+    if (!literal.text.empty())
+    {
+        size_t hit = findLiteral(input, literal.text);
+        if (hit == std::string_view::npos)
+            return {};
+
+        // A pure literal pattern: its matches are just the occurrences
+        if (literal.exact)
+        {
+            std::vector<std::pair<size_t, size_t>> matches;
+            for (; hit != std::string_view::npos; hit = findLiteral(input, literal.text, hit + literal.text.size()))
             {
-                matches.push_back({i, j});
-                break; // start new search after this match
+                matches.push_back({hit, hit + literal.text.size() - 1});
             }
+            return matches;
         }
     }
-    return matches;
+
+    if (compiled.engine == MatchEngine::PikeVM)
+        return pikeFindAllMatches(compiled.nfa, input);
+
+    if (compiled.engine == MatchEngine::BitParallel)
+    {
+        return withGlushkovChunks(compiled.glushkov, [&](auto chunks) {
+            const GlushkovNFA &nfa = compiled.glushkov;
+            return searchLine(glushkovForward<chunks>(nfa, true), glushkovReverse<chunks>(nfa),
+                              glushkovForward<chunks>(nfa, false), input);
+        });
+    }
+
+    if (compiled.lazy)
+    {
+        return searchLine(LazyScan{compiled.lazyUnanchored, compiled.nfa},
+                          LazyScan{compiled.lazyReverse, compiled.reversedNFA},
+                          LazyScan{compiled.lazyForward, compiled.nfa}, input);
+    }
+
+    if (compiled.unanchored.numStates == 0)
+        throw std::invalid_argument("DFA has no start state");
+
+    return searchLine(FlatScan{compiled.unanchored}, FlatScan{compiled.reverse},
+                      FlatScan{compiled.forward}, input);
+}
+
+/*------------------------------------------------------------
+  Helper: firstMatchEnd()
+  Runs the unanchored automaton over bytes [from, to) and
+  returns the position where the first match ends, or to.
+  Patterns never contain '\n', so the automaton falls back to
+  its restart state at every line break and a match found
+  here never spans lines.
+------------------------------------------------------------*/
+template <typename Scan>
+static size_t firstMatchEnd(const Scan &unanchored, const unsigned char *bytes, size_t from, size_t to)
+{
+    auto current = unanchored.start();
+    for (size_t j = from; j < to; ++j)
+    {
+        current = unanchored.step(current, bytes[j]);
+        if (unanchored.accepting(current))
+            return j;
+    }
+    return to;
+}
+
+// firstEnd(from, to) returns where the first match in bytes [from, to) of
+// the buffer ends, or to; see firstMatchEnd().
+template <typename FirstEnd>
+static bool scanForMatchingLine(const FirstEnd &firstEnd, const RequiredLiteral &literal, std::string_view buffer,
+                                size_t from, size_t &lineBegin, size_t &lineEnd)
+{
+    const char *data = buffer.data();
+    const size_t n = buffer.size();
+
+    auto lineAround = [&](size_t pos)
+    {
+        lineBegin = pos;
+        while (lineBegin > from && data[lineBegin - 1] != '\n')
+            --lineBegin;
+
+        const void *next = memchr(data + pos, '\n', n - pos);
+        lineEnd = next ? static_cast<const char *>(next) - data : n;
+    };
+
+    if (literal.text.empty())
+    {
+        size_t end = firstEnd(from, n);
+        if (end == n)
+            return false;
+        lineAround(end);
+        return true;
+    }
+
+    // Jump between occurrences of the required literal and only run the
+    // automaton over the lines they fall in.
+    while (from < n)
+    {
+        size_t hit = findLiteral(buffer, literal.text, from);
+        if (hit == std::string_view::npos)
+            return false;
+
+        lineAround(hit);
+        if (literal.exact || firstEnd(lineBegin, lineEnd) != lineEnd)
+            return true;
+        from = lineEnd + 1;
+    }
+    return false;
+}
+
+bool findNextMatchingLine(const CompiledRegex &compiled, std::string_view buffer, size_t from,
+                          size_t &lineBegin, size_t &lineEnd)
+{
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(buffer.data());
+
+    if (compiled.engine == MatchEngine::PikeVM)
+    {
+        auto firstEnd = [&](size_t begin, size_t end) { return pikeFirstMatchEnd(compiled.nfa, buffer, begin, end); };
+        return scanForMatchingLine(firstEnd, compiled.literal, buffer, from, lineBegin, lineEnd);
+    }
+
+    if (compiled.engine == MatchEngine::BitParallel)
+    {
+        return withGlushkovChunks(compiled.glushkov, [&](auto chunks) {
+            auto unanchored = glushkovForward<chunks>(compiled.glushkov, true);
+            auto firstEnd = [&](size_t begin, size_t end) { return firstMatchEnd(unanchored, bytes, begin, end); };
+            return scanForMatchingLine(firstEnd, compiled.literal, buffer, from, lineBegin, lineEnd);
+        });
+    }
+
+    if (compiled.lazy)
+    {
+        LazyScan unanchored{compiled.lazyUnanchored, compiled.nfa};
+        auto firstEnd = [&](size_t begin, size_t end) { return firstMatchEnd(unanchored, bytes, begin, end); };
+        return scanForMatchingLine(firstEnd, compiled.literal, buffer, from, lineBegin, lineEnd);
+    }
+
+    if (compiled.unanchored.numStates == 0)
+        throw std::invalid_argument("DFA has no start state");
+
+    FlatScan unanchored{compiled.unanchored};
+    auto firstEnd = [&](size_t begin, size_t end) { return firstMatchEnd(unanchored, bytes, begin, end); };
+    return scanForMatchingLine(firstEnd, compiled.literal, buffer, from, lineBegin, lineEnd);
 }
 
-DFA compileDFA(const std::string &pattern)
+/*------------------------------------------------------------
+  Helper: collectPatterns()
+  Runs the unanchored automaton over the whole input and
+  gathers the pattern IDs of every accepting state it visits.
+------------------------------------------------------------*/
+template <typename Scan>
+static std::vector<uint32_t> collectPatterns(const Scan &unanchored, std::string_view input, size_t patternCount)
+{
+    std::vector<uint32_t> ids;
+    std::vector<bool> seen(patternCount, false);
+    size_t found = 0;
+    auto current = unanchored.start();
+    for (unsigned char byte : input)
+    {
+        current = unanchored.step(current, byte);
+        if (!unanchored.accepting(current))
+            continue;
+
+        size_t before = ids.size();
+        unanchored.patterns(current, ids);
+        for (size_t k = before; k < ids.size(); ++k)
+        {
+            if (!seen[ids[k]])
+            {
+                seen[ids[k]] = true;
+                ++found;
+            }
+        }
+        if (found == patternCount)
+            break;
+    }
+
+    ids.clear();
+    for (uint32_t id = 0; id < patternCount; ++id)
+    {
+        if (seen[id])
+            ids.push_back(id);
+    }
+    return ids;
+}
+
+std::vector<uint32_t> matchingPatterns(const CompiledRegex &compiled, std::string_view input)
+{
+    if (!compiled.literal.text.empty() && findLiteral(input, compiled.literal.text) == std::string_view::npos)
+        return {};
+
+    // One pattern: no IDs are recorded, any match is pattern 0
+    if (compiled.patternCount == 1)
+    {
+        if (findAllMatches(compiled, input).empty())
+            return {};
+        return {0};
+    }
+
+    if (compiled.engine == MatchEngine::PikeVM)
+        return pikeMatchingPatterns(compiled.nfa, input);
+
+    if (compiled.engine == MatchEngine::BitParallel)
+    {
+        return withGlushkovChunks(compiled.glushkov, [&](auto chunks) {
+            return collectPatterns(glushkovForward<chunks>(compiled.glushkov, true), input, compiled.patternCount);
+        });
+    }
+
+    if (compiled.lazy)
+        return collectPatterns(LazyScan{compiled.lazyUnanchored, compiled.nfa}, input, compiled.patternCount);
+
+    if (compiled.unanchored.numStates == 0)
+        throw std::invalid_argument("DFA has no start state");
+
+    return collectPatterns(FlatScan{compiled.unanchored}, input, compiled.patternCount);
+}
+
+CompiledRegex compileDFA(const std::string &pattern, const CompileOptions &options)
+{
+    return compileDFA(std::vector<std::string>{pattern}, options);
+}
+
+CompiledRegex compileDFA(const std::vector<std::string> &patterns, const CompileOptions &options)
 {
     try
     {
-        //   Parse regex into concatenated form
-        std::vector<char> concatRegex = addConcatenation(pattern);
+        if (patterns.empty())
+            throw std::invalid_argument("No pattern given");
+
+        std::vector<std::queue<RegexToken>> postfixes;
+        std::vector<std::string> literals;
+        std::queue<RegexToken> combined; // p1 p2 | p3 | ... : the union, for literal analysis
+        bool allLiterals = patterns.size() > 1;
+
+        for (const std::string &pattern : patterns)
+        {
+            //   Input is searched line by line, so a pattern cannot span lines
+            if (pattern.find('\n') != std::string::npos)
+                throw std::invalid_argument("Pattern must not contain a newline");
+
+            //   Tokenize and parse regex into concatenated form
+            std::vector<RegexToken> concatRegex = addConcatenation(pattern);
+
+            //   Convert to postfix (Shunting Yard)
+            std::queue<RegexToken> postfix = getPostfix(concatRegex);
+            for (std::queue<RegexToken> copy = postfix; !copy.empty(); copy.pop())
+            {
+                combined.push(copy.front());
+            }
+            if (!postfixes.empty())
+                combined.push(RegexToken{TokenType::Union, {}, 0});
+
+            //   A pattern with no operators left is a plain literal
+            RequiredLiteral own = extractRequiredLiteral(postfix);
+            allLiterals = allLiterals && own.exact && !own.text.empty();
+            literals.push_back(own.text);
+
+            postfixes.push_back(std::move(postfix));
+        }
+
+        CompiledRegex compiled;
+        compiled.patternCount = patterns.size();
+
+        //   Find the literal every match must contain (prefilter)
+        compiled.literal = extractRequiredLiteral(combined);
+
+        //   A set of plain literals: Aho–Corasick tries, no NFA at all
+        if (allLiterals && (options.engine == MatchEngine::DFA || options.engine == MatchEngine::Auto))
+        {
+            std::vector<std::string> mirrored;
+            for (const std::string &text : literals)
+            {
+                mirrored.emplace_back(text.rbegin(), text.rend());
+            }
+            compiled.forward = buildLiteralDFA(literals, false, false);
+            compiled.unanchored = buildLiteralDFA(literals, true, true);
+            compiled.reverse = buildLiteralDFA(mirrored, true, false);
+            compiled.stats.dfaStates = compiled.forward.numStates + compiled.unanchored.numStates +
+                                       compiled.reverse.numStates;
+            compiled.stats.minimizedStates = compiled.stats.dfaStates;
+            compiled.stats.ahoCorasick = true;
+            return compiled;
+        }
+
+        //   Short patterns: Glushkov positions in a machine word, nothing to determinize
+        uint32_t positions = 0;
+        for (const std::queue<RegexToken> &postfix : postfixes)
+        {
+            positions += countPositions(postfix);
+        }
+        if (options.engine == MatchEngine::BitParallel ||
+            (options.engine == MatchEngine::Auto && positions <= GLUSHKOV_MAX_POSITIONS))
+        {
+            compiled.engine = MatchEngine::BitParallel;
+            compiled.glushkov = buildGlushkovNFA(postfixes);
+            return compiled;
+        }
+
+        //   Build NFA (Thompson construction), one alternative per pattern,
+        //   all in one arena
+        NFA nfa;
+        NFAFragment whole = buildFragment(nfa, postfixes[0]);
+        if (patterns.size() > 1)
+        {
+            nfa.patternAccepts.push_back(whole.accept);
+            for (size_t i = 1; i < postfixes.size(); ++i)
+            {
+                NFAFragment next = buildFragment(nfa, postfixes[i]);
+                nfa.patternAccepts.push_back(next.accept);
+                whole = unionize(nfa, whole, next);
+            }
+        }
+        nfa.start = whole.start;
+        nfa.accept = whole.accept;
+
+        //   Pike VM: the NFA is all it needs
+        if (options.engine == MatchEngine::PikeVM)
+        {
+            compiled.engine = MatchEngine::PikeVM;
+            compiled.nfa = std::move(nfa);
+            return compiled;
+        }
 
-        //   Convert to postfix (Shunting Yard)
-        std::queue<char> postfix = getPostfix(concatRegex);
+        //   Mirror image of the NFA for the reverse scan
+        NFA reversed = reverseNFA(nfa);
 
-        //   Build NFA (Thompson construction)
-        NFA nfa = buildNFA(postfix);
+        //   Group bytes no label tells apart; DFA rows get one column per group
+        ByteClasses classes = computeByteClasses(nfa.byteSets);
 
-        //   Extract alphabet from pattern
-        std::set<char> alphabet = extractSymbolsFromRegex(pattern);
+        //   Convert NFA → DFA (Subset construction) and freeze each one
+        //   into a flat transition table for scanning. The unanchored
+        //   automata are the likeliest to blow up, so they go first, and the
+        //   first one over budget skips the rest: a pattern that ends up lazy
+        //   pays for at most one wasted construction.
+        DFA unanchored = convertNFAtoDFA(nfa, classes, true, EAGER_DFA_MAX_STATES);
+        DFA reverse{};
+        DFA forward{};
+        if (unanchored.start)
+            reverse = convertNFAtoDFA(reversed, classes, true, EAGER_DFA_MAX_STATES);
+        if (reverse.start)
+            forward = convertNFAtoDFA(nfa, classes, false, EAGER_DFA_MAX_STATES);
 
-        //   Convert NFA → DFA (Subset construction)
+        if (forward.start && unanchored.start && reverse.start)
+        {
+            compiled.forward = freezeDFA(forward);
+            compiled.unanchored = freezeDFA(unanchored);
+            compiled.reverse = freezeDFA(reverse);
+            compiled.stats.dfaStates = compiled.forward.numStates + compiled.unanchored.numStates +
+                                       compiled.reverse.numStates;
 
-        DFA dfa = convertNFAtoDFA(nfa, alphabet);
+            //   Merge equivalent states (Hopcroft)
+            if (options.minimize)
+            {
+                compiled.forward = minimizeDFA(compiled.forward);
+                compiled.unanchored = minimizeDFA(compiled.unanchored);
+                compiled.reverse = minimizeDFA(compiled.reverse);
+            }
+            compiled.stats.minimizedStates = compiled.forward.numStates + compiled.unanchored.numStates +
+                                             compiled.reverse.numStates;
+            freeNFA(nfa);
+            freeNFA(reversed);
+        }
+        else
+        {
+            //   Too many states: keep the NFAs and build DFA states on demand
+            compiled.lazy = true;
+            compiled.nfa = std::move(nfa);
+            compiled.reversedNFA = std::move(reversed);
+            initLazyDFA(compiled.lazyForward, compiled.nfa, false);
+            initLazyDFA(compiled.lazyUnanchored, compiled.nfa, true);
+            initLazyDFA(compiled.lazyReverse, compiled.reversedNFA, true);
+        }
 
-        freeNFA(nfa);
-        return dfa;
+        freeDFA(forward);
+        freeDFA(unanchored);
+        freeDFA(reverse);
+        return compiled;
     }
     catch (const std::exception &e)
     {
         std::cerr << "[Regex Error] " << e.what() << "\n";
-        return DFA{};
+        return CompiledRegex{};
     }
 }
 
-void matchRegex(const DFA &compiledDFA, const std::string &line)
+void matchRegex(const CompiledRegex &compiled, std::string_view line)
 {
-    std::vector<std::pair<size_t, size_t>> matches = findAllMatches(compiledDFA, line);
+    std::vector<std::pair<size_t, size_t>> matches = findAllMatches(compiled, line);
     printHighlightedLine(line, matches);
 }
+
+void freeRegex(CompiledRegex &compiled)
+{
+    freeNFA(compiled.nfa);
+    freeNFA(compiled.reversedNFA);
+    compiled.lazy = false;
+}
@@ -6,6 +6,7 @@
 #include <queue>
 #include <stack>
 #include <set>
+#include <algorithm>
 
 /*
 ============================================================
@@ -16,63 +17,91 @@
   “Regular Expression Search Algorithm” (CACM, Vol. 11, No. 6)
 
   Each NFA has:
-    - start: pointer to the start state
-    - accept: pointer to the accept state
-    - pool: vector owning all dynamically allocated states
+    - start: index of the start state
+    - accept: index of the accept state
+    - states: the arena holding every state by value
 
-  Memory is managed manually for educational purposes.
+  Fragments are (start, accept) index pairs inside one arena,
+  so combining them only adds states and edges; nothing is
+  copied or re-owned.
 ============================================================
 */
 
-// Global counter to assign unique state IDs (for debugging/visualization)
-static int GLOBAL_STATE_ID = 0;
-
 /*------------------------------------------------------------
   Helper: createState()
-  Creates a new State object on the heap, assigns a unique ID,
-  and registers ownership in the NFA’s memory pool.
+  Appends an empty state to the arena and returns its index.
 ------------------------------------------------------------*/
-State *createState(NFA &nfa)
+static uint32_t createState(NFA &nfa)
 {
-  State *s = new State{GLOBAL_STATE_ID++, {}, {}};
-  nfa.pool.push_back(s);
-  return s;
+  nfa.states.emplace_back();
+  return static_cast<uint32_t>(nfa.states.size() - 1);
 }
 
 /*------------------------------------------------------------
-  Helper: freeNFA()
-  Deletes all heap-allocated State objects owned by an NFA.
-  This is the only cleanup function you should call once an
-  NFA is no longer needed.
+  Helper: addEpsilon()
+  Adds an ε-transition from → to in the first free slot.
 ------------------------------------------------------------*/
-void freeNFA(NFA &nfa)
+static void addEpsilon(NFA &nfa, uint32_t from, uint32_t to)
+{
+  State &s = nfa.states[from];
+  if (s.epsilon[0] == NFA_NO_STATE)
+    s.epsilon[0] = to;
+  else if (s.epsilon[1] == NFA_NO_STATE)
+    s.epsilon[1] = to;
+  else
+    throw std::logic_error("NFA state already has two epsilon transitions");
+}
+
+/*------------------------------------------------------------
+  Helper: internByteSet()
+  Index of a label in the NFA's byte sets, adding it if new.
+  Patterns use few distinct labels, so a linear search is
+  cheaper than hashing 256-bit sets.
+------------------------------------------------------------*/
+static uint32_t internByteSet(NFA &nfa, const ByteSet &bytes)
 {
-  for (State *s : nfa.pool)
+  for (uint32_t i = 0; i < nfa.byteSets.size(); ++i)
   {
-    delete s;
+    if (nfa.byteSets[i] == bytes)
+      return i;
   }
-  nfa.pool.clear();
-  nfa.pool.shrink_to_fit();
+  nfa.byteSets.push_back(bytes);
+  return static_cast<uint32_t>(nfa.byteSets.size() - 1);
+}
+
+/*------------------------------------------------------------
+  Helper: freeNFA()
+  Releases the arena. Kept so callers can drop a large NFA
+  before the structure holding it goes away.
+------------------------------------------------------------*/
+void freeNFA(NFA &nfa)
+{
+  nfa.states.clear();
+  nfa.states.shrink_to_fit();
+  nfa.patternAccepts.clear();
+  nfa.byteSets.clear();
+  nfa.byteSets.shrink_to_fit();
+  nfa.start = NFA_NO_STATE;
+  nfa.accept = NFA_NO_STATE;
 }
 
 /*------------------------------------------------------------
-  Base Case: createNFAfromSymbol()
-  Creates a simple NFA fragment for a single literal symbol.
+  Base Case: createNFAfromBytes()
+  Creates a simple NFA fragment that consumes one byte out of
+  a set: a literal, a character class or '.'.
 
-        [start] --symbol--> [accept]
+        [start] --bytes--> [accept]
 
 ------------------------------------------------------------*/
-NFA createNFAfromSymbol(char symbol)
+NFAFragment createNFAfromBytes(NFA &nfa, const ByteSet &bytes)
 {
-  NFA nfa{nullptr, nullptr, {}}; // explicit initialization
-  State *start = createState(nfa);
-  State *accept = createState(nfa);
+  uint32_t label = internByteSet(nfa, bytes);
+  uint32_t start = createState(nfa);
+  uint32_t accept = createState(nfa);
 
-  start->transitions.push_back({symbol, accept});
-
-  nfa.start = start;
-  nfa.accept = accept;
-  return nfa;
+  nfa.states[start].label = label;
+  nfa.states[start].target = accept;
+  return {start, accept};
 }
 
 /*------------------------------------------------------------
@@ -81,23 +110,14 @@ NFA createNFAfromSymbol(char symbol)
 
         A.accept --ε--> B.start
 
-  The resulting NFA starts at A.start and accepts at B.accept.
-  Memory ownership of B’s states is transferred to A.
+  The resulting fragment starts at A.start and accepts at
+  B.accept.
 ------------------------------------------------------------*/
-NFA &concatenate(NFA &a, NFA &b)
+NFAFragment concatenate(NFA &nfa, NFAFragment a, NFAFragment b)
 {
   // Link A’s accept to B’s start using ε-transition
-  a.accept->epsilonTransitions.push_back(b.start);
-
-  // Update accept pointer and merge memory pools
-  a.accept = b.accept;
-  a.pool.insert(a.pool.end(), b.pool.begin(), b.pool.end());
-
-  // Clear B’s pool since ownership is transferred
-  b.pool.clear();
-  b.pool.shrink_to_fit();
-
-  return a;
+  addEpsilon(nfa, a.accept, b.start);
+  return {a.start, b.accept};
 }
 
 /*------------------------------------------------------------
@@ -114,32 +134,18 @@ NFA &concatenate(NFA &a, NFA &b)
   Creates a new start and accept state, and connects them to
   both sub-NFAs using ε-transitions.
 ------------------------------------------------------------*/
-NFA unionize(NFA &a, NFA &b)
+NFAFragment unionize(NFA &nfa, NFAFragment a, NFAFragment b)
 {
-  NFA res{nullptr, nullptr, {}}; // explicit initialization
-
-  State *start = createState(res);
-  State *accept = createState(res);
-  res.start = start;
-  res.accept = accept;
+  uint32_t start = createState(nfa);
+  uint32_t accept = createState(nfa);
 
   // Epsilon transitions connecting sub-NFAs
-  start->epsilonTransitions.push_back(a.start);
-  start->epsilonTransitions.push_back(b.start);
-  a.accept->epsilonTransitions.push_back(accept);
-  b.accept->epsilonTransitions.push_back(accept);
-
-  // Transfer ownership of all states into the result
-  res.pool.insert(res.pool.end(), a.pool.begin(), a.pool.end());
-  res.pool.insert(res.pool.end(), b.pool.begin(), b.pool.end());
-
-  // Clear the old pools
-  a.pool.clear();
-  b.pool.clear();
-  a.pool.shrink_to_fit();
-  b.pool.shrink_to_fit();
-
-  return res;
+  addEpsilon(nfa, start, a.start);
+  addEpsilon(nfa, start, b.start);
+  addEpsilon(nfa, a.accept, accept);
+  addEpsilon(nfa, b.accept, accept);
+
+  return {start, accept};
 }
 
 /*------------------------------------------------------------
@@ -159,72 +165,107 @@ NFA unionize(NFA &a, NFA &b)
 
   This allows zero or more repetitions of the sub-NFA B.
 ------------------------------------------------------------*/
-NFA compileKleenStar(NFA &b)
+NFAFragment compileKleenStar(NFA &nfa, NFAFragment b)
 {
-  NFA res{nullptr, nullptr, {}}; // explicit initialization
-
-  State *start = createState(res);
-  State *accept = createState(res);
-  res.start = start;
-  res.accept = accept;
+  uint32_t start = createState(nfa);
+  uint32_t accept = createState(nfa);
 
   // Epsilon transitions per Thompson’s closure construction
-  start->epsilonTransitions.push_back(b.start);    // newStart → oldStart
-  start->epsilonTransitions.push_back(accept);     // newStart → newAccept
-  b.accept->epsilonTransitions.push_back(b.start); // oldAccept → oldStart
-  b.accept->epsilonTransitions.push_back(accept);  // oldAccept → newAccept
+  addEpsilon(nfa, start, b.start);    // newStart → oldStart
+  addEpsilon(nfa, start, accept);     // newStart → newAccept
+  addEpsilon(nfa, b.accept, b.start); // oldAccept → oldStart
+  addEpsilon(nfa, b.accept, accept);  // oldAccept → newAccept
+
+  return {start, accept};
+}
+
+/*------------------------------------------------------------
+  One or More: compilePlus(B)
+  B+ is B followed by B*, without copying B: its accept
+  loops back to its start or leaves.
+
+        B.start --> ... --> B.accept --ε--> [newAccept]
+           ^                   |
+           |_________ε_________|
+
+------------------------------------------------------------*/
+NFAFragment compilePlus(NFA &nfa, NFAFragment b)
+{
+  uint32_t accept = createState(nfa);
+
+  addEpsilon(nfa, b.accept, b.start); // repeat
+  addEpsilon(nfa, b.accept, accept);  // or stop
+
+  return {b.start, accept};
+}
+
+/*------------------------------------------------------------
+  Zero or One: compileOptional(B)
+  B? either runs B once or skips it:
+
+      [newStart] --ε--> B.start ... B.accept --ε--> [newAccept]
+          |                                            ^
+          |____________________ε_______________________|
+
+------------------------------------------------------------*/
+NFAFragment compileOptional(NFA &nfa, NFAFragment b)
+{
+  uint32_t start = createState(nfa);
+  uint32_t accept = createState(nfa);
 
-  // Merge memory ownership
-  res.pool.insert(res.pool.end(), b.pool.begin(), b.pool.end());
-  b.pool.clear();
-  b.pool.shrink_to_fit();
+  addEpsilon(nfa, start, b.start);
+  addEpsilon(nfa, start, accept);
+  addEpsilon(nfa, b.accept, accept);
 
-  return res;
+  return {start, accept};
 }
 
 void printNFA(const NFA &nfa)
 {
-  if (!nfa.start)
+  if (nfa.start == NFA_NO_STATE)
   {
     std::cout << "[Error] NFA has no start state.\n";
     return;
   }
 
-  std::stack<State *> stck;
-  std::set<const State *> visited;
+  std::stack<uint32_t> stck;
+  std::vector<bool> visited(nfa.states.size(), false);
 
   stck.push(nfa.start);
 
   std::cout << "\n=================== NFA Structure ===================\n";
-  std::cout << "Start State: " << nfa.start->id
-            << " | Accept State: " << (nfa.accept ? nfa.accept->id : -1)
+  std::cout << "Start State: " << nfa.start
+            << " | Accept State: " << static_cast<long long>(nfa.accept == NFA_NO_STATE ? -1 : nfa.accept)
             << "\n----------------------------------------------------\n";
 
   while (!stck.empty())
   {
-    State *s = stck.top();
+    uint32_t id = stck.top();
     stck.pop();
 
-    if (visited.count(s))
+    if (visited[id])
       continue;
 
-    visited.insert(s);
+    visited[id] = true;
+    const State &s = nfa.states[id];
 
-    // Print labeled transitions
-    for (const Transition &t : s->transitions)
+    // Print labeled transition
+    if (s.target != NFA_NO_STATE)
     {
-      std::cout << "[State " << s->id << "] --(" << t.symbol
-                << ")--> [State " << t.target->id << "]\n";
-      if (visited.find(t.target) == visited.end())
-        stck.push(t.target);
+      std::cout << "[State " << id << "] --(" << describeByteSet(nfa.byteSets[s.label])
+                << ")--> [State " << s.target << "]\n";
+      if (!visited[s.target])
+        stck.push(s.target);
     }
 
     // Print epsilon transitions
-    for (State *eps : s->epsilonTransitions)
+    for (uint32_t eps : s.epsilon)
     {
-      std::cout << "[State " << s->id << "] --(ε)--> [State "
-                << eps->id << "]\n";
-      if (visited.find(eps) == visited.end())
+      if (eps == NFA_NO_STATE)
+        continue;
+      std::cout << "[State " << id << "] --(ε)--> [State "
+                << eps << "]\n";
+      if (!visited[eps])
         stck.push(eps);
     }
   }
@@ -232,56 +273,160 @@ void printNFA(const NFA &nfa)
   std::cout << "====================================================\n";
 }
 
-NFA buildNFA(std::queue<char> &postfix)
+NFAFragment buildFragment(NFA &nfa, std::queue<RegexToken> &postfix)
 {
-  std::stack<NFA> stack;
+  std::stack<NFAFragment> stack;
 
   while (!postfix.empty())
   {
-    char token = postfix.front();
+    RegexToken token = postfix.front();
     postfix.pop();
 
-    if (token == '*')
+    if (token.type == TokenType::Star || token.type == TokenType::Plus || token.type == TokenType::Optional)
     {
       if (stack.empty())
-        throw std::runtime_error("Invalid postfix: '*' with empty stack");
+        throw std::runtime_error("Invalid postfix: repetition operator with empty stack");
 
-      NFA top = std::move(stack.top());
+      NFAFragment top = stack.top();
       stack.pop();
-      stack.push(compileKleenStar(top));
+      if (token.type == TokenType::Star)
+        stack.push(compileKleenStar(nfa, top));
+      else if (token.type == TokenType::Plus)
+        stack.push(compilePlus(nfa, top));
+      else
+        stack.push(compileOptional(nfa, top));
     }
-    else if (token == '.')
+    else if (token.type == TokenType::Concat)
     {
       if (stack.size() < 2)
-        throw std::runtime_error("Invalid postfix: '.' requires two operands");
+        throw std::runtime_error("Invalid postfix: concatenation requires two operands");
 
-      NFA right = std::move(stack.top());
+      NFAFragment right = stack.top();
       stack.pop();
-      NFA left = std::move(stack.top());
+      NFAFragment left = stack.top();
       stack.pop();
 
-      stack.push(concatenate(left, right));
+      stack.push(concatenate(nfa, left, right));
     }
-    else if (token == '|')
+    else if (token.type == TokenType::Union)
     {
       if (stack.size() < 2)
         throw std::runtime_error("Invalid postfix: '|' requires two operands");
 
-      NFA right = std::move(stack.top());
+      NFAFragment right = stack.top();
       stack.pop();
-      NFA left = std::move(stack.top());
+      NFAFragment left = stack.top();
       stack.pop();
 
-      stack.push(unionize(left, right));
+      stack.push(unionize(nfa, left, right));
     }
     else
     {
-      stack.push(createNFAfromSymbol(token));
+      stack.push(createNFAfromBytes(nfa, token.bytes));
     }
   }
 
   if (stack.size() != 1)
     throw std::runtime_error("Invalid postfix: leftover NFAs on stack");
 
-  return std::move(stack.top());
+  return stack.top();
+}
+
+NFA buildNFA(std::queue<RegexToken> &postfix)
+{
+  NFA nfa;
+  NFAFragment whole = buildFragment(nfa, postfix);
+  nfa.start = whole.start;
+  nfa.accept = whole.accept;
+  return nfa;
+}
+
+/*------------------------------------------------------------
+  Helper: addReversedEdges()
+  Gives state `from` of the reversed NFA a list of outgoing
+  edges (label, target), with label < 0 meaning ε. A state
+  holds at most one labeled and two ε-edges, so longer lists
+  are spread over a chain of fresh ε-states:
+
+        from --ε--> [first edge]
+             --ε--> [rest of the list ...]
+------------------------------------------------------------*/
+static void addReversedEdges(NFA &rev, uint32_t from, const std::vector<std::pair<int, uint32_t>> &edges,
+                             size_t first)
+{
+  size_t remaining = edges.size() - first;
+  if (remaining == 0)
+    return;
+
+  if (remaining == 1 && edges[first].first >= 0)
+  {
+    rev.states[from].label = static_cast<uint32_t>(edges[first].first);
+    rev.states[from].target = edges[first].second;
+    return;
+  }
+
+  if (remaining <= 2 && edges[first].first < 0 && edges.back().first < 0)
+  {
+    for (size_t i = first; i < edges.size(); ++i)
+      addEpsilon(rev, from, edges[i].second);
+    return;
+  }
+
+  uint32_t head = createState(rev);
+  addReversedEdges(rev, head, {edges[first]}, 0);
+  addEpsilon(rev, from, head);
+
+  if (remaining == 2 && edges.back().first < 0)
+  {
+    addEpsilon(rev, from, edges.back().second);
+    return;
+  }
+  uint32_t tail = createState(rev);
+  addEpsilon(rev, from, tail);
+  addReversedEdges(rev, tail, edges, first + 1);
+}
+
+/*------------------------------------------------------------
+  Reversal: reverseNFA(N)
+  Builds an NFA for the reversed language of N by flipping
+  every edge and swapping the roles of start and accept:
+
+        p --a--> q      becomes      q' --a--> p'
+
+  Running it right-to-left over the input recovers where a
+  match starts once the forward automaton knows where it ends.
+  State i of N is state i of the reversal; extra ε-states are
+  appended where a state has too many incoming edges to flip.
+------------------------------------------------------------*/
+NFA reverseNFA(const NFA &nfa)
+{
+  NFA rev;
+  rev.states.resize(nfa.states.size());
+  rev.byteSets = nfa.byteSets;
+
+  // Incoming edges of every state: (label or -1 for ε, source)
+  std::vector<std::vector<std::pair<int, uint32_t>>> incoming(nfa.states.size());
+  for (uint32_t id = 0; id < nfa.states.size(); ++id)
+  {
+    const State &s = nfa.states[id];
+    if (s.target != NFA_NO_STATE)
+      incoming[s.target].push_back({static_cast<int>(s.label), id});
+    for (uint32_t eps : s.epsilon)
+    {
+      if (eps != NFA_NO_STATE)
+        incoming[eps].push_back({-1, id});
+    }
+  }
+
+  for (uint32_t id = 0; id < nfa.states.size(); ++id)
+  {
+    // Labeled edges first keep the common single-edge case inline
+    std::stable_partition(incoming[id].begin(), incoming[id].end(),
+                          [](const std::pair<int, uint32_t> &edge) { return edge.first >= 0; });
+    addReversedEdges(rev, id, incoming[id], 0);
+  }
+
+  rev.start = nfa.accept;
+  rev.accept = nfa.start;
+  return rev;
 }
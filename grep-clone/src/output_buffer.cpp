@@ -0,0 +1,95 @@
+#include "../include/regex/output_buffer.hpp"
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+constexpr std::string_view HIGHLIGHT_ON = "\033[1;33m\033[4m"; // bold yellow + underline
+constexpr std::string_view HIGHLIGHT_OFF = "\033[0m";
+
+/*------------------------------------------------------------
+  Helper: writeAll()
+  write(2) until every byte is out, retrying on EINTR and
+  short writes. Other errors (e.g. a closed pipe) drop the
+  remaining output.
+------------------------------------------------------------*/
+static void writeAll(int fd, const char *bytes, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t written = write(fd, bytes, size);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return;
+        }
+        bytes += written;
+        size -= static_cast<size_t>(written);
+    }
+}
+
+void initOutputBuffer(OutputBuffer &out, int fd)
+{
+    out.fd = fd;
+    out.highlight = isatty(fd);
+    out.data.resize(OUTPUT_BUFFER_BYTES);
+    out.used = 0;
+}
+
+void writeOutput(OutputBuffer &out, std::string_view text)
+{
+    if (text.size() > out.data.size() - out.used)
+    {
+        flushOutput(out);
+
+        // Too big to be worth copying
+        if (text.size() >= out.data.size())
+        {
+            writeAll(out.fd, text.data(), text.size());
+            return;
+        }
+    }
+    memcpy(out.data.data() + out.used, text.data(), text.size());
+    out.used += text.size();
+}
+
+void writeNumber(OutputBuffer &out, size_t value)
+{
+    char digits[20];
+    size_t count = 0;
+    do
+    {
+        digits[sizeof(digits) - ++count] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    writeOutput(out, std::string_view(digits + sizeof(digits) - count, count));
+}
+
+void writeHighlightedLine(OutputBuffer &out, std::string_view line,
+                          const std::vector<std::pair<size_t, size_t>> &matches)
+{
+    if (!out.highlight || matches.empty())
+    {
+        writeOutput(out, line);
+        writeOutput(out, "\n");
+        return;
+    }
+
+    size_t last = 0;
+    for (const auto &[start, end] : matches)
+    {
+        writeOutput(out, line.substr(last, start - last)); // text before the match
+        writeOutput(out, HIGHLIGHT_ON);
+        writeOutput(out, line.substr(start, end - start + 1));
+        writeOutput(out, HIGHLIGHT_OFF);
+        last = end + 1;
+    }
+    writeOutput(out, line.substr(last)); // remainder of the line
+    writeOutput(out, "\n");
+}
+
+void flushOutput(OutputBuffer &out)
+{
+    writeAll(out.fd, out.data.data(), out.used);
+    out.used = 0;
+}
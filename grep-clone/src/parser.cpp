@@ -1,23 +1,208 @@
 #include "../include/regex/parser.hpp"
+#include <cctype>
 #include <stdexcept>
 #include <stack>
 
+/*------------------------------------------------------------
+  Helper: shorthandClass()
+  The bytes of \d, \w or \s (and of \D, \W, \S, their
+  complements). Returns false for any other letter.
+------------------------------------------------------------*/
+static bool shorthandClass(char letter, ByteSet &bytes)
+{
+    bytes.reset();
+    switch (std::tolower(static_cast<unsigned char>(letter)))
+    {
+    case 'd':
+        for (int c = '0'; c <= '9'; ++c)
+            bytes.set(c);
+        break;
+    case 'w':
+        for (int c = 0; c < 256; ++c)
+        {
+            if (std::isalnum(c) || c == '_')
+                bytes.set(c);
+        }
+        break;
+    case 's':
+        for (char c : {' ', '\t', '\r', '\v', '\f'})
+            bytes.set(static_cast<unsigned char>(c));
+        break;
+    default:
+        return false;
+    }
+
+    if (std::isupper(static_cast<unsigned char>(letter)))
+    {
+        bytes.flip();
+        bytes.reset('\n');
+    }
+    return true;
+}
+
+/*------------------------------------------------------------
+  Helper: parseEscape()
+  Reads the escape starting at regex[i] == '\\' and advances i
+  past it. A single byte is returned through `byte` (for class
+  ranges); shorthands leave it at -1.
+------------------------------------------------------------*/
+static ByteSet parseEscape(const std::string &regex, size_t &i, int &byte)
+{
+    size_t at = i;
+    if (++i == regex.size())
+        throw std::invalid_argument("Trailing backslash at position: " + std::to_string(at));
+
+    char c = regex[i++];
+    ByteSet bytes;
+    byte = -1;
+    if (shorthandClass(c, bytes))
+        return bytes;
+
+    if (c == 't')
+        byte = '\t';
+    else if (std::isalnum(static_cast<unsigned char>(c)))
+        throw std::invalid_argument("Unknown escape \\" + std::string(1, c) + " at position: " + std::to_string(at));
+    else
+        byte = static_cast<unsigned char>(c);
+
+    bytes.set(byte);
+    return bytes;
+}
+
+/*------------------------------------------------------------
+  Helper: parseClass()
+  Reads a bracket expression starting at regex[i] == '[' and
+  advances i past its closing ']'. A ']' right after '[' or
+  '[^' is literal, as is a '-' first or last.
+------------------------------------------------------------*/
+static ByteSet parseClass(const std::string &regex, size_t &i)
+{
+    size_t at = i++;
+    bool negated = i < regex.size() && regex[i] == '^';
+    if (negated)
+        ++i;
+
+    ByteSet bytes;
+    bool first = true;
+    while (true)
+    {
+        if (i == regex.size())
+            throw std::invalid_argument("Unterminated character class at position: " + std::to_string(at));
+        if (regex[i] == ']' && !first)
+            break;
+        first = false;
+
+        int lo = -1;
+        if (regex[i] == '\\')
+            bytes |= parseEscape(regex, i, lo);
+        else
+            lo = static_cast<unsigned char>(regex[i++]);
+        if (lo < 0)
+            continue;
+
+        // A range lo-hi, unless the '-' is the last byte of the class
+        if (i + 1 < regex.size() && regex[i] == '-' && regex[i + 1] != ']')
+        {
+            ++i;
+            int hi = -1;
+            if (regex[i] == '\\')
+                parseEscape(regex, i, hi);
+            else
+                hi = static_cast<unsigned char>(regex[i++]);
+            if (hi < 0)
+                throw std::invalid_argument("Class shorthand used as a range bound at position: " + std::to_string(at));
+            if (hi < lo)
+                throw std::invalid_argument("Reversed range in character class at position: " + std::to_string(at));
+            for (int c = lo; c <= hi; ++c)
+                bytes.set(c);
+        }
+        else
+        {
+            bytes.set(lo);
+        }
+    }
+    ++i; // the closing ']'
+
+    if (negated)
+        bytes.flip();
+    bytes.reset('\n');
+    return bytes;
+}
+
+std::vector<RegexToken> tokenize(const std::string &regex)
+{
+    std::vector<RegexToken> tokens;
+    size_t i = 0;
+    while (i < regex.size())
+    {
+        size_t at = i;
+        char c = regex[i];
+        RegexToken token{TokenType::Bytes, {}, at};
+        switch (c)
+        {
+        case '(':
+            token.type = TokenType::LeftParen;
+            ++i;
+            break;
+        case ')':
+            token.type = TokenType::RightParen;
+            ++i;
+            break;
+        case '|':
+            token.type = TokenType::Union;
+            ++i;
+            break;
+        case '*':
+            token.type = TokenType::Star;
+            ++i;
+            break;
+        case '+':
+            token.type = TokenType::Plus;
+            ++i;
+            break;
+        case '?':
+            token.type = TokenType::Optional;
+            ++i;
+            break;
+        case '.':
+            token.bytes.set();
+            token.bytes.reset('\n');
+            ++i;
+            break;
+        case '[':
+            token.bytes = parseClass(regex, i);
+            break;
+        case '\\':
+        {
+            int byte;
+            token.bytes = parseEscape(regex, i, byte);
+            break;
+        }
+        default:
+            token.bytes.set(static_cast<unsigned char>(c));
+            ++i;
+            break;
+        }
+        tokens.push_back(token);
+    }
+    return tokens;
+}
+
 // Function definitions
-void checkMatchingParens(const std::string &regex)
+void checkMatchingParens(const std::vector<RegexToken> &tokens)
 {
-    std::stack<char> parens;
-    for (size_t i = 0; i < regex.size(); i++)
+    std::stack<size_t> parens;
+    for (const RegexToken &token : tokens)
     {
-        char token = regex[i];
-        if (token == '(')
+        if (token.type == TokenType::LeftParen)
         {
-            parens.push(token);
+            parens.push(token.position);
         }
-        else if (token == ')')
+        else if (token.type == TokenType::RightParen)
         {
-            if (parens.empty() || parens.top() != '(')
+            if (parens.empty())
             {
-                throw std::invalid_argument("Unmatched parenthesis at position: " + std::to_string(i));
+                throw std::invalid_argument("Unmatched parenthesis at position: " + std::to_string(token.position));
             }
             parens.pop();
         }
@@ -28,73 +213,75 @@ void checkMatchingParens(const std::string &regex)
     }
 }
 
-std::vector<char> addConcatenation(const std::string &regex)
+std::vector<RegexToken> addConcatenation(const std::string &regex)
 {
     if (regex.empty())
         throw std::invalid_argument("Regex string must not be empty");
-    checkMatchingParens(regex);
+    std::vector<RegexToken> tokens = tokenize(regex);
+    checkMatchingParens(tokens);
 
-    std::vector<char> processed;
-    for (size_t i = 0; i < regex.size(); ++i)
+    std::vector<RegexToken> processed;
+    for (size_t i = 0; i < tokens.size(); ++i)
     {
-        char curr = regex[i];
+        TokenType curr = tokens[i].type;
         if (i > 0)
         {
-            char prev = regex[i - 1];
-            bool prev_is_atom = (prev != '|' && prev != '(');
-            bool curr_is_atom = (curr != '|' && curr != ')' && curr != '*');
+            TokenType prev = tokens[i - 1].type;
+            bool prev_is_atom = (prev != TokenType::Union && prev != TokenType::LeftParen);
+            bool curr_is_atom = (curr == TokenType::Bytes || curr == TokenType::LeftParen);
             if (prev_is_atom && curr_is_atom)
             {
-                processed.push_back('.');
+                processed.push_back(RegexToken{TokenType::Concat, {}, tokens[i].position});
             }
         }
-        processed.push_back(curr);
+        processed.push_back(tokens[i]);
     }
     return processed;
 }
 
-OpInfo getOpInfo(char op)
+OpInfo getOpInfo(TokenType op)
 {
     switch (op)
     {
-    case '*':
+    case TokenType::Star:
+    case TokenType::Plus:
+    case TokenType::Optional:
         return {3, false};
-    case '.':
+    case TokenType::Concat:
         return {2, true};
-    case '|':
+    case TokenType::Union:
         return {1, true};
     default:
-        throw std::invalid_argument(
-            "Invalid operator: " + std::string(1, op) + " (valid: *, ., |)");
+        throw std::invalid_argument("Invalid operator (valid: *, +, ?, concatenation, |)");
     }
 }
 
-std::queue<char> getPostfix(const std::vector<char> &concatRegex)
+std::queue<RegexToken> getPostfix(const std::vector<RegexToken> &concatRegex)
 {
-    std::queue<char> output;
-    std::stack<char> ops;
+    std::queue<RegexToken> output;
+    std::stack<RegexToken> ops;
 
-    for (char token : concatRegex)
+    for (const RegexToken &token : concatRegex)
     {
-        if (token == '(')
+        if (token.type == TokenType::LeftParen)
         {
             ops.push(token);
         }
-        else if (token == ')')
+        else if (token.type == TokenType::RightParen)
         {
-            while (!ops.empty() && ops.top() != '(')
+            while (!ops.empty() && ops.top().type != TokenType::LeftParen)
             {
                 output.push(ops.top());
                 ops.pop();
             }
             ops.pop();
         }
-        else if (token == '|' || token == '*' || token == '.')
+        else if (token.type != TokenType::Bytes)
         {
-            OpInfo currOpInfo = getOpInfo(token);
-            while (!ops.empty() && ops.top() != '(')
+            OpInfo currOpInfo = getOpInfo(token.type);
+            while (!ops.empty() && ops.top().type != TokenType::LeftParen)
             {
-                OpInfo topOpInfo = getOpInfo(ops.top());
+                OpInfo topOpInfo = getOpInfo(ops.top().type);
                 if (topOpInfo.precedence > currOpInfo.precedence ||
                     (topOpInfo.precedence == currOpInfo.precedence && currOpInfo.isLeftAssociative))
                 {
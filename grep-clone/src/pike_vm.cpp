@@ -0,0 +1,187 @@
+#include "../include/regex/pike_vm.hpp"
+#include <algorithm>
+
+/*------------------------------------------------------------
+  Thread list: a sparse set over NFA states (Briggs & Torczon)
+  that also remembers where each thread's match started.
+  Membership tests, inserts and clearing are all O(1), and
+  threads are visited in insertion order, which is the order
+  of their start offsets.
+------------------------------------------------------------*/
+struct ThreadList
+{
+    std::vector<uint32_t> dense;  // states, in insertion order
+    std::vector<uint32_t> sparse; // state -> its slot in dense
+    std::vector<size_t> starts;   // start offset of the thread in each slot
+    uint32_t count = 0;
+
+    explicit ThreadList(size_t numStates) : dense(numStates), sparse(numStates), starts(numStates) {}
+
+    bool contains(uint32_t state) const { return sparse[state] < count && dense[sparse[state]] == state; }
+    void clear() { count = 0; }
+};
+
+/*------------------------------------------------------------
+  Helper: addThread()
+  Adds a state and everything reachable from it by ε-moves,
+  skipping states that already hold an (earlier) thread.
+------------------------------------------------------------*/
+static void addThread(const NFA &nfa, ThreadList &list, std::vector<uint32_t> &stack, uint32_t state, size_t start)
+{
+    stack.push_back(state);
+    while (!stack.empty())
+    {
+        uint32_t s = stack.back();
+        stack.pop_back();
+        if (list.contains(s))
+            continue;
+
+        list.sparse[s] = list.count;
+        list.dense[list.count] = s;
+        list.starts[list.count] = start;
+        list.count++;
+
+        for (uint32_t eps : nfa.states[s].epsilon)
+        {
+            if (eps != NFA_NO_STATE)
+                stack.push_back(eps);
+        }
+    }
+}
+
+/*------------------------------------------------------------
+  Helper: findMatch()
+  pikeFindMatch() on caller-provided thread lists, so that a
+  search for every match allocates them only once.
+------------------------------------------------------------*/
+static bool findMatch(const NFA &nfa, std::string_view input, size_t from, size_t &start, size_t &end,
+                      ThreadList &current, ThreadList &next, std::vector<uint32_t> &stack)
+{
+    current.clear();
+    bool found = false;
+
+    for (size_t j = from; j < input.size(); ++j)
+    {
+        // A new thread per offset, behind every thread that started earlier
+        if (!found)
+            addThread(nfa, current, stack, nfa.start, j);
+
+        next.clear();
+        for (uint32_t k = 0; k < current.count; ++k)
+        {
+            // Threads starting right of the match found so far cannot win
+            if (found && current.starts[k] > start)
+                continue;
+
+            const State &s = nfa.states[current.dense[k]];
+            if (s.target != NFA_NO_STATE && nfa.byteSets[s.label][static_cast<unsigned char>(input[j])])
+                addThread(nfa, next, stack, s.target, current.starts[k]);
+        }
+
+        if (next.contains(nfa.accept))
+        {
+            size_t matchStart = next.starts[next.sparse[nfa.accept]];
+            if (!found || matchStart < start || (matchStart == start && j > end))
+            {
+                start = matchStart;
+                end = j;
+                found = true;
+            }
+        }
+
+        std::swap(current, next);
+        if (found && current.count == 0)
+            break;
+    }
+    return found;
+}
+
+bool pikeFindMatch(const NFA &nfa, std::string_view input, size_t from, size_t &start, size_t &end)
+{
+    ThreadList current(nfa.states.size());
+    ThreadList next(nfa.states.size());
+    std::vector<uint32_t> stack;
+    return findMatch(nfa, input, from, start, end, current, next, stack);
+}
+
+std::vector<std::pair<size_t, size_t>> pikeFindAllMatches(const NFA &nfa, std::string_view input)
+{
+    ThreadList current(nfa.states.size());
+    ThreadList next(nfa.states.size());
+    std::vector<uint32_t> stack;
+
+    std::vector<std::pair<size_t, size_t>> matches;
+    size_t start = 0;
+    size_t end = 0;
+    for (size_t from = 0; from < input.size() && findMatch(nfa, input, from, start, end, current, next, stack);
+         from = end + 1)
+    {
+        matches.push_back({start, end});
+    }
+    return matches;
+}
+
+size_t pikeFirstMatchEnd(const NFA &nfa, std::string_view input, size_t from, size_t to)
+{
+    ThreadList current(nfa.states.size());
+    ThreadList next(nfa.states.size());
+    std::vector<uint32_t> stack;
+
+    for (size_t j = from; j < to; ++j)
+    {
+        addThread(nfa, current, stack, nfa.start, 0);
+
+        next.clear();
+        for (uint32_t k = 0; k < current.count; ++k)
+        {
+            const State &s = nfa.states[current.dense[k]];
+            if (s.target != NFA_NO_STATE && nfa.byteSets[s.label][static_cast<unsigned char>(input[j])])
+                addThread(nfa, next, stack, s.target, 0);
+        }
+
+        if (next.contains(nfa.accept))
+            return j;
+        std::swap(current, next);
+    }
+    return to;
+}
+
+std::vector<uint32_t> pikeMatchingPatterns(const NFA &nfa, std::string_view input)
+{
+    ThreadList current(nfa.states.size());
+    ThreadList next(nfa.states.size());
+    std::vector<uint32_t> stack;
+    std::vector<bool> seen(nfa.patternAccepts.size(), false);
+    size_t found = 0;
+
+    for (size_t j = 0; j < input.size() && found < seen.size(); ++j)
+    {
+        addThread(nfa, current, stack, nfa.start, 0);
+
+        next.clear();
+        for (uint32_t k = 0; k < current.count; ++k)
+        {
+            const State &s = nfa.states[current.dense[k]];
+            if (s.target != NFA_NO_STATE && nfa.byteSets[s.label][static_cast<unsigned char>(input[j])])
+                addThread(nfa, next, stack, s.target, 0);
+        }
+
+        for (uint32_t id = 0; id < seen.size(); ++id)
+        {
+            if (!seen[id] && next.contains(nfa.patternAccepts[id]))
+            {
+                seen[id] = true;
+                ++found;
+            }
+        }
+        std::swap(current, next);
+    }
+
+    std::vector<uint32_t> ids;
+    for (uint32_t id = 0; id < seen.size(); ++id)
+    {
+        if (seen[id])
+            ids.push_back(id);
+    }
+    return ids;
+}
@@ -0,0 +1,211 @@
+#include "../include/regex/prefilter.hpp"
+#include <cstdint>
+#include <cstring>
+#include <stack>
+#include <stdexcept>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+/*------------------------------------------------------------
+  Literal facts about one sub-expression of the postfix form:
+
+    exact    - the sub-expression matches only `text`
+    prefix   - every match starts with this string
+    suffix   - every match ends with this string
+    required - every match contains this string
+
+  They are combined bottom-up with the same stack discipline
+  buildNFA uses for Thompson's construction.
+------------------------------------------------------------*/
+struct LiteralFacts
+{
+    bool exact;
+    std::string text;
+    std::string prefix;
+    std::string suffix;
+    std::string required;
+};
+
+static const std::string &longest(const std::string &a, const std::string &b)
+{
+    return b.size() > a.size() ? b : a;
+}
+
+static std::string commonPrefix(const std::string &a, const std::string &b)
+{
+    size_t i = 0;
+    while (i < a.size() && i < b.size() && a[i] == b[i])
+        ++i;
+    return a.substr(0, i);
+}
+
+static std::string commonSuffix(const std::string &a, const std::string &b)
+{
+    size_t i = 0;
+    while (i < a.size() && i < b.size() && a[a.size() - 1 - i] == b[b.size() - 1 - i])
+        ++i;
+    return a.substr(a.size() - i);
+}
+
+RequiredLiteral extractRequiredLiteral(std::queue<RegexToken> postfix)
+{
+    std::stack<LiteralFacts> stack;
+
+    while (!postfix.empty())
+    {
+        RegexToken token = postfix.front();
+        postfix.pop();
+
+        if (token.type == TokenType::Star || token.type == TokenType::Optional)
+        {
+            if (stack.empty())
+                throw std::runtime_error("Invalid postfix: repetition operator with empty stack");
+
+            // Zero repetitions are allowed, so nothing is guaranteed
+            stack.top() = LiteralFacts{false, "", "", "", ""};
+        }
+        else if (token.type == TokenType::Plus)
+        {
+            if (stack.empty())
+                throw std::runtime_error("Invalid postfix: '+' with empty stack");
+
+            // At least one repetition: its prefix, suffix and required
+            // literal still hold, but the whole is no longer one string
+            stack.top().exact = false;
+            stack.top().text.clear();
+        }
+        else if (token.type == TokenType::Concat || token.type == TokenType::Union)
+        {
+            if (stack.size() < 2)
+                throw std::runtime_error("Invalid postfix: binary operator requires two operands");
+
+            LiteralFacts right = std::move(stack.top());
+            stack.pop();
+            LiteralFacts left = std::move(stack.top());
+            stack.pop();
+
+            LiteralFacts res;
+            if (token.type == TokenType::Concat)
+            {
+                res.exact = left.exact && right.exact;
+                res.text = left.text + right.text;
+                res.prefix = left.exact ? left.text + right.prefix : left.prefix;
+                res.suffix = right.exact ? left.suffix + right.text : right.suffix;
+                res.required = longest(longest(left.required, right.required), left.suffix + right.prefix);
+            }
+            else
+            {
+                res.exact = left.exact && right.exact && left.text == right.text;
+                res.text = res.exact ? left.text : "";
+                res.prefix = commonPrefix(left.prefix, right.prefix);
+                res.suffix = commonSuffix(left.suffix, right.suffix);
+                res.required = left.required == right.required ? left.required : longest(res.prefix, res.suffix);
+            }
+
+            if (res.exact)
+                res.required = res.text;
+            stack.push(std::move(res));
+        }
+        else if (token.bytes.count() == 1)
+        {
+            // A single byte is a one-character literal
+            int byte = 0;
+            while (!token.bytes[byte])
+                ++byte;
+            std::string symbol(1, static_cast<char>(byte));
+            stack.push(LiteralFacts{true, symbol, symbol, symbol, symbol});
+        }
+        else
+        {
+            // A class or '.': no literal, and it breaks any literal around it
+            stack.push(LiteralFacts{false, "", "", "", ""});
+        }
+    }
+
+    if (stack.size() != 1)
+        throw std::runtime_error("Invalid postfix: leftover operands on stack");
+
+    return RequiredLiteral{stack.top().required, stack.top().exact};
+}
+
+/*------------------------------------------------------------
+  Vectorized substring search (first/last byte filter):
+  compare a block of candidate start positions against the
+  needle's first byte, and the block needle.size() - 1 bytes
+  further on against its last byte. Only positions where
+  both agree are confirmed with memcmp.
+------------------------------------------------------------*/
+size_t findLiteral(std::string_view haystack, std::string_view needle, size_t from)
+{
+    const size_t n = haystack.size();
+    const size_t m = needle.size();
+    if (m == 0)
+        return from <= n ? from : std::string_view::npos;
+    if (from >= n || n - from < m)
+        return std::string_view::npos;
+
+    const char *hay = haystack.data();
+    const char *pat = needle.data();
+
+    if (m == 1)
+    {
+        const void *hit = memchr(hay + from, pat[0], n - from);
+        return hit ? static_cast<const char *>(hit) - hay : std::string_view::npos;
+    }
+
+    const size_t last = n - m; // last valid start position
+    size_t i = from;
+
+#if defined(__AVX2__)
+    const __m256i first32 = _mm256_set1_epi8(pat[0]);
+    const __m256i last32 = _mm256_set1_epi8(pat[m - 1]);
+    for (; i + 32 <= last + 1; i += 32)
+    {
+        __m256i blockFirst = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(hay + i));
+        __m256i blockLast = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(hay + i + m - 1));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(blockFirst, first32), _mm256_cmpeq_epi8(blockLast, last32))));
+        while (mask)
+        {
+            size_t candidate = i + __builtin_ctz(mask);
+            if (memcmp(hay + candidate + 1, pat + 1, m - 2) == 0)
+                return candidate;
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+#if defined(__SSE2__)
+    const __m128i first16 = _mm_set1_epi8(pat[0]);
+    const __m128i last16 = _mm_set1_epi8(pat[m - 1]);
+    for (; i + 16 <= last + 1; i += 16)
+    {
+        __m128i blockFirst = _mm_loadu_si128(reinterpret_cast<const __m128i *>(hay + i));
+        __m128i blockLast = _mm_loadu_si128(reinterpret_cast<const __m128i *>(hay + i + m - 1));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(blockFirst, first16), _mm_cmpeq_epi8(blockLast, last16))));
+        while (mask)
+        {
+            size_t candidate = i + __builtin_ctz(mask);
+            if (memcmp(hay + candidate + 1, pat + 1, m - 2) == 0)
+                return candidate;
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    // Scalar tail (and the whole search on targets without SSE2)
+    while (i <= last)
+    {
+        const void *hit = memchr(hay + i, pat[0], last - i + 1);
+        if (!hit)
+            break;
+        i = static_cast<const char *>(hit) - hay;
+        if (memcmp(hay + i + 1, pat + 1, m - 1) == 0)
+            return i;
+        ++i;
+    }
+    return std::string_view::npos;
+}
@@ -0,0 +1,302 @@
+#include "../include/regex/regex_cache.hpp"
+#include "../include/regex/mapped_file.hpp"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string_view>
+#include <fstream>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+constexpr char CACHE_MAGIC[8] = {'G', 'R', 'E', 'P', 'C', 'D', 'F', 'A'};
+
+// Written as a native integer: reads back differently on a machine of the
+// other byte order, which then rejects the file
+constexpr uint32_t CACHE_BYTE_ORDER = 0x01020304;
+
+// Every section starts on a cache line; mappings are page aligned, so the
+// tables are as aligned in the file as they would be in memory
+constexpr size_t CACHE_SECTION_ALIGN = 64;
+
+struct CacheSection
+{
+    uint64_t offset; // from the start of the file
+    uint64_t count;  // in elements
+};
+
+struct CacheAutomaton
+{
+    uint32_t start;
+    uint32_t numStates;
+    ByteClasses classes;
+    CacheSection table;
+    CacheSection acceptBits;
+    CacheSection matchOffsets;
+    CacheSection matchPatterns;
+};
+
+struct CacheHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint64_t fileSize;
+
+    CacheSection patterns; // the pattern set, joined with '\n' (never part of a pattern)
+    uint64_t patternCount;
+    uint32_t minimize;
+    uint32_t ahoCorasick;
+
+    CacheSection literal;
+    uint32_t literalExact;
+    uint32_t reserved;
+
+    uint64_t dfaStates;
+    uint64_t minimizedStates;
+
+    CacheAutomaton automata[3]; // forward, unanchored, reverse
+};
+
+static std::string joinPatterns(const std::vector<std::string> &patterns)
+{
+    std::string joined;
+    for (const std::string &pattern : patterns)
+    {
+        if (!joined.empty())
+            joined += '\n';
+        joined += pattern;
+    }
+    return joined;
+}
+
+std::string regexCacheKey(const std::vector<std::string> &patterns, const CompileOptions &options)
+{
+    uint64_t hash = 14695981039346656037ull; // FNV-1a
+    auto mix = [&](unsigned char byte)
+    {
+        hash ^= byte;
+        hash *= 1099511628211ull;
+    };
+
+    for (char c : joinPatterns(patterns))
+    {
+        mix(static_cast<unsigned char>(c));
+    }
+    mix(options.minimize ? 1 : 0);
+    mix(static_cast<unsigned char>(REGEX_CACHE_VERSION));
+
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.dfa", static_cast<unsigned long long>(hash));
+    return name;
+}
+
+/*------------------------------------------------------------
+  Helper: appendSection()
+  Pads the image to the next section boundary, then appends
+  an array and returns where it went.
+------------------------------------------------------------*/
+template <typename T>
+static CacheSection appendSection(std::string &image, const T *data, size_t count)
+{
+    image.resize((image.size() + CACHE_SECTION_ALIGN - 1) / CACHE_SECTION_ALIGN * CACHE_SECTION_ALIGN, '\0');
+    CacheSection section{image.size(), count};
+    image.append(reinterpret_cast<const char *>(data), count * sizeof(T));
+    return section;
+}
+
+bool saveCompiledRegex(const CompiledRegex &compiled, const std::vector<std::string> &patterns,
+                       const CompileOptions &options, const std::string &path)
+{
+    if (compiled.engine != MatchEngine::DFA || compiled.lazy || compiled.unanchored.numStates == 0)
+        return false;
+
+    CacheHeader header{};
+    memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version = REGEX_CACHE_VERSION;
+    header.byteOrder = CACHE_BYTE_ORDER;
+    header.patternCount = patterns.size();
+    header.minimize = options.minimize;
+    header.ahoCorasick = compiled.stats.ahoCorasick;
+    header.literalExact = compiled.literal.exact;
+    header.dfaStates = compiled.stats.dfaStates;
+    header.minimizedStates = compiled.stats.minimizedStates;
+
+    std::string image(sizeof(CacheHeader), '\0');
+    std::string joined = joinPatterns(patterns);
+    header.patterns = appendSection(image, joined.data(), joined.size());
+    header.literal = appendSection(image, compiled.literal.text.data(), compiled.literal.text.size());
+
+    const FlatDFA *automata[3] = {&compiled.forward, &compiled.unanchored, &compiled.reverse};
+    for (int i = 0; i < 3; ++i)
+    {
+        const FlatDFA &dfa = *automata[i];
+        CacheAutomaton &out = header.automata[i];
+        out.start = dfa.start;
+        out.numStates = dfa.numStates;
+        out.classes = dfa.classes;
+        out.table = appendSection(image, dfa.table.data(), dfa.table.size());
+        out.acceptBits = appendSection(image, dfa.acceptBits.data(), dfa.acceptBits.size());
+        out.matchOffsets = appendSection(image, dfa.matchOffsets.data(), dfa.matchOffsets.size());
+        out.matchPatterns = appendSection(image, dfa.matchPatterns.data(), dfa.matchPatterns.size());
+    }
+    header.fileSize = image.size();
+    memcpy(&image[0], &header, sizeof(header));
+
+    // Concurrent writers each use their own temporary file; whichever
+    // rename lands last wins, and readers only ever see complete files
+    std::string temporary = path + ".tmp" + std::to_string(getpid());
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        if (!out.write(image.data(), static_cast<std::streamsize>(image.size())))
+        {
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0)
+    {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+/*------------------------------------------------------------
+  Helper: sectionView()
+  A FrozenArray over a section of the mapped file, after
+  checking that the section lies inside the file and is
+  aligned for T.
+------------------------------------------------------------*/
+template <typename T>
+static bool sectionView(const MappedFile &file, const CacheSection &section, FrozenArray<T> &view)
+{
+    if (section.offset % alignof(T) != 0 || section.offset > file.size ||
+        section.count > (file.size - section.offset) / sizeof(T))
+        return false;
+
+    view = FrozenArray<T>::view(reinterpret_cast<const T *>(file.data + section.offset), section.count);
+    return true;
+}
+
+static bool loadAutomaton(const MappedFile &file, const CacheAutomaton &stored, uint64_t patternCount, FlatDFA &dfa)
+{
+    if (stored.numStates == 0 || stored.start >= stored.numStates)
+        return false;
+    const ByteClasses &classes = stored.classes;
+    if (classes.count == 0 || classes.count > 256 || classes.strideBits > 8 ||
+        (1u << classes.strideBits) < classes.count)
+        return false;
+    for (uint8_t c : classes.classOf)
+    {
+        if (c >= classes.count)
+            return false;
+    }
+
+    if (stored.table.count != static_cast<uint64_t>(stored.numStates) << classes.strideBits ||
+        stored.acceptBits.count != (stored.numStates + 63) / 64)
+        return false;
+    if (stored.matchOffsets.count != 0 && stored.matchOffsets.count != stored.numStates + 1ull)
+        return false;
+
+    dfa.start = stored.start;
+    dfa.numStates = stored.numStates;
+    dfa.classes = classes;
+    if (!sectionView(file, stored.table, dfa.table) || !sectionView(file, stored.acceptBits, dfa.acceptBits) ||
+        !sectionView(file, stored.matchOffsets, dfa.matchOffsets) ||
+        !sectionView(file, stored.matchPatterns, dfa.matchPatterns))
+        return false;
+
+    // The matchers index with these values unchecked, so one bad cell in the
+    // file would otherwise be an out-of-bounds read while scanning
+    for (uint32_t next : dfa.table)
+    {
+        if (next >= stored.numStates)
+            return false;
+    }
+    if (dfa.matchOffsets.empty())
+        return dfa.matchPatterns.empty();
+    if (dfa.matchOffsets[0] != 0 || dfa.matchOffsets[stored.numStates] != dfa.matchPatterns.size())
+        return false;
+    for (uint32_t state = 0; state < stored.numStates; ++state)
+    {
+        if (dfa.matchOffsets[state] > dfa.matchOffsets[state + 1])
+            return false;
+    }
+    for (uint32_t id : dfa.matchPatterns)
+    {
+        if (id >= patternCount)
+            return false;
+    }
+    return true;
+}
+
+bool loadCompiledRegex(const std::string &path, const std::vector<std::string> &patterns,
+                       const CompileOptions &options, CompiledRegex &compiled)
+{
+    std::shared_ptr<MappedFile> file(new MappedFile, [](MappedFile *mapped)
+    {
+        closeMappedFile(*mapped);
+        delete mapped;
+    });
+    if (!openMappedFile(path, *file) || file->size < sizeof(CacheHeader))
+        return false;
+
+    CacheHeader header;
+    memcpy(&header, file->data, sizeof(header));
+    if (memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || header.version != REGEX_CACHE_VERSION ||
+        header.byteOrder != CACHE_BYTE_ORDER || header.fileSize != file->size)
+        return false;
+
+    if (header.patternCount != patterns.size() || header.minimize != static_cast<uint32_t>(options.minimize))
+        return false;
+
+    FrozenArray<char> storedPatterns;
+    FrozenArray<char> literal;
+    if (!sectionView(*file, header.patterns, storedPatterns) || !sectionView(*file, header.literal, literal))
+        return false;
+    if (std::string_view(storedPatterns.data(), storedPatterns.size()) != joinPatterns(patterns))
+        return false;
+
+    CompiledRegex loaded;
+    FlatDFA *automata[3] = {&loaded.forward, &loaded.unanchored, &loaded.reverse};
+    for (int i = 0; i < 3; ++i)
+    {
+        if (!loadAutomaton(*file, header.automata[i], header.patternCount, *automata[i]))
+            return false;
+    }
+
+    loaded.literal.text.assign(literal.data(), literal.size());
+    loaded.literal.exact = header.literalExact != 0;
+    loaded.patternCount = patterns.size();
+    loaded.stats.dfaStates = header.dfaStates;
+    loaded.stats.minimizedStates = header.minimizedStates;
+    loaded.stats.ahoCorasick = header.ahoCorasick != 0;
+    loaded.cacheFile = std::move(file);
+    compiled = std::move(loaded);
+    return true;
+}
+
+CompiledRegex compileCached(const std::vector<std::string> &patterns, const CompileOptions &options,
+                            const std::string &cacheDir, bool *hit)
+{
+    if (hit)
+        *hit = false;
+
+    std::error_code error;
+    fs::create_directories(cacheDir, error);
+    std::string path = (fs::path(cacheDir) / regexCacheKey(patterns, options)).string();
+
+    CompiledRegex compiled;
+    bool mayUseDFA = options.engine == MatchEngine::DFA || options.engine == MatchEngine::Auto;
+    if (mayUseDFA && loadCompiledRegex(path, patterns, options, compiled))
+    {
+        if (hit)
+            *hit = true;
+        return compiled;
+    }
+
+    compiled = compileDFA(patterns, options);
+    saveCompiledRegex(compiled, patterns, options, path);
+    return compiled;
+}
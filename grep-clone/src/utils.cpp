@@ -1,22 +1,6 @@
 #include "../include/regex/utils.hpp"
 
-std::set<char> extractSymbolsFromRegex(const std::string &regex)
-{
-    std::set<char> symbols;
-
-    for (char token : regex)
-    {
-        // Skip regex operators
-        if (token != '*' && token != '|' && token != '(' && token != ')' && token != '.')
-        {
-            symbols.insert(token);
-        }
-    }
-
-    return symbols;
-}
-
-void printHighlightedLine(const std::string &line, const std::vector<std::pair<size_t, size_t>> &matches)
+void printHighlightedLine(std::string_view line, const std::vector<std::pair<size_t, size_t>> &matches)
 {
     if (matches.empty())
     {
@@ -0,0 +1,83 @@
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+#include "regex/matcher.hpp"
+
+/*
+  Matcher tests: findAllMatches() on every engine, including lines whose
+  matches are short but whose anchored walks could run to the end of the
+  line (the test's timeout catches a search that goes quadratic again).
+*/
+
+static int failures = 0;
+
+#define CHECK(condition) check((condition), #condition, __FILE__, __LINE__)
+
+static void check(bool ok, const char *what, const char *file, int line)
+{
+    if (ok)
+        return;
+    std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, what);
+    ++failures;
+}
+
+// findAllMatches() of pattern on input, compiled for engine
+static std::vector<std::pair<size_t, size_t>> allMatches(const std::string &pattern, const std::string &input,
+                                                         MatchEngine engine)
+{
+    CompiledRegex compiled = compileDFA(pattern, {true, engine});
+    std::vector<std::pair<size_t, size_t>> matches = findAllMatches(compiled, input);
+    freeRegex(compiled);
+    return matches;
+}
+
+// Every byte of the line is a one-byte match
+static bool singleByteMatches(const std::vector<std::pair<size_t, size_t>> &matches, size_t length)
+{
+    if (matches.size() != length)
+        return false;
+    for (size_t i = 0; i < length; ++i)
+    {
+        if (matches[i].first != i || matches[i].second != i)
+            return false;
+    }
+    return true;
+}
+
+static void testLeftmostLongest()
+{
+    using Matches = std::vector<std::pair<size_t, size_t>>;
+    for (MatchEngine engine : {MatchEngine::Auto, MatchEngine::DFA, MatchEngine::PikeVM})
+    {
+        CHECK(allMatches("a|a*b", "aaab", engine) == (Matches{{0, 3}}));
+        CHECK(allMatches("a|a*b", "aaaa", engine) == (Matches{{0, 0}, {1, 1}, {2, 2}, {3, 3}}));
+        CHECK(allMatches("ab|b+", "abbb ab", engine) == (Matches{{0, 1}, {2, 3}, {5, 6}}));
+        CHECK(allMatches("x", "abc", engine).empty());
+    }
+}
+
+static void testLongLine()
+{
+    const std::string line(200000, 'a');
+    CHECK(singleByteMatches(allMatches("a|a*b", line, MatchEngine::Auto), line.size()));
+    CHECK(singleByteMatches(allMatches("a|a*b", line, MatchEngine::DFA), line.size()));
+    CHECK(singleByteMatches(allMatches("a|(aa)*b", line, MatchEngine::DFA), line.size()));
+
+    // Too many states to build eagerly: the lazy DFA
+    const std::string blowup = "a|(a|b)*a(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)c";
+    CompiledRegex compiled = compileDFA(blowup, {true, MatchEngine::DFA});
+    CHECK(compiled.lazy);
+    CHECK(singleByteMatches(findAllMatches(compiled, line), line.size()));
+    freeRegex(compiled);
+}
+
+int main()
+{
+    testLeftmostLongest();
+    testLongLine();
+
+    if (failures)
+        std::fprintf(stderr, "%d checks failed\n", failures);
+    return failures ? 1 : 0;
+}